@@ -2,6 +2,7 @@
 
 #include "bootrom.hpp"
 #include "cartridge.hpp"
+#include "cartridge_info.hpp"
 #include "emulator.hpp"
 #include "ppu.hpp"
 #include "memorymap.hpp"
@@ -13,17 +14,42 @@
 #include "joypad.hpp"
 
 #include "spdlog/spdlog.h"
+#include <cassert>
 #include <cstdint>
 
 
-AddressBus::AddressBus(Emulator* emulator) : m_emulator(emulator), m_logger(spdlog::get("")) {}
+AddressBus::AddressBus(Emulator* emulator) :
+        m_emulator(emulator),
+        m_logger(emulator->get_logger()),
+        m_use_mapped_banks(emulator->get_options().use_mapped_banks) {}
+
+void AddressBus::set_cartridge_banks(const MappedBanks& banks) {
+    m_cartridge_banks = &banks;
+}
 
 uint8_t AddressBus::read_byte(uint16_t address) const {
     if (m_emulator->is_booting() && memmap::is_in(address, memmap::BootRom)) {
         return m_emulator->get_boot_rom()->read_byte(address);
     }
-    if (memmap::is_in(address, memmap::CartridgeRom)
-        || memmap::is_in(address, memmap::CartridgeRam)) {
+    if (!m_use_mapped_banks
+        && (memmap::is_in(address, memmap::CartridgeRom)
+            || memmap::is_in(address, memmap::CartridgeRam))) {
+        return m_emulator->get_cartridge()->read_byte(address);
+    }
+    if (memmap::is_in(address, memmap::CartridgeRomFixedBank)) {
+        assert(m_cartridge_banks != nullptr && "Read from cartridge before loading a game");
+        return m_cartridge_banks->rom_fixed[address];
+    }
+    if (memmap::is_in(address, memmap::CartridgeRomBankSwitchable)) {
+        assert(m_cartridge_banks != nullptr && "Read from cartridge before loading a game");
+        return m_cartridge_banks
+            ->rom_switchable[address - memmap::CartridgeRomBankSwitchableBegin];
+    }
+    if (memmap::is_in(address, memmap::CartridgeRam)) {
+        // Disabled RAM and RTC registers are handled by the MBC
+        if (m_cartridge_banks->ram != nullptr) {
+            return m_cartridge_banks->ram[address - memmap::CartridgeRamBegin];
+        }
         return m_emulator->get_cartridge()->read_byte(address);
     }
     if (memmap::is_in(address, memmap::InternalRam) || memmap::is_in(address, memmap::HighRam)) {
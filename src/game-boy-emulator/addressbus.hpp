@@ -1,6 +1,7 @@
 #pragma once
 
 class Emulator;
+struct MappedBanks;
 #include "spdlog/fwd.h"
 #include <cstdint>
 #include <memory>
@@ -12,10 +13,19 @@ class Emulator;
 class AddressBus {
     Emulator* m_emulator;
     std::shared_ptr<spdlog::logger> m_logger;
+    // Banks of the loaded cartridge, ROM reads use them directly instead of calling the MBC.
+    const MappedBanks* m_cartridge_banks = nullptr;
+    // Otherwise all cartridge reads go through the MBC
+    bool m_use_mapped_banks;
 
 public:
     explicit AddressBus(Emulator* emulator);
 
+    /**
+     * Set the banks of the cartridge, which have to stay valid until a new cartridge is set.
+     */
+    void set_cartridge_banks(const MappedBanks& banks);
+
     /**
      * Read memory value from address.
      */
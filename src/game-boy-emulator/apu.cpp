@@ -2,8 +2,12 @@
 #include "memorymap.hpp"
 #include "bitmanipulation.hpp"
 #include "emulator.hpp"
+#include "savestate.hpp"
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
+#include <limits>
+
 
 namespace {
 const uint16_t NR52_ADDRESS = 0xFF26;
@@ -18,11 +22,22 @@ const uint16_t NR21_ADDRESS = 0xFF16;
 const uint16_t NR22_ADDRESS = 0xFF17;
 const uint16_t NR23_ADDRESS = 0xFF18;
 const uint16_t NR24_ADDRESS = 0xFF19;
+const uint16_t NR30_ADDRESS = 0xFF1A;
+const uint16_t NR31_ADDRESS = 0xFF1B;
+const uint16_t NR32_ADDRESS = 0xFF1C;
+const uint16_t NR33_ADDRESS = 0xFF1D;
+const uint16_t NR34_ADDRESS = 0xFF1E;
+const uint16_t NR41_ADDRESS = 0xFF20;
+const uint16_t NR42_ADDRESS = 0xFF21;
+const uint16_t NR43_ADDRESS = 0xFF22;
+const uint16_t NR44_ADDRESS = 0xFF23;
 } // namespace
 
-// Frame sequencer ticks every 8192 T cycle
 Apu::Apu(Emulator* emulator) :
-        m_logger(spdlog::get("")), m_frame_sequencer_timer(2048), m_emulator(emulator) {}
+        m_logger(emulator->get_logger()),
+        m_channel3(m_register_block2),
+        m_lazy_channels(emulator->get_options().lazy_audio_channels),
+        m_emulator(emulator) {}
 
 uint8_t Apu::read_byte(uint16_t address) {
     if (memmap::is_in(address, memmap::Apu)) {
@@ -48,6 +63,24 @@ uint8_t Apu::read_byte(uint16_t address) {
             return m_channel1.read_nrx3();
         case NR14_ADDRESS:
             return m_channel1.read_nrx4();
+        case NR30_ADDRESS:
+            return m_channel3.read_nrx0();
+        case NR31_ADDRESS:
+            return m_channel3.read_nrx1();
+        case NR32_ADDRESS:
+            return m_channel3.read_nrx2();
+        case NR33_ADDRESS:
+            return m_channel3.read_nrx3();
+        case NR34_ADDRESS:
+            return m_channel3.read_nrx4();
+        case NR41_ADDRESS:
+            return m_channel4.read_nrx1();
+        case NR42_ADDRESS:
+            return m_channel4.read_nrx2();
+        case NR43_ADDRESS:
+            return m_channel4.read_nrx3();
+        case NR44_ADDRESS:
+            return m_channel4.read_nrx4();
         default:
             return m_register_block1[address - memmap::ApuBegin];
         }
@@ -60,6 +93,8 @@ uint8_t Apu::read_byte(uint16_t address) {
 }
 
 void Apu::write_byte(uint16_t address, uint8_t value) {
+    // The previous register values apply to all cycles elapsed before the write.
+    generate_samples();
     if (memmap::is_in(address, memmap::Apu)) {
         m_logger->trace("APU write {:04X} value {:02X}", address, value);
         switch (address) {
@@ -102,78 +137,120 @@ void Apu::write_byte(uint16_t address, uint8_t value) {
         case NR24_ADDRESS:
             m_channel2.set_nrx4(value);
             break;
-        default:
-            m_logger->info("APU: Unhandled write at {:04X}", address);
-            m_register_block1.at(address - memmap::ApuBegin) = value;
+        case NR30_ADDRESS:
+            m_channel3.set_nrx0(value);
             break;
-        }
-    } else if (memmap::is_in(address, memmap::WavePattern)) {
-        m_register_block2[address - memmap::WavePatternBegin] = value;
-    }
-    m_logger->debug("APU: Unhandled write at {:04X}", address);
-}
-
-void Apu::cycle_elapsed_callback(size_t cycle_count_m) {
-    // TODO Use DIV-APU as a clock source
-    (void)cycle_count_m;
-    if (m_frame_sequencer_timer.tick()) {
-        // Frame sequencer stepping:
-        // Step   Length Ctr  Vol Env     Sweep
-        //---------------------------------------
-        // 0      Clock       -           -
-        // 1      -           -           -
-        // 2      Clock       -           Clock
-        // 3      -           -           -
-        // 4      Clock       -           -
-        // 5      -           -           -
-        // 6      Clock       -           Clock
-        // 7      -           Clock       -
-        //---------------------------------------
-        // Rate   256 Hz      64 Hz       128 Hz
-        auto frame_sequencer_step = m_frame_sequencer_timer.get_trigger_count() % 8;
-        switch (frame_sequencer_step) {
-        case 0:
-            m_channel1.do_sound_length();
-            m_channel2.do_sound_length();
+        case NR31_ADDRESS:
+            m_channel3.set_nrx1(value);
             break;
-        case 1:
+        case NR32_ADDRESS:
+            m_channel3.set_nrx2(value);
             break;
-        case 2:
-            m_channel1.do_sound_length();
-            m_channel2.do_sound_length();
-            // Only channel 1 has the frequency/wavelength sweep ability (not channel 2).
-            m_channel1.do_frequency_sweep();
+        case NR33_ADDRESS:
+            m_channel3.set_nrx3(value);
             break;
-        case 3:
+        case NR34_ADDRESS:
+            m_channel3.set_nrx4(value);
             break;
-        case 4:
-            m_channel1.do_sound_length();
-            m_channel2.do_sound_length();
+        case NR41_ADDRESS:
+            m_channel4.set_nrx1(value);
             break;
-        case 5:
+        case NR42_ADDRESS:
+            m_channel4.set_nrx2(value);
             break;
-        case 6:
-            m_channel1.do_sound_length();
-            m_channel2.do_sound_length();
-            m_channel1.do_frequency_sweep();
+        case NR43_ADDRESS:
+            m_channel4.set_nrx3(value);
             break;
-        case 7:
-            m_channel1.do_envelope_sweep();
-            m_channel2.do_envelope_sweep();
+        case NR44_ADDRESS:
+            m_channel4.set_nrx4(value);
             break;
         default:
-            assert(false && "There must be an error since this should be unreachable");
+            m_logger->info("APU: Unhandled write at {:04X}", address);
+            m_register_block1.at(address - memmap::ApuBegin) = value;
             break;
         }
+    } else if (memmap::is_in(address, memmap::WavePattern)) {
+        m_register_block2[address - memmap::WavePatternBegin] = value;
     }
-    m_channel1.tick_wave();
-    m_channel2.tick_wave();
+    m_logger->debug("APU: Unhandled write at {:04X}", address);
+}
+
+void Apu::cycle_elapsed_callback(size_t cycle_count_m) {
+    // The channels catch up lazily and the frame sequencer is stepped by the timer, so only the
+    // time base has to be updated here.
+    m_cycle_count_m = cycle_count_m;
+    if (!m_lazy_channels) {
+        generate_samples();
+    }
+}
+
+void Apu::div_apu_callback() {
+    // Length, sweep and envelope change the channel state, so the waveforms and samples have to be
+    // brought up to date before.
+    generate_samples();
+    // Frame sequencer stepping:
+    // Step   Length Ctr  Vol Env     Sweep
+    //---------------------------------------
+    // 0      Clock       -           -
+    // 1      -           -           -
+    // 2      Clock       -           Clock
+    // 3      -           -           -
+    // 4      Clock       -           -
+    // 5      -           -           -
+    // 6      Clock       -           Clock
+    // 7      -           Clock       -
+    //---------------------------------------
+    // Rate   256 Hz      64 Hz       128 Hz
+    switch (m_frame_sequencer_step) {
+    case 0:
+        m_channel1.do_sound_length();
+        m_channel2.do_sound_length();
+        m_channel3.do_sound_length();
+        m_channel4.do_sound_length();
+        break;
+    case 1:
+        break;
+    case 2:
+        m_channel1.do_sound_length();
+        m_channel2.do_sound_length();
+        m_channel3.do_sound_length();
+        m_channel4.do_sound_length();
+        // Only channel 1 has the frequency/wavelength sweep ability (not channel 2).
+        m_channel1.do_frequency_sweep();
+        break;
+    case 3:
+        break;
+    case 4:
+        m_channel1.do_sound_length();
+        m_channel2.do_sound_length();
+        m_channel3.do_sound_length();
+        m_channel4.do_sound_length();
+        break;
+    case 5:
+        break;
+    case 6:
+        m_channel1.do_sound_length();
+        m_channel2.do_sound_length();
+        m_channel3.do_sound_length();
+        m_channel4.do_sound_length();
+        m_channel1.do_frequency_sweep();
+        break;
+    case 7:
+        m_channel1.do_envelope_sweep();
+        m_channel2.do_envelope_sweep();
+        m_channel4.do_envelope_sweep();
+        break;
+    default:
+        assert(false && "There must be an error since this should be unreachable");
+        break;
+    }
+    m_frame_sequencer_step = (m_frame_sequencer_step + 1) % 8;
 }
 
 
 namespace {
 
-float high_pass_impl(float& capacitor, float in, bool dacs_enabled) {
+float high_pass(float& capacitor, float in, bool dacs_enabled) {
     float out = 0.;
     if (dacs_enabled) {
         out = in - capacitor;
@@ -183,22 +260,6 @@ float high_pass_impl(float& capacitor, float in, bool dacs_enabled) {
     return out;
 }
 
-float high_pass_left(float in, bool dacs_enabled) {
-    static float capacitor = 0;
-    return high_pass_impl(capacitor, in, dacs_enabled);
-}
-
-float high_pass_right(float in, bool dacs_enabled) {
-    static float capacitor = 0;
-    return high_pass_impl(capacitor, in, dacs_enabled);
-}
-
-SampleFrame high_pass(SampleFrame in) {
-    in.left = high_pass_left(in.left, true);
-    in.right = high_pass_right(in.right, true);
-    return in;
-}
-
 const int CH4_LEFT = 7;
 const int CH3_LEFT = 6;
 const int CH2_LEFT = 5;
@@ -210,11 +271,60 @@ const int CH1_RIGHT = 0;
 
 } // namespace
 
-SampleFrame Apu::get_sample() {
-    if (!m_apu_enabled) {
-        return {};
+std::span<const SampleFrame> Apu::get_samples() {
+    generate_samples();
+    return m_samples;
+}
+
+void Apu::clear_samples() {
+    m_samples.clear();
+}
+
+void Apu::generate_samples() {
+    if (m_cycle_count_m < m_sampled_cycle_m) {
+        // Cycle count was reset (new game loaded), resynchronise.
+        m_sampled_cycle_m = m_cycle_count_m;
     }
+    if (!m_emulator->get_options().sound_enabled) {
+        m_sampled_cycle_m = m_cycle_count_m;
+        catch_up_channels(get_cycle_count_t());
+        return;
+    }
+    while (m_sampled_cycle_m < m_cycle_count_m) {
+        catch_up_channels((m_sampled_cycle_m + 1) * 4);
+        const auto end_m = std::min(m_cycle_count_m, get_next_output_change_m() - 1);
+        const auto num_samples = end_m - m_sampled_cycle_m;
+        m_sampled_cycle_m = end_m;
+        if (!m_apu_enabled) {
+            m_samples.resize(m_samples.size() + num_samples);
+            continue;
+        }
+        const auto mixed_sample = get_mixed_sample();
+        for (size_t i = 0; i < num_samples; ++i) {
+            m_samples.push_back(
+                {high_pass(m_high_pass_capacitor.left, mixed_sample.left, true),
+                 high_pass(m_high_pass_capacitor.right, mixed_sample.right, true)});
+        }
+    }
+    catch_up_channels(get_cycle_count_t());
+}
+
+size_t Apu::get_next_output_change_m() const {
+    auto next_step_t = std::numeric_limits<size_t>::max();
+    const auto update = [&next_step_t](const AudioChannel& channel) {
+        if (channel.is_enabled()) {
+            next_step_t = std::min(next_step_t, channel.get_next_waveform_step());
+        }
+    };
+    update(m_channel1);
+    update(m_channel2);
+    update(m_channel3);
+    update(m_channel4);
+    // A step in the middle of an M cycle is first heard in the sample of that cycle.
+    return next_step_t / 4 + static_cast<size_t>(next_step_t % 4 != 0);
+}
 
+SampleFrame Apu::get_mixed_sample() {
     ChannelSamples samples;
     if (m_channel1.is_enabled()) {
         // Channel output is 0..15, DAC converts it to -1..1
@@ -225,10 +335,15 @@ SampleFrame Apu::get_sample() {
         auto value_digital = m_channel2.get_sample();
         samples.ch2 = convert_dac(value_digital);
     }
+    if (m_channel3.is_enabled()) {
+        samples.ch3 = convert_dac(m_channel3.get_sample());
+    }
+    if (m_channel4.is_enabled()) {
+        samples.ch4 = convert_dac(m_channel4.get_sample());
+    }
     auto mixed_sample = mix(samples);
     mixed_sample.left *= get_left_output_volume();
     mixed_sample.right *= get_right_output_volume();
-    mixed_sample = high_pass(mixed_sample);
     return mixed_sample;
 }
 
@@ -241,14 +356,32 @@ float Apu::get_right_output_volume() const {
     return static_cast<float>((m_master_volume & 0b111) + 1);
 }
 
+size_t Apu::get_cycle_count_t() const {
+    return m_cycle_count_m * 4;
+}
+
+void Apu::catch_up_channels(size_t cycle_t) {
+    if (!m_lazy_channels) {
+        m_channel1.catch_up_stepwise(cycle_t);
+        m_channel2.catch_up_stepwise(cycle_t);
+        m_channel3.catch_up_stepwise(cycle_t);
+        m_channel4.catch_up_stepwise(cycle_t);
+        return;
+    }
+    m_channel1.catch_up(cycle_t);
+    m_channel2.catch_up(cycle_t);
+    m_channel3.catch_up(cycle_t);
+    m_channel4.catch_up(cycle_t);
+}
+
 float Apu::convert_dac(uint8_t value) {
     return (static_cast<float>(value) - (15.f / 2.f)) / 7.5f;
 }
 
-SampleFrame Apu::mix(const ChannelSamples& samples) {
+SampleFrame Apu::mix(const ChannelSamples& samples) const {
     // Pan audio channel samples depending on NR51
     SampleFrame out;
-    auto options = m_emulator->get_options();
+    const auto& options = m_emulator->get_options();
     if (options.apu_channel1_enabled && bitmanip::is_bit_set(m_sound_panning, CH1_LEFT)) {
         out.left += samples.ch1;
     }
@@ -275,3 +408,42 @@ SampleFrame Apu::mix(const ChannelSamples& samples) {
     }
     return out;
 }
+
+void Apu::save_state(StateWriter& writer) const {
+    writer.write(m_register_block1);
+    writer.write(m_register_block2);
+    writer.write(m_apu_enabled);
+    writer.write(m_sound_panning);
+    writer.write(m_master_volume);
+    // Channels are saved as if caught up to the current cycle, so the state doesn't depend on when
+    // they were caught up the last time.
+    const auto save_channel = [&writer, cycle_t = get_cycle_count_t()](auto channel) {
+        channel.catch_up(cycle_t);
+        channel.save_state(writer);
+    };
+    save_channel(m_channel1);
+    save_channel(m_channel2);
+    save_channel(m_channel3);
+    save_channel(m_channel4);
+    writer.write(m_frame_sequencer_step);
+    writer.write(m_cycle_count_m);
+    writer.write(m_high_pass_capacitor);
+}
+
+void Apu::load_state(StateReader& reader) {
+    reader.read(m_register_block1);
+    reader.read(m_register_block2);
+    reader.read(m_apu_enabled);
+    reader.read(m_sound_panning);
+    reader.read(m_master_volume);
+    m_channel1.load_state(reader);
+    m_channel2.load_state(reader);
+    m_channel3.load_state(reader);
+    m_channel4.load_state(reader);
+    reader.read(m_frame_sequencer_step);
+    reader.read(m_cycle_count_m);
+    reader.read(m_high_pass_capacitor);
+    // Samples of the cycles before loading belong to the previous state
+    m_sampled_cycle_m = m_cycle_count_m;
+    m_samples.clear();
+}
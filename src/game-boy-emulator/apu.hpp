@@ -4,11 +4,14 @@
 #include "pulsechannel.hpp"
 #include "wavechannel.hpp"
 #include "noisechannel.hpp"
-#include "clocktimer.hpp"
 #include <memory>
 #include <cstdint>
 #include <array>
+#include <span>
+#include <vector>
 class Emulator;
+class StateWriter;
+class StateReader;
 
 struct SampleFrame {
     float left = 0;
@@ -35,7 +38,30 @@ class Apu {
     WaveChannel m_channel3;
     NoiseChannel m_channel4;
 
-    ClockTimer m_frame_sequencer_timer;
+    // Current step of the frame sequencer (0..7), advanced on every DIV-APU event.
+    uint8_t m_frame_sequencer_step = 0;
+    // Number of M cycles elapsed, used as time base for the channels since they are not ticked
+    // every cycle.
+    size_t m_cycle_count_m = 0;
+    // Otherwise the channels are caught up one waveform step at a time on every M cycle
+    bool m_lazy_channels;
+    [[nodiscard]] size_t get_cycle_count_t() const;
+    // Apply all waveform changes of the channels up to cycle_t.
+    void catch_up_channels(size_t cycle_t);
+
+    // One sample is generated per M cycle. They are generated in batches before anything changes
+    // the channel output and when the emulator takes them.
+    std::vector<SampleFrame> m_samples;
+    // M cycle up to which samples were generated
+    size_t m_sampled_cycle_m = 0;
+    // Generate the samples up to the current cycle and catch up the channels. The output of the
+    // channels only changes on waveform steps, so it is mixed once for all cycles between two
+    // steps and only the high pass filter is applied to every sample.
+    void generate_samples();
+    // First M cycle at which the output of an enabled channel changes
+    [[nodiscard]] size_t get_next_output_change_m() const;
+    // Output of the channels mixed and scaled by the master volume, before the high pass filter
+    [[nodiscard]] SampleFrame get_mixed_sample();
 
     // Get right/left volume from NR50
     [[nodiscard]] float get_left_output_volume() const;
@@ -50,7 +76,9 @@ class Apu {
     /**
      * Mix all channels into left/right channel according to sound panning register.
      */
-    SampleFrame mix(const ChannelSamples& samples);
+    [[nodiscard]] SampleFrame mix(const ChannelSamples& samples) const;
+    // Charge of the capacitors of the high pass filters on the left and right output
+    SampleFrame m_high_pass_capacitor;
 
 
     // Analog-Digital conversion of value in range 0..15 to value in range -1..1
@@ -67,5 +95,15 @@ public:
 
     void cycle_elapsed_callback(size_t cycle_count_m);
 
-    SampleFrame get_sample();
+    // Called by the timer on every falling edge of bit 4 of DIV (512 Hz unless DIV is written).
+    // Steps the frame sequencer clocking length, envelope and sweep.
+    void div_apu_callback();
+
+    // Samples of all cycles since the samples were cleared, one per M cycle. Only generated while
+    // sound is enabled in the options.
+    [[nodiscard]] std::span<const SampleFrame> get_samples();
+    void clear_samples();
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 };
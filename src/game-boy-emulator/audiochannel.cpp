@@ -1,4 +1,6 @@
 #include "audiochannel.hpp"
+#include "bitmanipulation.hpp"
+#include "savestate.hpp"
 
 bool AudioChannel::is_enabled() const {
     return m_enabled;
@@ -47,3 +49,108 @@ void AudioChannel::set_nrx3(uint8_t value) {
 void AudioChannel::set_nrx4(uint8_t value) {
     m_nrx4 = value;
 }
+
+void AudioChannel::catch_up(size_t cycle_t) {
+    if (cycle_t < m_current_cycle) {
+        // Cycle count was reset (new game loaded), resynchronise.
+        m_next_waveform_step = cycle_t + get_period();
+    }
+    m_current_cycle = cycle_t;
+    if (!is_enabled() || cycle_t < m_next_waveform_step) {
+        return;
+    }
+    const auto period = get_period();
+    const auto steps = 1 + ((cycle_t - m_next_waveform_step) / period);
+    m_next_waveform_step += steps * period;
+    advance_waveform(steps);
+}
+
+void AudioChannel::catch_up_stepwise(size_t cycle_t) {
+    if (cycle_t < m_current_cycle) {
+        m_next_waveform_step = cycle_t + get_period();
+    }
+    m_current_cycle = cycle_t;
+    if (!is_enabled()) {
+        return;
+    }
+    while (m_next_waveform_step <= cycle_t) {
+        m_next_waveform_step += get_period();
+        advance_waveform(1);
+    }
+}
+
+size_t AudioChannel::get_next_waveform_step() const {
+    return m_next_waveform_step;
+}
+
+void AudioChannel::restart_period() {
+    m_next_waveform_step = m_current_cycle + get_period();
+}
+
+void AudioChannel::trigger_envelope() {
+    m_volume_sweep_counter = get_volume_sweep_pace();
+    m_current_volume = get_volume();
+}
+
+uint8_t AudioChannel::get_current_volume() const {
+    return m_current_volume;
+}
+
+void AudioChannel::do_envelope_sweep() {
+    auto envelope_sweep_pace = get_volume_sweep_pace();
+    if (envelope_sweep_pace == 0) {
+        return;
+    }
+    if (m_volume_sweep_counter > 0) {
+        m_volume_sweep_counter--;
+    }
+    if (m_volume_sweep_counter == 0) {
+        m_volume_sweep_counter = get_volume_sweep_pace();
+        // Actually do the sweep every pace ticks of the envelope
+        if (bitmanip::is_bit_set(read_nrx2(), 3)) {
+            // Increase volume envelope
+            if (m_current_volume < 14) {
+                m_current_volume++;
+            }
+        } else {
+            // Decrease volume envelope
+            if (m_current_volume > 0) {
+                m_current_volume--;
+            }
+        }
+    }
+}
+
+uint8_t AudioChannel::get_volume() const {
+    return (read_nrx2() & 0b11110000) >> 4;
+}
+
+uint8_t AudioChannel::get_volume_sweep_pace() const {
+    return read_nrx2() & 0b111;
+}
+
+void AudioChannel::save_state(StateWriter& writer) const {
+    writer.write(m_enabled);
+    writer.write(m_nrx0);
+    writer.write(m_nrx1);
+    writer.write(m_nrx2);
+    writer.write(m_nrx3);
+    writer.write(m_nrx4);
+    writer.write(m_volume_sweep_counter);
+    writer.write(m_current_volume);
+    writer.write(m_current_cycle);
+    writer.write(m_next_waveform_step);
+}
+
+void AudioChannel::load_state(StateReader& reader) {
+    reader.read(m_enabled);
+    reader.read(m_nrx0);
+    reader.read(m_nrx1);
+    reader.read(m_nrx2);
+    reader.read(m_nrx3);
+    reader.read(m_nrx4);
+    reader.read(m_volume_sweep_counter);
+    reader.read(m_current_volume);
+    reader.read(m_current_cycle);
+    reader.read(m_next_waveform_step);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+class StateWriter;
+class StateReader;
 
 class AudioChannel {
 
@@ -14,6 +17,38 @@ class AudioChannel {
     uint8_t m_nrx3 = 0;
     uint8_t m_nrx4 = 0;
 
+    /*
+     * Volume envelope, shared by all channels using NRx2 as envelope register (1, 2, 4).
+     */
+    // Bits 4..7 of NRx2
+    [[nodiscard]] uint8_t get_volume() const;
+    // Bits 0..2 of NRx2
+    [[nodiscard]] uint8_t get_volume_sweep_pace() const;
+    uint8_t m_volume_sweep_counter = 0;
+    uint8_t m_current_volume = 0;
+
+    /*
+     * Waveform timing. Channels are not ticked every cycle. Instead the time of the next step of
+     * the waveform generator is stored and all steps up to the current cycle are applied at once
+     * when the channel is caught up before sampling or before a register write.
+     */
+    // T cycle up to which the channel state was computed
+    size_t m_current_cycle = 0;
+    // T cycle at which the waveform generator steps the next time
+    size_t m_next_waveform_step = 0;
+
+protected:
+    // Number of T cycles between two steps of the waveform generator
+    [[nodiscard]] virtual size_t get_period() const = 0;
+    // Apply the given number of waveform generator steps at once
+    virtual void advance_waveform(size_t steps) = 0;
+    // Restart the period of the waveform generator at the current cycle, used when triggering.
+    void restart_period();
+
+    // Reload the volume envelope from NRx2, has to be called when the channel is triggered.
+    void trigger_envelope();
+    [[nodiscard]] uint8_t get_current_volume() const;
+
 public:
     void set_enabled(bool enabled);
     [[nodiscard]] bool is_enabled() const;
@@ -29,9 +64,24 @@ public:
     virtual void set_nrx3(uint8_t value);
     virtual void set_nrx4(uint8_t value);
 
+    // Apply all waveform steps which happened until cycle_t (in T cycles).
+    void catch_up(size_t cycle_t);
+    // Like catch_up, but applies the waveform steps one at a time like a channel ticked every
+    // cycle. Used as reference for catch_up.
+    void catch_up_stepwise(size_t cycle_t);
+    // T cycle of the next waveform step after catching up. The output of an enabled channel only
+    // changes at this cycle or when the channel is written or clocked by the frame sequencer.
+    [[nodiscard]] size_t get_next_waveform_step() const;
     // Generate a sample in range 0..15
     virtual uint8_t get_sample() = 0;
 
+    // Clocked at 64 Hz by the frame sequencer.
+    void do_envelope_sweep();
+
+    // Channels save the state of the base class before their own.
+    virtual void save_state(StateWriter& writer) const;
+    virtual void load_state(StateReader& reader);
+
     AudioChannel() = default;
     virtual ~AudioChannel() = default;
     AudioChannel(const AudioChannel&) = default;
@@ -0,0 +1,168 @@
+#include "batteryram.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+BatteryRam::BatteryRam(std::filesystem::path path, size_t size, Options options) :
+        m_path(std::move(path)),
+        m_data(size, 0),
+        m_options(options),
+        m_logger(spdlog::get("")),
+        m_last_submit(std::chrono::steady_clock::now()) {
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(m_path, ec);
+    if (!ec) {
+        std::ifstream file(m_path, std::ios::binary);
+        file.read(std::bit_cast<char*>(m_data.data()),
+                  static_cast<std::streamsize>(std::min<uintmax_t>(file_size, size)));
+        if (file_size != size) {
+            m_logger->warn("RAM file {} has {} bytes instead of {}, it will be rewritten",
+                           m_path.string(), file_size, size);
+        }
+        // A file of the wrong size is written completely on the first flush.
+        m_file_exists = file_size == size;
+    }
+    m_file_content = m_data;
+}
+
+BatteryRam::~BatteryRam() {
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+std::span<uint8_t> BatteryRam::get_data() {
+    return m_data;
+}
+
+bool BatteryRam::is_flush_due() const {
+    return std::chrono::steady_clock::now() - m_last_submit >= m_options.flush_interval;
+}
+
+void BatteryRam::submit(std::span<const uint64_t> dirty_pages) {
+    m_last_submit = std::chrono::steady_clock::now();
+    std::vector<Page> pages;
+    for (size_t word = 0; word < dirty_pages.size(); ++word) {
+        for (auto bits = dirty_pages[word]; bits != 0; bits &= bits - 1) {
+            const auto index = (word * 64) + static_cast<size_t>(std::countr_zero(bits));
+            const auto offset = index * PAGE_SIZE;
+            if (offset >= m_data.size()) {
+                break;
+            }
+            Page page{index, {}};
+            std::copy_n(m_data.begin() + static_cast<std::ptrdiff_t>(offset),
+                        std::min(PAGE_SIZE, m_data.size() - offset), page.data.begin());
+            pages.push_back(page);
+        }
+    }
+    if (pages.empty()) {
+        return;
+    }
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_pending_pages.insert(m_pending_pages.end(), pages.begin(), pages.end());
+    }
+    // Like the debug views, the thread is only started when there is something to do.
+    if (!m_writer.joinable()) {
+        m_writer = std::thread(&BatteryRam::run_writer, this);
+    }
+    m_condition.notify_all();
+}
+
+void BatteryRam::wait_until_written() {
+    std::unique_lock lock{m_mutex};
+    m_condition.wait(lock, [this] { return m_pending_pages.empty() && !m_writing; });
+}
+
+void BatteryRam::run_writer() {
+    std::unique_lock lock{m_mutex};
+    while (true) {
+        m_condition.wait(lock, [this] { return m_stop || !m_pending_pages.empty(); });
+        if (m_pending_pages.empty()) {
+            // Only reached when stopping, after all pages were written
+            return;
+        }
+        const auto pages = std::exchange(m_pending_pages, {});
+        m_writing = true;
+        lock.unlock();
+        write_pages(pages);
+        lock.lock();
+        m_writing = false;
+        m_condition.notify_all();
+    }
+}
+
+void BatteryRam::write_pages(const std::vector<Page>& pages) {
+    for (const auto& page : pages) {
+        const auto offset = page.index * PAGE_SIZE;
+        std::copy_n(page.data.begin(), std::min(PAGE_SIZE, m_file_content.size() - offset),
+                    m_file_content.begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+    if (m_options.atomic_save || !m_file_exists) {
+        write_file_atomic();
+    } else {
+        write_file_in_place(pages);
+    }
+}
+
+void BatteryRam::write_file_in_place(const std::vector<Page>& pages) {
+    std::fstream file(m_path, std::ios::in | std::ios::out | std::ios::binary);
+    for (const auto& page : pages) {
+        const auto offset = page.index * PAGE_SIZE;
+        file.seekp(static_cast<std::streamoff>(offset));
+        const auto size = std::min(PAGE_SIZE, m_file_content.size() - offset);
+        file.write(std::bit_cast<const char*>(m_file_content.data() + offset),
+                   static_cast<std::streamsize>(size));
+    }
+    file.flush();
+    if (!file) {
+        m_logger->error("Failed to write RAM file {}", m_path.string());
+    }
+}
+
+void BatteryRam::write_file_atomic() {
+    auto temporary_path = m_path;
+    temporary_path += ".tmp";
+    const std::unique_ptr<std::FILE, decltype(&std::fclose)> file{
+        std::fopen(temporary_path.c_str(), "wb"), &std::fclose};
+    if (file == nullptr) {
+        m_logger->error("Failed to open {} for writing", temporary_path.string());
+        return;
+    }
+    bool success = std::fwrite(m_file_content.data(), 1, m_file_content.size(), file.get())
+                   == m_file_content.size();
+    success = success && std::fflush(file.get()) == 0;
+#if defined(__unix__)
+    // Make sure the data is on disk before the rename makes it visible
+    success = success && fsync(fileno(file.get())) == 0;
+#endif
+    if (!success) {
+        m_logger->error("Failed to write {}", temporary_path.string());
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary_path, m_path, ec);
+    if (ec) {
+        m_logger->error("Failed to replace {}: {}", m_path.string(), ec.message());
+        return;
+    }
+    m_file_exists = true;
+}
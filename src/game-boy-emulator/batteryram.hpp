@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include "mbc.hpp"
+#include "spdlog/fwd.h"
+
+/*
+ * Battery backed cartridge RAM, persisted to a file. The RAM is kept in memory for emulation and
+ * pages written by the game are handed to a background thread, which writes them to the file. The
+ * emulation thread never waits for disk I/O.
+ */
+class BatteryRam {
+public:
+    // Granularity of writes to the file, the pages are the ones tracked as dirty by the MBC.
+    static constexpr size_t PAGE_SIZE = Mbc::RAM_PAGE_SIZE;
+
+    struct Options {
+        // Minimum time between two writes to the file
+        std::chrono::milliseconds flush_interval{1000};
+        // Write the complete RAM to a temporary file which then replaces the RAM file, so a crash
+        // during writing never leaves a partially written file. Otherwise only dirty pages are
+        // written in place.
+        bool atomic_save = false;
+    };
+
+    // Load the RAM from the file if it exists, otherwise the RAM starts zeroed and the file is
+    // created by the first flush.
+    BatteryRam(std::filesystem::path path, size_t size, Options options);
+    BatteryRam(const BatteryRam&) = delete;
+    BatteryRam& operator=(const BatteryRam&) = delete;
+    BatteryRam(BatteryRam&&) = delete;
+    BatteryRam& operator=(BatteryRam&&) = delete;
+    // Writes all pages submitted so far
+    ~BatteryRam();
+
+    [[nodiscard]] std::span<uint8_t> get_data();
+
+    // True if the flush interval elapsed since the last submit
+    [[nodiscard]] bool is_flush_due() const;
+    // Copy the pages marked in the dirty page bitmap and queue them for writing. Bit n of the
+    // bitmap marks page n.
+    void submit(std::span<const uint64_t> dirty_pages);
+    // Block until everything submitted so far was written.
+    void wait_until_written();
+
+private:
+    struct Page {
+        size_t index;
+        std::array<uint8_t, PAGE_SIZE> data;
+    };
+
+    std::filesystem::path m_path;
+    std::vector<uint8_t> m_data;
+    Options m_options;
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::chrono::steady_clock::time_point m_last_submit;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    // Protected by m_mutex
+    std::vector<Page> m_pending_pages;
+    bool m_writing = false;
+    bool m_stop = false;
+
+    // Only used by the writer thread: the content of the file
+    std::vector<uint8_t> m_file_content;
+    bool m_file_exists = false;
+    std::thread m_writer;
+
+    void run_writer();
+    void write_pages(const std::vector<Page>& pages);
+    void write_file_in_place(const std::vector<Page>& pages);
+    void write_file_atomic();
+};
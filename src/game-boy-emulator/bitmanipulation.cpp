@@ -1,5 +1,6 @@
 #include "bitmanipulation.hpp"
 #include "constants.h"
+#include <array>
 #include <cassert>
 
 namespace bitmanip {
@@ -67,4 +68,24 @@ uint8_t rotate_right_carry(uint8_t x, bool& carry_flag) {
     return x;
 }
 
+namespace {
+constexpr std::array<uint8_t, 256> make_reverse_bits_table() {
+    std::array<uint8_t, 256> table{};
+    for (unsigned x = 0; x < table.size(); ++x) {
+        unsigned reversed = 0;
+        for (unsigned bit = 0; bit < constants::BYTE_SIZE; ++bit) {
+            reversed |= ((x >> bit) & 1U) << (constants::BYTE_SIZE - 1 - bit);
+        }
+        table[x] = static_cast<uint8_t>(reversed);
+    }
+    return table;
+}
+
+constexpr auto REVERSE_BITS_TABLE = make_reverse_bits_table();
+} // namespace
+
+uint8_t reverse_bits(uint8_t x) {
+    return REVERSE_BITS_TABLE[x];
+}
+
 } // namespace bitmanip
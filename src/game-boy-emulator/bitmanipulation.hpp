@@ -50,6 +50,9 @@ uint8_t rotate_right_carry(uint8_t x, bool& carry_flag);
 
 uint8_t swap_nibbles(uint8_t x);
 
+// Reverse the order of the bits. Example 0b1100'0001 -> 0b1000'0011
+uint8_t reverse_bits(uint8_t x);
+
 constexpr uint16_t word_from_bytes(uint8_t high_byte, uint8_t low_byte) {
     return (high_byte << constants::BYTE_SIZE) + low_byte;
 }
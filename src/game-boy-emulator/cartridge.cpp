@@ -1,5 +1,7 @@
 #include "cartridge.hpp"
 
+#include "batteryram.hpp"
+#include "constants.h"
 #include "memorymappedfile.hpp"
 #include "emulator.hpp"
 #include "memorymap.hpp"
@@ -9,14 +11,19 @@
 #include "mbc1.hpp"
 #include "mbc3.hpp"
 #include "mbc5.hpp"
-#include "io.hpp"
+#include "romcache.hpp"
+#include "rtc.hpp"
+#include "savestate.hpp"
 
 #include "fmt/format.h"
 #include "magic_enum.hpp"
 #include <spdlog/spdlog.h>
 
+#include <chrono>
 #include <ranges>
+#include <span>
 #include <utility>
+#include <vector>
 
 namespace cartridge {
 
@@ -26,56 +33,97 @@ namespace constants {// See https://gbdev.io/pandocs/The_Cartridge_Header.html f
     constexpr int TITLE_END = 0x143;
 }
 
-Cartridge::Cartridge(Emulator* emulator, const std::filesystem::path& rom_file_path) :
-        m_emulator(emulator), m_logger(spdlog::get("")) {
-    EmulatorIo io;
-    auto rom_bytes = io.load_rom_file(rom_file_path);
-    if (!rom_bytes.has_value()) {
-        throw LoadError(fmt::format("Failed to load {}", rom_file_path.string()));
+namespace {
+// Time for the RTC, which is either the emulated time or the wall time
+Rtc::Clock get_rtc_clock(const Emulator* emulator) {
+    if (!emulator->get_options().rtc_follows_emulated_time) {
+        return {};
     }
-    if (rom_bytes->size() < memmap::CartridgeHeaderEnd) {
+    return [emulator] {
+        using CyclesM = std::chrono::duration<int64_t, std::ratio<1, ::constants::CLOCK_SPEED_M>>;
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            CyclesM(emulator->get_state().cycles_m));
+    };
+}
+
+void check_header(std::span<const uint8_t> rom_bytes) {
+    if (rom_bytes.size() < memmap::CartridgeHeaderEnd) {
         throw LogicError(
-            fmt::format("ROM only {} bytes, does not contain cartridge header", rom_bytes->size()));
+            fmt::format("ROM only {} bytes, does not contain cartridge header", rom_bytes.size()));
     }
+}
+} // namespace
+
+Cartridge::Cartridge(Emulator* emulator, const std::filesystem::path& rom_file_path) :
+        m_emulator(emulator), m_logger(emulator->get_logger()) {
+    m_rom_file = RomCache::instance().open(rom_file_path);
+    const auto rom_bytes = m_rom_file->get_data();
+    check_header(rom_bytes);
 
-    auto ram_size_info = Mbc::read_ram_size_info(rom_bytes.value());
+    auto ram_size_info = Mbc::read_ram_size_info(rom_bytes);
     std::span<uint8_t> ram;
     if (ram_size_info.size_bytes != 0) {
-        // Memory map cartridge RAM as a file to emulate the battery backed RAM.
+        // Persist cartridge RAM to a file to emulate the battery backed RAM.
         auto ram_file_path = rom_file_path;
         ram_file_path.replace_extension(".gb.ram");
-        m_ram_file = std::make_unique<MemoryMappedFile>(ram_file_path, ram_size_info.size_bytes);
+        const auto& options = m_emulator->get_options();
+        m_battery_ram = std::make_unique<BatteryRam>(
+            ram_file_path, ram_size_info.size_bytes,
+            BatteryRam::Options{
+                .flush_interval
+                = std::chrono::milliseconds(options.battery_ram_flush_interval_ms),
+                .atomic_save = options.battery_ram_atomic_save});
         m_logger->info("Opening {} as cartridge RAM file", ram_file_path.string());
-        ram = m_ram_file->get_data();
+        ram = m_battery_ram->get_data();
     }
+    create_mbc(rom_bytes, ram);
+    if (m_rtc) {
+        m_rtc_file_path = rom_file_path;
+        m_rtc_file_path.replace_extension(".gb.rtc");
+        m_rtc->load(m_rtc_file_path);
+    }
+}
 
-    auto rom_size = Mbc::read_rom_size_info(rom_bytes.value());
+Cartridge::Cartridge(Emulator* emulator, std::shared_ptr<const std::vector<uint8_t>> rom) :
+        m_emulator(emulator), m_logger(emulator->get_logger()), m_rom_data(std::move(rom)) {
+    check_header(*m_rom_data);
+    m_ram_data.resize(Mbc::read_ram_size_info(*m_rom_data).size_bytes);
+    create_mbc(*m_rom_data, m_ram_data);
+}
+
+void Cartridge::create_mbc(std::span<const uint8_t> rom_bytes, std::span<uint8_t> ram) {
+    auto rom_size = Mbc::read_rom_size_info(rom_bytes);
+    auto ram_size_info = Mbc::read_ram_size_info(rom_bytes);
     // Initialize after size check to avoid potential out-of-bounds access.
-    m_cartridge_type = get_type(rom_bytes.value());
+    m_cartridge_type = get_type(rom_bytes);
     m_logger->info("Detected MBC type {}, ROM {} bytes, {} banks, RAM {} bytes, {} banks",
                    magic_enum::enum_name(m_cartridge_type), rom_size.size_bytes, rom_size.num_banks,
                    ram_size_info.size_bytes, ram_size_info.num_banks);
-    auto title = get_title(rom_bytes.value());
+    auto title = get_title(rom_bytes);
     m_emulator->get_state().game_title = title;
     m_logger->info("Game {}", title);
 #pragma GCC diagnostic ignored "-Wswitch-enum"
     switch (m_cartridge_type) {
     case CartridgeType::ROM_ONLY:
-        if (rom_bytes->size() != memmap::CartridgeRomSize) {
+        if (rom_bytes.size() != memmap::CartridgeRomSize) {
             throw LogicError("Invalid ROM size");
         }
-        m_mbc = std::make_unique<NoMbc>(std::move(rom_bytes.value()), ram);
+        m_mbc = std::make_unique<NoMbc>(rom_bytes, ram);
         break;
     case CartridgeType::MBC1:
     case CartridgeType::MBC1_RAM:
     case CartridgeType::MBC1_RAM_BATTERY:
-        m_mbc = std::make_unique<Mbc1>(std::move(rom_bytes.value()), ram);
+        m_mbc = std::make_unique<Mbc1>(rom_bytes, ram);
         break;
     case CartridgeType::MBC3:
     case CartridgeType::MBC3_RAM:
     case CartridgeType::MBC3_RAM_BATTERY:
+        m_mbc = std::make_unique<Mbc3>(rom_bytes, ram, nullptr);
+        break;
+    case CartridgeType::MBC3_TIMER_BATTERY:
     case CartridgeType::MBC3_TIMER_RAM_BATTERY:
-        m_mbc = std::make_unique<Mbc3>(std::move(rom_bytes.value()), ram);
+        m_rtc = std::make_unique<Rtc>(get_rtc_clock(m_emulator));
+        m_mbc = std::make_unique<Mbc3>(rom_bytes, ram, m_rtc.get());
         break;
     case CartridgeType::MBC5:
     case CartridgeType::MBC5_RAM:
@@ -83,12 +131,13 @@ Cartridge::Cartridge(Emulator* emulator, const std::filesystem::path& rom_file_p
     case CartridgeType::MBC5_RUMBLE_RAM_BATTERY:
     case CartridgeType::MBC5_RUMBLE:
     case CartridgeType::MBC5_RUMBLE_RAM:
-        m_mbc = std::make_unique<Mbc5>(std::move(rom_bytes.value()), ram);
+        m_mbc = std::make_unique<Mbc5>(rom_bytes, ram);
         break;
     default:
         throw NotImplementedError(fmt::format("Cartridge type {} not implemented",
                                               magic_enum::enum_name(m_cartridge_type)));
     }
+    m_mbc->set_logger(m_logger);
 }
 
 uint8_t Cartridge::read_byte(uint16_t address) const {
@@ -99,7 +148,11 @@ void Cartridge::write_byte(uint16_t address, uint8_t value) {
     m_mbc->write_byte(address, value);
 };
 
-CartridgeType get_type(const std::vector<uint8_t>& rom) {
+const MappedBanks& Cartridge::get_mapped_banks() const {
+    return m_mbc->get_mapped_banks();
+}
+
+CartridgeType get_type(std::span<const uint8_t> rom) {
     auto val = rom[constants::CARTRIDGE_TYPE_OFFSET];
     if (magic_enum::enum_contains<CartridgeType>(val)) {
         return CartridgeType{val};
@@ -108,12 +161,27 @@ CartridgeType get_type(const std::vector<uint8_t>& rom) {
 }
 
 void Cartridge::sync() {
-    if (m_ram_file) {
-        m_ram_file->sync();
+    if (m_battery_ram && m_mbc->is_ram_dirty() && m_battery_ram->is_flush_due()) {
+        m_battery_ram->submit(m_mbc->get_dirty_ram_pages());
+        m_mbc->clear_dirty_ram_pages();
+    }
+}
+
+void Cartridge::save_state(StateWriter& writer) const {
+    m_mbc->save_state(writer);
+    if (m_rtc) {
+        m_rtc->save_state(writer);
     }
 }
 
-std::string get_title(const std::vector<uint8_t>& rom) {
+void Cartridge::load_state(StateReader& reader) {
+    m_mbc->load_state(reader);
+    if (m_rtc) {
+        m_rtc->load_state(reader);
+    }
+}
+
+std::string get_title(std::span<const uint8_t> rom) {
     assert(rom.size() >= constants::TITLE_END && "Too small size ROM passed to get_title");
     constexpr int TITLE_LEN = constants::TITLE_END - constants::TITLE_BEGIN + 1;
     return rom
@@ -124,8 +192,17 @@ std::string get_title(const std::vector<uint8_t>& rom) {
 
 }
 
-// We need a destructor for the outer class to be defined where the MemoryMappedFile is complete.
+// We need a destructor for the outer class to be defined where the BatteryRam is complete.
 // Otherwise the unique_ptr won't compile for incomplete types.
-Cartridge::~Cartridge() = default;
+Cartridge::~Cartridge() {
+    // Write everything the game changed since the last sync, the BatteryRam destructor then waits
+    // for the writer. A moved-from cartridge has no MBC.
+    if (m_battery_ram && m_mbc && m_mbc->is_ram_dirty()) {
+        m_battery_ram->submit(m_mbc->get_dirty_ram_pages());
+    }
+    if (m_rtc && !m_rtc_file_path.empty()) {
+        m_rtc->save(m_rtc_file_path);
+    }
+}
 
 } // namespace cartridge
@@ -3,9 +3,17 @@
 
 class Emulator;
 #include "spdlog/fwd.h"
+#include "cartridge_info.hpp"
+class BatteryRam;
+class Rtc;
 class MemoryMappedFile;
 class Mbc;
+class StateWriter;
+class StateReader;
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace cartridge {
@@ -49,8 +57,10 @@ namespace cartridge {
     class Cartridge {
     public:
         Cartridge(Emulator* emulator, const std::filesystem::path& rom_file_path);
+        // Run a ROM from memory. RAM and RTC are kept in memory only, nothing is written to disk.
+        Cartridge(Emulator* emulator, std::shared_ptr<const std::vector<uint8_t>> rom);
         ~Cartridge();
-        // Sadly, to keep the forward declarations for Mbc and MemoryMappedFile, a destructor for
+        // Sadly, to keep the forward declarations for Mbc and BatteryRam, a destructor for
         // Cartridge is required to be defined. This triggers warnings about the rule of five, to
         // silence those we have to manually define the other functions.
         Cartridge(const Cartridge&) = delete;
@@ -60,19 +70,40 @@ namespace cartridge {
 
         [[nodiscard]] uint8_t read_byte(uint16_t address) const;
         void write_byte(uint16_t address, uint8_t value);
+        // The returned reference stays valid and is updated by the MBC for the lifetime of the
+        // cartridge.
+        [[nodiscard]] const MappedBanks& get_mapped_banks() const;
 
-        // Write memory mapped ram contents to disk.
+        // Hand RAM pages written by the game to the background writer once the flush interval
+        // elapsed. Cheap enough to be called every frame.
         void sync();
 
+        void save_state(StateWriter& writer) const;
+        void load_state(StateReader& reader);
+
     private:
         Emulator* m_emulator;
         std::shared_ptr<spdlog::logger> m_logger;
         CartridgeType m_cartridge_type;
+        // Read-only mapping of the ROM file, shared with other instances running the same game.
+        // Declared before the MBC which refers to it.
+        std::shared_ptr<const MemoryMappedFile> m_rom_file;
+        // Declared before the MBC which refers to them. Only one of them is used, depending on
+        // whether the game was loaded from a file or from memory.
+        std::unique_ptr<BatteryRam> m_battery_ram;
+        std::shared_ptr<const std::vector<uint8_t>> m_rom_data;
+        std::vector<uint8_t> m_ram_data;
+        // Real time clock of MBC3 cartridges with timer, saved next to the RAM file if the game
+        // was loaded from a file
+        std::unique_ptr<Rtc> m_rtc;
+        std::filesystem::path m_rtc_file_path;
         std::unique_ptr<Mbc> m_mbc;
-        std::unique_ptr<MemoryMappedFile> m_ram_file;
+
+        // Check the header, log the cartridge info and create the MBC and RTC
+        void create_mbc(std::span<const uint8_t> rom_bytes, std::span<uint8_t> ram);
     };
 
-    [[nodiscard]] std::string get_title(const std::vector<uint8_t>& rom);
+    [[nodiscard]] std::string get_title(std::span<const uint8_t> rom);
 
-    [[nodiscard]] CartridgeType get_type(const std::vector<uint8_t>& rom);
+    [[nodiscard]] CartridgeType get_type(std::span<const uint8_t> rom);
 } // namespace cartridge
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 struct RomInfo {
     size_t size_bytes = 0;
@@ -10,3 +11,14 @@ struct RamInfo {
     size_t size_bytes = 0;
     size_t num_banks = 0;
 };
+// Start of the cartridge banks currently mapped into the address space. Only changed by writes to
+// the MBC registers, so reads can use them without calling into the MBC.
+struct MappedBanks {
+    // Mapped to 0x0000-0x3FFF
+    const uint8_t* rom_fixed = nullptr;
+    // Mapped to 0x4000-0x7FFF
+    const uint8_t* rom_switchable = nullptr;
+    // Mapped to 0xA000-0xBFFF. nullptr if RAM is disabled or the MBC maps something else there, in
+    // which case reads have to go through the MBC.
+    const uint8_t* ram = nullptr;
+};
@@ -37,6 +37,8 @@ constexpr int OAM_DMA_NUM_BYTES = 160;
 constexpr int CLOCK_SPEED_T = 4194304;
 // Speed in M cycles
 constexpr int CLOCK_SPEED_M = CLOCK_SPEED_T / 4;
+// Length of one frame (154 lines of 456 dots) in T cycles, which gives ~59.73 frames per second.
+constexpr int CYCLES_PER_FRAME_T = 70224;
 
 // 100% volume is far too loud where the max value of a volume slider would induce tinnitus in
 // seconds. To be able to use the whole range of the volume slider, we scale the volume down by a
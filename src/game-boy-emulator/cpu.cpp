@@ -6,6 +6,7 @@
 #include "exceptions.hpp"
 
 #include "opcodes.hpp"
+#include "savestate.hpp"
 #include "spdlog/spdlog.h"
 
 
@@ -141,7 +142,7 @@ void Cpu::run() {
     }
 }
 
-Cpu::Cpu(Emulator* emulator) : m_emulator(emulator), m_logger(spdlog::get("")) {}
+Cpu::Cpu(Emulator* emulator) : m_emulator(emulator), m_logger(emulator->get_logger()) {}
 
 void Cpu::set_subtract_flag(BitValues value) {
     bitmanip::set_bit(registers.f, as_integral(flags::subtract), as_integral(value));
@@ -1113,3 +1114,15 @@ std::ostream& operator<<(std::ostream& os, const CpuDebugState& cds) {
 }
 
 bool operator==(const CpuDebugState& a, const CpuDebugState& b) = default;
+
+void Cpu::save_state(StateWriter& writer) const {
+    writer.write(registers);
+    writer.write(current_instruction);
+    writer.write(previous_instruction);
+}
+
+void Cpu::load_state(StateReader& reader) {
+    reader.read(registers);
+    reader.read(current_instruction);
+    reader.read(previous_instruction);
+}
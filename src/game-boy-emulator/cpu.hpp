@@ -14,6 +14,8 @@
 
 #include "spdlog/fwd.h"
 class Emulator;
+class StateWriter;
+class StateReader;
 
 
 // Typedef for clock cycles.
@@ -72,6 +74,9 @@ public:
 
     void call_isr(uint16_t isr_address);
 
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
 private:
     template <typename T>
     [[noreturn]] void abort_execution(std::string_view msg) const {
@@ -0,0 +1,290 @@
+#include "cputrace.hpp"
+#include "exceptions.hpp"
+#include "memorymappedfile.hpp"
+
+#include "fmt/format.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace {
+// CpuDebugState is written as is to binary traces
+static_assert(std::is_trivially_copyable_v<CpuDebugState>);
+static_assert(sizeof(CpuDebugState) == 16);
+
+// A line has 16 bytes as two hex digits each: A F B C D E H L SP PC and 4 bytes at PC.
+constexpr size_t NUM_LINE_BYTES = 16;
+using DigitPositions = std::array<uint8_t, NUM_LINE_BYTES>;
+
+// A: 01 F: B0 B: 00 C: 13 D: 00 E: D8 H: 01 L: 4D SP: FFFE PC: 0100 (00 C3 13 02)
+constexpr size_t DEBUG_STATE_LINE_LENGTH = 79;
+constexpr DigitPositions DEBUG_STATE_POSITIONS{3,  9,  15, 21, 27, 33, 39, 45,
+                                               52, 54, 61, 63, 67, 70, 73, 76};
+// A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02
+constexpr size_t GAMEBOY_DOCTOR_LINE_LENGTH = 73;
+constexpr DigitPositions GAMEBOY_DOCTOR_POSITIONS{2,  7,  12, 17, 22, 27, 32, 37,
+                                                  43, 45, 51, 53, 62, 65, 68, 71};
+
+constexpr uint64_t ONES = 0x0101010101010101;
+constexpr uint64_t HIGH_BITS = ONES * 0x80;
+
+// Sets the high bit of every byte of x with low < byte < high. Bytes are handled independently,
+// no carry crosses a byte boundary for bytes below 0x80 and high <= 0x80.
+constexpr uint64_t bytes_between(uint64_t x, uint64_t low, uint64_t high) {
+    const auto low_bits = x & (ONES * 0x7F);
+    return (ONES * (0x7F + high) - low_bits) & ~x & (low_bits + ONES * (0x7F - low)) & HIGH_BITS;
+}
+
+// Decode 8 hex digits into 4 bytes. Returns false if a character is no hex digit.
+bool decode_hex_digits(const char* digits, uint8_t* bytes) {
+    uint64_t x = 0;
+    std::memcpy(&x, digits, sizeof(x));
+    if constexpr (std::endian::native == std::endian::big) {
+        x = std::byteswap(x);
+    }
+    const auto valid = bytes_between(x, '0' - 1, '9' + 1) | bytes_between(x, 'A' - 1, 'F' + 1)
+                       | bytes_between(x, 'a' - 1, 'f' + 1);
+    if (valid != HIGH_BITS) {
+        return false;
+    }
+    // Letters have bit 6 set and their low nibble is 1 to 6.
+    const auto nibbles = (x & (ONES * 0x0F)) + 9 * ((x >> 6) & ONES);
+    // Combine pairs of nibbles into the low byte of every 16 bit lane, then pack the bytes.
+    constexpr uint64_t EVEN_BYTES = 0x00FF00FF00FF00FF;
+    auto packed = ((nibbles & EVEN_BYTES) << 4) | ((nibbles >> 8) & EVEN_BYTES);
+    packed = (packed | (packed >> 8)) & 0x0000FFFF0000FFFF;
+    packed = (packed | (packed >> 16)) & 0xFFFFFFFF;
+    for (size_t i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<uint8_t>(packed >> (8 * i));
+    }
+    return true;
+}
+
+bool parse_line(std::string_view line, CpuLogReader::Format format, CpuDebugState& state) {
+    const bool is_debug_state = format == CpuLogReader::Format::DebugState;
+    const auto length = is_debug_state ? DEBUG_STATE_LINE_LENGTH : GAMEBOY_DOCTOR_LINE_LENGTH;
+    const auto& positions = is_debug_state ? DEBUG_STATE_POSITIONS : GAMEBOY_DOCTOR_POSITIONS;
+    if (line.size() != length || !line.starts_with('A')) {
+        return false;
+    }
+    std::array<char, 2 * NUM_LINE_BYTES> digits{};
+    for (size_t i = 0; i < NUM_LINE_BYTES; ++i) {
+        std::memcpy(&digits[2 * i], &line[positions[i]], 2);
+    }
+    std::array<uint8_t, NUM_LINE_BYTES> bytes{};
+    for (size_t i = 0; i < NUM_LINE_BYTES; i += 4) {
+        if (!decode_hex_digits(&digits[2 * i], &bytes[i])) {
+            return false;
+        }
+    }
+    state = {.a = bytes[0],
+             .f = bytes[1],
+             .b = bytes[2],
+             .c = bytes[3],
+             .d = bytes[4],
+             .e = bytes[5],
+             .h = bytes[6],
+             .l = bytes[7],
+             .sp = static_cast<uint16_t>((bytes[8] << 8) | bytes[9]),
+             .pc = static_cast<uint16_t>((bytes[10] << 8) | bytes[11]),
+             .mem_pc = {bytes[12], bytes[13], bytes[14], bytes[15]}};
+    return true;
+}
+
+std::string describe_differences(const CpuDebugState& expected, const CpuDebugState& actual) {
+    std::string differences;
+    auto check = [&](std::string_view name, auto expected_value, auto actual_value) {
+        if (expected_value != actual_value) {
+            differences += fmt::format(" {}", name);
+        }
+    };
+    check("A", expected.a, actual.a);
+    check("F", expected.f, actual.f);
+    check("B", expected.b, actual.b);
+    check("C", expected.c, actual.c);
+    check("D", expected.d, actual.d);
+    check("E", expected.e, actual.e);
+    check("H", expected.h, actual.h);
+    check("L", expected.l, actual.l);
+    check("SP", expected.sp, actual.sp);
+    check("PC", expected.pc, actual.pc);
+    check("memory at PC", expected.mem_pc, actual.mem_pc);
+    return differences;
+}
+} // namespace
+
+CpuLogReader::CpuLogReader(const std::filesystem::path& path) {
+    if (!std::filesystem::is_regular_file(path)) {
+        throw LoadError(fmt::format("CPU log {} does not exist", path.string()));
+    }
+    // Empty files can not be mapped
+    if (std::filesystem::file_size(path) == 0) {
+        return;
+    }
+    m_file = std::make_unique<const MemoryMappedFile>(path);
+    const auto data = m_file->get_data();
+    m_data = {reinterpret_cast<const char*>(data.data()), data.size()};
+    if (m_data.size() > 2 && m_data[2] != ' ') {
+        m_format = Format::GameboyDoctor;
+    }
+}
+
+CpuLogReader::CpuLogReader(CpuLogReader&&) noexcept = default;
+CpuLogReader& CpuLogReader::operator=(CpuLogReader&&) noexcept = default;
+CpuLogReader::~CpuLogReader() = default;
+
+bool CpuLogReader::next(CpuDebugState& state) {
+    if (at_end()) {
+        return false;
+    }
+    const auto end = m_data.find('\n', m_position);
+    m_line = m_data.substr(m_position, end == std::string_view::npos ? end : end - m_position);
+    m_position = end == std::string_view::npos ? m_data.size() : end + 1;
+    ++m_line_number;
+    if (m_line.ends_with('\r')) {
+        m_line.remove_suffix(1);
+    }
+    if (!parse_line(m_line, m_format, state)) {
+        throw LoadError(fmt::format("Invalid CPU log line {}: {}", m_line_number, m_line));
+    }
+    return true;
+}
+
+bool CpuLogReader::at_end() const {
+    return m_position >= m_data.size();
+}
+
+size_t CpuLogReader::get_line_number() const {
+    return m_line_number;
+}
+
+std::string_view CpuLogReader::get_line() const {
+    return m_line;
+}
+
+CpuLogReader::Format CpuLogReader::get_format() const {
+    return m_format;
+}
+
+std::string CpuLogReader::format_line(const CpuDebugState& state, Format format) {
+    if (format == Format::GameboyDoctor) {
+        return fmt::format("A:{:02X} F:{:02X} B:{:02X} C:{:02X} D:{:02X} E:{:02X} H:{:02X} "
+                           "L:{:02X} SP:{:04X} PC:{:04X} PCMEM:{:02X},{:02X},{:02X},{:02X}",
+                           state.a, state.f, state.b, state.c, state.d, state.e, state.h, state.l,
+                           state.sp, state.pc, state.mem_pc[0], state.mem_pc[1], state.mem_pc[2],
+                           state.mem_pc[3]);
+    }
+    return fmt::format("A: {:02X} F: {:02X} B: {:02X} C: {:02X} D: {:02X} E: {:02X} H: {:02X} "
+                       "L: {:02X} SP: {:04X} PC: {:04X} ({:02X} {:02X} {:02X} {:02X})",
+                       state.a, state.f, state.b, state.c, state.d, state.e, state.h, state.l,
+                       state.sp, state.pc, state.mem_pc[0], state.mem_pc[1], state.mem_pc[2],
+                       state.mem_pc[3]);
+}
+
+CpuTraceComparator::CpuTraceComparator(const std::filesystem::path& reference_log,
+                                       size_t context_lines) :
+        m_reference(reference_log), m_context_lines(context_lines) {}
+
+bool CpuTraceComparator::compare(const CpuDebugState& actual) {
+    if (m_diverged) {
+        return false;
+    }
+    CpuDebugState expected{};
+    if (!m_reference.next(expected)) {
+        m_diverged = true;
+        m_report = fmt::format("Reference ended after {} instructions, actual state {}",
+                               m_num_matched,
+                               CpuLogReader::format_line(actual, m_reference.get_format()));
+        return false;
+    }
+    if (expected != actual) {
+        report_divergence(expected, actual);
+        return false;
+    }
+    ++m_num_matched;
+    if (m_context_lines > 0) {
+        if (m_context.size() == m_context_lines) {
+            m_context.pop_front();
+        }
+        m_context.push_back(m_reference.get_line());
+    }
+    return true;
+}
+
+bool CpuTraceComparator::is_reference_finished() const {
+    return m_reference.at_end();
+}
+
+bool CpuTraceComparator::has_diverged() const {
+    return m_diverged;
+}
+
+size_t CpuTraceComparator::get_num_matched() const {
+    return m_num_matched;
+}
+
+const std::string& CpuTraceComparator::get_report() const {
+    return m_report;
+}
+
+void CpuTraceComparator::report_divergence(const CpuDebugState& expected,
+                                           const CpuDebugState& actual) {
+    m_diverged = true;
+    const auto line_number = m_reference.get_line_number();
+    m_report = fmt::format("Divergence at instruction {} (reference line {}) in{}\n", m_num_matched,
+                           line_number, describe_differences(expected, actual));
+    for (size_t i = 0; i < m_context.size(); ++i) {
+        m_report += fmt::format("  {:>10}  {}\n", line_number - m_context.size() + i, m_context[i]);
+    }
+    m_report += fmt::format("  {:>10}  {}\n", "expected", m_reference.get_line());
+    m_report += fmt::format("  {:>10}  {}\n", "actual",
+                            CpuLogReader::format_line(actual, m_reference.get_format()));
+}
+
+CpuTraceWriter::CpuTraceWriter(const std::filesystem::path& path) :
+        m_file(path, std::ios::binary | std::ios::trunc) {
+    if (!m_file) {
+        throw LoadError(fmt::format("Failed to open {} for writing a CPU trace", path.string()));
+    }
+}
+
+void CpuTraceWriter::write(const CpuDebugState& state) {
+    m_file.write(reinterpret_cast<const char*>(&state), sizeof(state));
+}
+
+CpuTraceComparison compare_cpu_trace(const std::filesystem::path& binary_trace,
+                                     const std::filesystem::path& reference_log,
+                                     size_t context_lines) {
+    CpuTraceComparator comparator{reference_log, context_lines};
+    if (!std::filesystem::is_regular_file(binary_trace)) {
+        throw LoadError(fmt::format("CPU trace {} does not exist", binary_trace.string()));
+    }
+    std::span<const uint8_t> trace;
+    std::unique_ptr<const MemoryMappedFile> trace_file;
+    if (std::filesystem::file_size(binary_trace) > 0) {
+        trace_file = std::make_unique<const MemoryMappedFile>(binary_trace);
+        trace = trace_file->get_data();
+    }
+    if (trace.size() % sizeof(CpuDebugState) != 0) {
+        throw LoadError(fmt::format("CPU trace {} has a size of {} bytes, which is not a multiple "
+                                    "of {}",
+                                    binary_trace.string(), trace.size(), sizeof(CpuDebugState)));
+    }
+    for (size_t offset = 0; offset < trace.size(); offset += sizeof(CpuDebugState)) {
+        CpuDebugState state{};
+        std::memcpy(&state, trace.data() + offset, sizeof(state));
+        if (!comparator.compare(state)) {
+            return {false, comparator.get_num_matched(), comparator.get_report()};
+        }
+    }
+    if (!comparator.is_reference_finished()) {
+        return {false, comparator.get_num_matched(),
+                fmt::format("Trace ended after {} instructions before the reference",
+                            comparator.get_num_matched())};
+    }
+    return {true, comparator.get_num_matched(), ""};
+}
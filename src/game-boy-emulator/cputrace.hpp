@@ -0,0 +1,108 @@
+#pragma once
+
+#include "cpu.hpp"
+class MemoryMappedFile;
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+ * Reads a CPU log with one line per instruction lazily from a memory mapped file, so logs of any
+ * size are parsed without loading them. Supported are the format of Cpu::get_minimal_debug_state
+ *     A: 01 F: B0 B: 00 C: 13 D: 00 E: D8 H: 01 L: 4D SP: FFFE PC: 0100 (00 C3 13 02)
+ * and the Gameboy Doctor format
+ *     A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02
+ * The format is detected from the first line. Every field has a fixed position in the line, so the
+ * hex digits are gathered into one buffer and decoded and validated eight digits at a time.
+ */
+class CpuLogReader {
+public:
+    enum class Format { DebugState, GameboyDoctor };
+
+    explicit CpuLogReader(const std::filesystem::path& path);
+    CpuLogReader(const CpuLogReader&) = delete;
+    CpuLogReader& operator=(const CpuLogReader&) = delete;
+    CpuLogReader(CpuLogReader&&) noexcept;
+    CpuLogReader& operator=(CpuLogReader&&) noexcept;
+    ~CpuLogReader();
+
+    // Parse the next line into state, returns false at the end of the log. Throws LoadError for
+    // lines which are not in the format of the log.
+    bool next(CpuDebugState& state);
+    [[nodiscard]] bool at_end() const;
+    // 1 based number of the line parsed last
+    [[nodiscard]] size_t get_line_number() const;
+    // Line parsed last without the line ending, valid as long as the reader exists.
+    [[nodiscard]] std::string_view get_line() const;
+    [[nodiscard]] Format get_format() const;
+
+    [[nodiscard]] static std::string format_line(const CpuDebugState& state, Format format);
+
+private:
+    std::unique_ptr<const MemoryMappedFile> m_file;
+    std::string_view m_data;
+    size_t m_position = 0;
+    size_t m_line_number = 0;
+    std::string_view m_line;
+    Format m_format = Format::DebugState;
+};
+
+/*
+ * Compares the CPU states of an emulator with a reference log one instruction at a time. The last
+ * reference lines are kept to show the context of the first divergence.
+ */
+class CpuTraceComparator {
+public:
+    static constexpr size_t DEFAULT_CONTEXT_LINES = 8;
+
+    explicit CpuTraceComparator(const std::filesystem::path& reference_log,
+                                size_t context_lines = DEFAULT_CONTEXT_LINES);
+
+    // Returns false if actual differs from the next reference line or if the reference has ended.
+    // After the first divergence no further states are compared.
+    bool compare(const CpuDebugState& actual);
+    // True if all lines of the reference were compared
+    [[nodiscard]] bool is_reference_finished() const;
+    [[nodiscard]] bool has_diverged() const;
+    // Number of states which matched the reference
+    [[nodiscard]] size_t get_num_matched() const;
+    // Description of the first divergence with the preceding reference lines, empty before that.
+    [[nodiscard]] const std::string& get_report() const;
+
+private:
+    CpuLogReader m_reference;
+    size_t m_context_lines;
+    std::deque<std::string_view> m_context;
+    size_t m_num_matched = 0;
+    bool m_diverged = false;
+    std::string m_report;
+
+    void report_divergence(const CpuDebugState& expected, const CpuDebugState& actual);
+};
+
+// Writes CPU states as a binary trace, which is much cheaper to produce while emulating than text.
+// The emulator writes one before every instruction if EmulatorOptions::cpu_trace_path is set.
+class CpuTraceWriter {
+public:
+    explicit CpuTraceWriter(const std::filesystem::path& path);
+    void write(const CpuDebugState& state);
+
+private:
+    std::ofstream m_file;
+};
+
+struct CpuTraceComparison {
+    bool matches = false;
+    size_t num_matched = 0;
+    std::string report;
+};
+
+// Compare a binary trace written by CpuTraceWriter with a reference log. Both are streamed from
+// memory mapped files. The trace matches if it has the same states as the reference.
+CpuTraceComparison compare_cpu_trace(
+    const std::filesystem::path& binary_trace, const std::filesystem::path& reference_log,
+    size_t context_lines = CpuTraceComparator::DEFAULT_CONTEXT_LINES);
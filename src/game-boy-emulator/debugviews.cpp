@@ -0,0 +1,226 @@
+#include "debugviews.hpp"
+#include "constants.h"
+#include "framebuffer.hpp"
+#include "graphics.hpp"
+#include "memorymap.hpp"
+#include "ppu_registers.hpp"
+#include "tilecache.hpp"
+
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <utility>
+
+namespace {
+const std::array<graphics::gb::ColorGb, 4> IDENTITY_PALETTE{
+    graphics::gb::ColorGb::White, graphics::gb::ColorGb::LightGray,
+    graphics::gb::ColorGb::DarkGray, graphics::gb::ColorGb::Black};
+
+// Get the number of a tile using tile coordinates (of 32x32) in the tile map at the given range
+size_t get_tile_number_from_map(const DebugViews::Snapshot& snapshot,
+                                PpuRegisters::TileMapAddressRange range, unsigned tile_map_x,
+                                unsigned tile_map_y) {
+    const unsigned address_offset
+        = range == PpuRegisters::TileMapAddressRange::High ? memmap::TileMap1Size : 0;
+    auto tile_map_index = address_offset + tile_map_x + (tile_map_y * 32);
+    return snapshot.registers.get_tile_number(snapshot.tile_maps[tile_map_index]);
+}
+
+void draw_tile_map(const DebugViews::Snapshot& snapshot, TileCache& tile_cache,
+                   PpuRegisters::TileMapAddressRange range,
+                   DebugViews::TileMapFramebuffer& framebuffer) {
+    auto palette = snapshot.registers.get_background_window_palette();
+    for (unsigned screen_y = 0; screen_y < constants::BACKGROUND_SIZE_PIXELS; ++screen_y) {
+        auto tile_y = screen_y / constants::PIXELS_PER_TILE;
+        auto in_tile_y = screen_y % constants::PIXELS_PER_TILE;
+        for (unsigned tile_x = 0; tile_x < 32; ++tile_x) {
+            // Get tile by reading index from tile map and fetching the decoded tile from the cache.
+            auto tile_number = get_tile_number_from_map(snapshot, range, tile_x, tile_y);
+            const auto& tile_line = tile_cache.get_line(tile_number, in_tile_y);
+            // Map the colors using the current palette and transfer this tiles line to the buffer
+            graphics::gb::apply_palette(
+                tile_line, framebuffer.row(screen_y).subspan(tile_x * 8, tile_line.size()),
+                palette);
+        }
+    }
+}
+
+void draw_background(const DebugViews::Snapshot& snapshot, TileCache& tile_cache,
+                     DebugViews::TileMapFramebuffer& framebuffer) {
+    draw_tile_map(snapshot, tile_cache, snapshot.registers.get_background_address_range(),
+                  framebuffer);
+    auto scx = snapshot.registers.get_register_value(PpuRegisters::Register::ScxRegister);
+    auto scy = snapshot.registers.get_register_value(PpuRegisters::Register::ScyRegister);
+    draw_rectangle_border(framebuffer, scx, scy, constants::SCREEN_RES_WIDTH,
+                          constants::SCREEN_RES_HEIGHT, graphics::gb::ColorGb::DebugHighlight);
+}
+
+void draw_window(const DebugViews::Snapshot& snapshot, TileCache& tile_cache,
+                 DebugViews::TileMapFramebuffer& framebuffer) {
+    draw_tile_map(snapshot, tile_cache, snapshot.registers.get_window_address_range(),
+                  framebuffer);
+    auto wx = snapshot.registers.get_register_value(PpuRegisters::Register::WxRegister) - 7;
+    auto wy = snapshot.registers.get_register_value(PpuRegisters::Register::WyRegister);
+    draw_rectangle_border(framebuffer, wx, wy, constants::SCREEN_RES_WIDTH,
+                          constants::SCREEN_RES_HEIGHT, graphics::gb::ColorGb::DebugHighlight);
+}
+
+void draw_tile_data(TileCache& tile_cache,
+                    std::array<DebugViews::TileDataFramebuffer, 3>& framebuffers) {
+    // Iterate over the three tile data blocks
+    for (unsigned block = 0; block < 3; ++block) {
+        for (unsigned tile_x = 0; tile_x < 16; ++tile_x) {
+            for (unsigned tile_y = 0; tile_y < 8; ++tile_y) {
+                auto tile_number = (block * 128) + tile_x + (tile_y * 16);
+                const auto& tile = tile_cache.get_tile(tile_number);
+                // Transfer the tile to the framebuffer without applying a palette.
+                // The framebuffer is 16x8 tiles or 128x64 pixels
+                for (unsigned in_tile_y = 0; in_tile_y < 8; ++in_tile_y) {
+                    auto y = (tile_y * 8) + in_tile_y;
+                    graphics::gb::apply_palette(
+                        tile[in_tile_y],
+                        framebuffers[block].row(y).subspan(tile_x * 8, tile[in_tile_y].size()),
+                        IDENTITY_PALETTE);
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+struct DebugViews::DecodedTiles {
+    std::array<uint8_t, memmap::TileDataSize> tile_data{};
+    TileCache tile_cache{tile_data};
+
+    // Copy the tiles which differ in the snapshot, so only they are decoded again.
+    void update(const Snapshot& snapshot) {
+        for (size_t offset = 0; offset < tile_data.size(); offset += constants::BYTES_PER_TILE) {
+            const auto tile
+                = std::span{snapshot.tile_data}.subspan(offset, constants::BYTES_PER_TILE);
+            if (!std::ranges::equal(tile, std::span{tile_data}.subspan(offset, tile.size()))) {
+                std::ranges::copy(tile, tile_data.begin() + static_cast<ptrdiff_t>(offset));
+                tile_cache.invalidate(offset);
+            }
+        }
+    }
+};
+
+DebugViews::DebugViews() = default;
+
+DebugViews::~DebugViews() {
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_stop = true;
+    }
+    m_snapshot_available.notify_one();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void DebugViews::set_visible(View view, bool visible) {
+    m_visible[static_cast<size_t>(view)].store(visible, std::memory_order_relaxed);
+}
+
+bool DebugViews::is_visible(View view) const {
+    return m_visible[static_cast<size_t>(view)].load(std::memory_order_relaxed);
+}
+
+bool DebugViews::is_any_visible() const {
+    return is_visible(View::Background) || is_visible(View::Window) || is_visible(View::TileData);
+}
+
+bool DebugViews::is_update_due(double refresh_rate_hz) const {
+    if (!is_any_visible()) {
+        return false;
+    }
+    const std::chrono::duration<double> refresh_interval{1.0 / refresh_rate_hz};
+    return std::chrono::steady_clock::now() - m_last_update >= refresh_interval;
+}
+
+void DebugViews::update(const Snapshot& snapshot) {
+    m_last_update = std::chrono::steady_clock::now();
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_pending_snapshot = snapshot;
+    }
+    if (!m_worker.joinable()) {
+        m_worker = std::thread(&DebugViews::run_worker, this);
+    }
+    m_snapshot_available.notify_one();
+}
+
+void DebugViews::release_if_hidden() {
+    if (is_any_visible()) {
+        return;
+    }
+    const std::scoped_lock lock{m_mutex};
+    if (m_rendering || m_pending_snapshot.has_value()) {
+        // Try again on the next call after the worker is done
+        return;
+    }
+    m_front.reset();
+    m_back.reset();
+    m_decoded_tiles.reset();
+}
+
+size_t DebugViews::get_allocated_memory() const {
+    const std::scoped_lock lock{m_mutex};
+    return (m_front ? sizeof(Views) : 0) + (m_back ? sizeof(Views) : 0)
+           + (m_decoded_tiles ? sizeof(DecodedTiles) : 0);
+}
+
+std::unique_lock<std::mutex> DebugViews::lock() const {
+    return std::unique_lock{m_mutex};
+}
+
+const DebugViews::Views* DebugViews::get_views() const {
+    return m_front.get();
+}
+
+uint64_t DebugViews::get_generation() const {
+    return m_generation;
+}
+
+void DebugViews::run_worker() {
+    while (true) {
+        std::unique_lock lock{m_mutex};
+        m_snapshot_available.wait(lock,
+                                  [this] { return m_stop || m_pending_snapshot.has_value(); });
+        if (m_stop) {
+            return;
+        }
+        const auto snapshot = std::move(*m_pending_snapshot);
+        m_pending_snapshot.reset();
+        if (!m_back) {
+            m_back = std::make_unique<Views>();
+        }
+        if (!m_decoded_tiles) {
+            m_decoded_tiles = std::make_unique<DecodedTiles>();
+        }
+        m_rendering = true;
+        lock.unlock();
+
+        // Views which are not visible are left as they are and the old content is shown when they
+        // are opened again, until the next update.
+        m_decoded_tiles->update(snapshot);
+        auto& tile_cache = m_decoded_tiles->tile_cache;
+        if (is_visible(View::Background)) {
+            draw_background(snapshot, tile_cache, m_back->background);
+        }
+        if (is_visible(View::Window)) {
+            draw_window(snapshot, tile_cache, m_back->window);
+        }
+        if (is_visible(View::TileData)) {
+            draw_tile_data(tile_cache, m_back->tile_data);
+        }
+
+        lock.lock();
+        std::swap(m_front, m_back);
+        ++m_generation;
+        m_rendering = false;
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "constants.h"
+#include "framebuffer.hpp"
+#include "graphics.hpp"
+#include "memorymap.hpp"
+#include "ppu_registers.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+/*
+ * Debug views of the PPU: the complete background and window tile maps and the three tile data
+ * blocks. They are rendered on a worker thread from a snapshot of VRAM, which the PPU takes on
+ * VBlank only while at least one view is visible and at most with the configured refresh rate.
+ * The worker keeps the decoded tiles between snapshots and only decodes tiles which changed.
+ * The framebuffers and decoded tiles are allocated by the first update and released while no view
+ * is visible.
+ */
+class DebugViews {
+public:
+    enum class View : uint8_t { Background, Window, TileData };
+
+    using TileMapFramebuffer = Framebuffer<graphics::gb::ColorGb, constants::BACKGROUND_SIZE_PIXELS,
+                                           constants::BACKGROUND_SIZE_PIXELS>;
+    using TileDataFramebuffer
+        = Framebuffer<graphics::gb::ColorGb,
+                      constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
+                      constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>;
+
+    struct Views {
+        TileMapFramebuffer background{graphics::gb::ColorGb::White};
+        TileMapFramebuffer window{graphics::gb::ColorGb::White};
+        std::array<TileDataFramebuffer, 3> tile_data;
+    };
+
+    // State of the PPU required to render the views
+    struct Snapshot {
+        std::array<uint8_t, memmap::TileDataSize> tile_data;
+        std::array<uint8_t, memmap::TileMapsSize> tile_maps;
+        PpuRegisters registers;
+    };
+
+    DebugViews();
+    DebugViews(const DebugViews&) = delete;
+    DebugViews& operator=(const DebugViews&) = delete;
+    DebugViews(DebugViews&&) = delete;
+    DebugViews& operator=(DebugViews&&) = delete;
+    ~DebugViews();
+
+    // Set by the frontend depending on whether the window showing the view is open.
+    void set_visible(View view, bool visible);
+    [[nodiscard]] bool is_visible(View view) const;
+    [[nodiscard]] bool is_any_visible() const;
+
+    // True if a view is visible and the last update is older than one refresh interval.
+    [[nodiscard]] bool is_update_due(double refresh_rate_hz) const;
+    // Render the views from the snapshot in the background. If the previous snapshot was not yet
+    // picked up by the worker, it is replaced.
+    void update(const Snapshot& snapshot);
+
+    // Free the framebuffers of the views while none of them is visible. They are allocated again
+    // by the next update.
+    void release_if_hidden();
+    // Size of the allocated framebuffers and decoded tiles in bytes
+    [[nodiscard]] size_t get_allocated_memory() const;
+
+    // The rendered views may only be accessed while holding the lock. Returns nullptr if the views
+    // were not rendered since they were released.
+    [[nodiscard]] std::unique_lock<std::mutex> lock() const;
+    [[nodiscard]] const Views* get_views() const;
+    // Incremented every time newly rendered views become available, which allows to skip using
+    // views which didn't change. Also requires holding the lock.
+    [[nodiscard]] uint64_t get_generation() const;
+
+private:
+    std::array<std::atomic<bool>, 3> m_visible{};
+    std::chrono::steady_clock::time_point m_last_update;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_snapshot_available;
+    // Protected by m_mutex
+    std::optional<Snapshot> m_pending_snapshot;
+    bool m_stop = false;
+    // Set while the worker renders into m_back
+    bool m_rendering = false;
+    std::unique_ptr<Views> m_front;
+    std::unique_ptr<Views> m_back;
+    // Tile data of the last rendered snapshot and its decoded tiles, used by the worker while
+    // rendering.
+    struct DecodedTiles;
+    std::unique_ptr<DecodedTiles> m_decoded_tiles;
+    uint64_t m_generation = 0;
+    // Started on the first update, so instances which never show debug views don't have a thread.
+    std::thread m_worker;
+
+    void run_worker();
+};
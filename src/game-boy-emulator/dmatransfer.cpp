@@ -3,6 +3,7 @@
 #include "bitmanipulation.hpp"
 #include "constants.h"
 #include "memorymap.hpp"
+#include "savestate.hpp"
 
 OamDmaTransfer::OamDmaTransfer(std::shared_ptr<AddressBus> address_bus,
                                std::span<std::byte, constants::OAM_DMA_NUM_BYTES> target) :
@@ -19,7 +20,7 @@ void OamDmaTransfer::start_transfer(uint16_t start_address) {
 }
 
 void OamDmaTransfer::callback_cycle() {
-    if (m_counter >= 160) {
+    if (!is_active()) {
         return;
     }
 
@@ -28,6 +29,20 @@ void OamDmaTransfer::callback_cycle() {
     m_counter++;
 }
 
+bool OamDmaTransfer::is_active() const {
+    return m_counter < m_target.size();
+}
+
 uint16_t OamDmaTransfer::get_dma_start_address(uint8_t high_byte_address) const {
     return bitmanip::word_from_bytes(high_byte_address, 0);
 }
+
+void OamDmaTransfer::save_state(StateWriter& writer) const {
+    writer.write(m_start_address);
+    writer.write(m_counter);
+}
+
+void OamDmaTransfer::load_state(StateReader& reader) {
+    reader.read(m_start_address);
+    reader.read(m_counter);
+}
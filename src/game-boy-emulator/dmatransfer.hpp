@@ -2,6 +2,8 @@
 
 #include "addressbus.hpp"
 #include "constants.h"
+class StateWriter;
+class StateReader;
 #include <memory>
 #include <span>
 #include <utility>
@@ -28,5 +30,10 @@ public:
     // otherwise.
     void callback_cycle();
 
+    [[nodiscard]] bool is_active() const;
+
     [[nodiscard]] uint16_t get_dma_start_address(uint8_t high_byte_address) const;
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 };
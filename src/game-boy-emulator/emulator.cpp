@@ -4,6 +4,7 @@
 #include "bootrom.hpp"
 #include "cartridge.hpp"
 #include "cpu.hpp"
+#include "cputrace.hpp"
 #include "exceptions.hpp"
 #include "options.hpp"
 #include "ppu.hpp"
@@ -14,9 +15,12 @@
 #include "interrupthandler.hpp"
 #include "joypad.hpp"
 #include "io.hpp"
+#include "savestate.hpp"
 
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <utility>
 
 void EmulatorState::reset() {
@@ -25,8 +29,11 @@ void EmulatorState::reset() {
     frame_count = 0;
 }
 
-Emulator::Emulator(EmulatorOptions options) :
+Emulator::Emulator(EmulatorOptions options) : Emulator(options, spdlog::get("")) {}
+
+Emulator::Emulator(EmulatorOptions options, std::shared_ptr<spdlog::logger> logger) :
         m_options(options),
+        m_logger(std::move(logger)),
         m_address_bus(std::make_shared<AddressBus>(this)),
         m_ram(std::make_shared<Ram>(this)),
         m_cpu(std::make_shared<Cpu>(this)),
@@ -35,12 +42,27 @@ Emulator::Emulator(EmulatorOptions options) :
         m_interrupt_handler(std::make_shared<InterruptHandler>(this)),
         m_timer(std::make_shared<Timer>(this)),
         m_serial_port(std::make_shared<SerialPort>(this)),
-        m_joypad(std::make_shared<Joypad>(this)),
-        m_logger(spdlog::get("")) {}
+        m_joypad(std::make_shared<Joypad>(this)) {
+    if (!m_options.cpu_trace_path.empty()) {
+        m_cpu_trace = std::make_shared<CpuTraceWriter>(m_options.cpu_trace_path);
+    }
+}
 
 void Emulator::load_game(const std::filesystem::path& rom_path) {
     m_state.rom_file_path = rom_path;
     m_cartridge = std::make_shared<cartridge::Cartridge>(this, rom_path);
+    m_address_bus->set_cartridge_banks(m_cartridge->get_mapped_banks());
+    // A link cable connected to the previous game is disconnected
+    m_serial_port->set_linked(false);
+    m_cpu->set_initial_state();
+    m_state.is_booting = false;
+}
+
+void Emulator::load_game(std::shared_ptr<const std::vector<uint8_t>> rom) {
+    m_state.rom_file_path.reset();
+    m_cartridge = std::make_shared<cartridge::Cartridge>(this, std::move(rom));
+    m_address_bus->set_cartridge_banks(m_cartridge->get_mapped_banks());
+    m_serial_port->set_linked(false);
     m_cpu->set_initial_state();
     m_state.is_booting = false;
 }
@@ -60,6 +82,8 @@ void Emulator::load_boot_game(const std::filesystem::path& boot_rom_path,
     load_boot(boot_rom_path);
     m_state.rom_file_path = game_rom_path;
     m_cartridge = std::make_shared<cartridge::Cartridge>(this, game_rom_path);
+    m_address_bus->set_cartridge_banks(m_cartridge->get_mapped_banks());
+    m_serial_port->set_linked(false);
 }
 
 void Emulator::run() {
@@ -92,9 +116,21 @@ void Emulator::elapse_cycle() {
     m_timer->cycle_elapsed_callback(m_state.cycles_m);
     m_ppu->cycle_elapsed_callback(m_state.cycles_m);
     m_apu->cycle_elapsed_callback(m_state.cycles_m);
-    if (m_audio_function && m_options.sound_enabled) {
-        m_audio_function(m_apu->get_sample());
+    if (m_state.cycles_m % AUDIO_BATCH_CYCLES == 0) {
+        pass_audio_samples();
+    }
+}
+
+void Emulator::pass_audio_samples() {
+    const auto samples = m_apu->get_samples();
+    if (m_audio_buffer_enabled) {
+        m_audio_buffer.insert(m_audio_buffer.end(), samples.begin(), samples.end());
+    } else if (m_audio_function) {
+        for (const auto& sample : samples) {
+            m_audio_function(sample);
+        }
     }
+    m_apu->clear_samples();
 }
 
 std::shared_ptr<Ppu> Emulator::get_ppu() const {
@@ -112,6 +148,9 @@ CpuDebugState Emulator::get_debug_state() const {
 bool Emulator::step() {
     try {
         if (!m_state.halted) {
+            if (m_cpu_trace) {
+                m_cpu_trace->write(m_cpu->get_debug_state());
+            }
             m_cpu->step();
         } else {
             elapse_cycle();
@@ -124,6 +163,18 @@ bool Emulator::step() {
     }
 }
 
+bool Emulator::run_frames(size_t num_frames) {
+    const auto target_frame = m_state.frame_count + num_frames;
+    while (m_state.frame_count < target_frame) {
+        if (!step()) {
+            return false;
+        }
+    }
+    // The audio buffer contains all samples of the frames afterwards
+    pass_audio_samples();
+    return true;
+}
+
 opcodes::Instruction Emulator::get_current_instruction() const {
     return m_cpu->get_current_instruction();
 }
@@ -175,7 +226,10 @@ void Emulator::reset_state() {
     // Reset all subcomponents which have mutable state that is relevant for emulation or which have side effects on
     // destruction (such as serial port printing received data).
     // Resetting RAM does not matter, since the game should not rely on its state on boot anyway.
+    // The game stays the same, so a connected link cable stays connected.
+    const auto linked = m_serial_port->is_linked();
     m_serial_port = std::make_shared<SerialPort>(this);
+    m_serial_port->set_linked(linked);
 }
 
 const EmulatorOptions& Emulator::get_options() const {
@@ -202,6 +256,10 @@ std::shared_ptr<Joypad> Emulator::get_joypad() const {
     return m_joypad;
 }
 
+std::shared_ptr<spdlog::logger> Emulator::get_logger() const {
+    return m_logger;
+}
+
 void Emulator::draw() {
     m_cartridge->sync();
     if (m_draw_function) {
@@ -210,6 +268,17 @@ void Emulator::draw() {
     m_state.frame_count++;
 }
 
+bool Emulator::is_frame_skipped() const {
+    const auto frame_skip = static_cast<size_t>(std::max(m_options.get_frame_skip(), 0));
+    return m_state.frame_count % (frame_skip + 1) != 0;
+}
+
+size_t Emulator::get_memory_usage() const {
+    return sizeof(Emulator) + sizeof(AddressBus) + sizeof(Ram) + sizeof(BootRom) + sizeof(Cpu)
+           + sizeof(Apu) + sizeof(InterruptHandler) + sizeof(Timer) + sizeof(SerialPort)
+           + sizeof(Joypad) + m_ppu->get_memory_usage();
+}
+
 void Emulator::set_draw_function(std::function<void()> f) {
     m_draw_function = std::move(f);
 }
@@ -227,3 +296,96 @@ void Emulator::debug() {
 void Emulator::set_audio_function(std::function<void(SampleFrame)> f) {
     m_audio_function = std::move(f);
 }
+
+void Emulator::set_audio_buffer_enabled(bool enabled) {
+    m_audio_buffer_enabled = enabled;
+}
+
+std::span<const SampleFrame> Emulator::get_audio_buffer() const {
+    return m_audio_buffer;
+}
+
+void Emulator::clear_audio_buffer() {
+    m_audio_buffer.clear();
+}
+
+namespace {
+constexpr uint32_t STATE_MAGIC = 0x53544247; // "GBTS"
+// Has to be incremented whenever the saved state of a component changes
+constexpr uint32_t STATE_VERSION = 3;
+} // namespace
+
+std::vector<uint8_t> Emulator::save_state() const {
+    if (!m_cartridge) {
+        throw LogicError("Can't save state without a game");
+    }
+    if (m_state.is_booting) {
+        throw LogicError("Can't save state while the boot ROM is running");
+    }
+    StateWriter writer;
+    write_state(writer);
+    return writer.take();
+}
+
+void Emulator::load_state(std::span<const uint8_t> state) {
+    // Components are restored one after another, keep the current state to undo a partial load.
+    auto backup = save_state();
+    try {
+        StateReader reader{state};
+        read_state(reader);
+        if (!reader.at_end()) {
+            throw LoadError("Save state is larger than expected, it was saved for another game");
+        }
+    } catch (const LoadError&) {
+        StateReader backup_reader{backup};
+        read_state(backup_reader);
+        throw;
+    }
+}
+
+void Emulator::restore_state(std::span<const uint8_t> state) {
+    StateReader reader{state};
+    read_state(reader);
+}
+
+void Emulator::write_state(StateWriter& writer) const {
+    writer.write(STATE_MAGIC);
+    writer.write(STATE_VERSION);
+    writer.write(m_state.cycles_m);
+    writer.write(m_state.instructions_executed);
+    writer.write(m_state.frame_count);
+    writer.write(m_state.halted);
+    m_cpu->save_state(writer);
+    m_ram->save_state(writer);
+    m_ppu->save_state(writer);
+    m_apu->save_state(writer);
+    m_timer->save_state(writer);
+    m_interrupt_handler->save_state(writer);
+    m_joypad->save_state(writer);
+    m_serial_port->save_state(writer);
+    m_cartridge->save_state(writer);
+}
+
+void Emulator::read_state(StateReader& reader) {
+    if (reader.read<uint32_t>() != STATE_MAGIC) {
+        throw LoadError("Not a save state");
+    }
+    if (const auto version = reader.read<uint32_t>(); version != STATE_VERSION) {
+        throw LoadError(fmt::format("Save state version {} is not supported, expected {}", version,
+                                    STATE_VERSION));
+    }
+    // The cycle count is restored first, the RTC can follow the emulated time.
+    reader.read(m_state.cycles_m);
+    reader.read(m_state.instructions_executed);
+    reader.read(m_state.frame_count);
+    reader.read(m_state.halted);
+    m_cpu->load_state(reader);
+    m_ram->load_state(reader);
+    m_ppu->load_state(reader);
+    m_apu->load_state(reader);
+    m_timer->load_state(reader);
+    m_interrupt_handler->load_state(reader);
+    m_joypad->load_state(reader);
+    m_serial_port->load_state(reader);
+    m_cartridge->load_state(reader);
+}
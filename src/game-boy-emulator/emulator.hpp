@@ -6,6 +6,8 @@
 #include <memory>
 #include <functional>
 #include <filesystem>
+#include <span>
+#include <vector>
 
 namespace opcodes {
 struct Instruction;
@@ -26,21 +28,22 @@ class InterruptHandler;
 #include "spdlog/fwd.h"
 struct CpuDebugState;
 class Joypad;
+class CpuTraceWriter;
+class StateWriter;
+class StateReader;
 
 struct EmulatorState {
     // Number of m cycles since execution start
     size_t cycles_m = 0;
     // Number of instructions since execution start
     size_t instructions_executed = 0;
-    // Number of frames rendered
+    // Number of frames emulated, including frames skipped by the frame skip setting
     size_t frame_count = 0;
     // Currently running boot rom
     bool is_booting = true;
     bool halted = false;
     // Path to game rom file
     std::optional<std::filesystem::path> rom_file_path;
-    // When changing the game the new path is stored here before the new game is loaded.
-    std::optional<std::filesystem::path> new_rom_file_path;
     std::string game_title;
 
     void reset();
@@ -52,16 +55,25 @@ struct EmulatorState {
 class Emulator {
 public:
     explicit Emulator(EmulatorOptions options);
+    // All components log to the given logger instead of the default logger, so instances running
+    // on different threads don't share it.
+    Emulator(EmulatorOptions options, std::shared_ptr<spdlog::logger> logger);
     // Only load boot rom file.
     void load_boot(const std::filesystem::path& rom_path);
     // Don't run boot rom and use initial values for registers/flags/memory.
     void load_game(const std::filesystem::path& rom_path);
+    // Run a game from memory, the ROM can be shared by many instances. Cartridge RAM is not saved
+    // to a file.
+    void load_game(std::shared_ptr<const std::vector<uint8_t>> rom);
     // Actually run boot rom to initialize emulator and hand off control to game after booting.
     void load_boot_game(const std::filesystem::path& boot_rom_path,
                         const std::filesystem::path& game_rom_path);
 
     void run();
     bool step();
+    // Step until the given number of frames was finished. Returns false if emulation stopped
+    // because of an error.
+    bool run_frames(size_t num_frames = 1);
 
     [[nodiscard]] bool is_booting() const;
     void signal_boot_ended();
@@ -93,16 +105,38 @@ public:
     [[nodiscard]] std::shared_ptr<SerialPort> get_serial_port() const;
     [[nodiscard]] std::shared_ptr<Apu> get_apu() const;
     [[nodiscard]] std::shared_ptr<Joypad> get_joypad() const;
+    [[nodiscard]] std::shared_ptr<spdlog::logger> get_logger() const;
 
     void draw();
+    // True if the current frame is only emulated and its pixels are not rendered because of the
+    // frame skip setting.
+    [[nodiscard]] bool is_frame_skipped() const;
+    // Memory used by one emulator instance in bytes, without cartridge ROM and RAM.
+    [[nodiscard]] size_t get_memory_usage() const;
     void set_draw_function(std::function<void()> f);
     void debug();
     void set_debug_function(std::function<void()> f);
     void set_audio_function(std::function<void(SampleFrame s)> f);
+    // Collect the samples in an internal buffer instead of passing them to the audio function. The
+    // buffer grows until it is cleared, clearing keeps the allocated memory.
+    void set_audio_buffer_enabled(bool enabled);
+    [[nodiscard]] std::span<const SampleFrame> get_audio_buffer() const;
+    void clear_audio_buffer();
+
+    // Snapshot of the complete emulation state. Options and callbacks are not part of it. A state
+    // can only be loaded by the same build of the emulator running the same game.
+    [[nodiscard]] std::vector<uint8_t> save_state() const;
+    // Throws LoadError if the state is invalid, the emulator is unchanged in that case.
+    void load_state(std::span<const uint8_t> state);
+    // Load a state saved by an emulator running the same game. No backup is kept to undo a failed
+    // load, which makes copying states between instances cheaper than load_state.
+    void restore_state(std::span<const uint8_t> state);
 
 private:
     EmulatorState m_state;
     EmulatorOptions m_options;
+    // Declared before the components which get it from the emulator
+    std::shared_ptr<spdlog::logger> m_logger;
     std::shared_ptr<cartridge::Cartridge> m_cartridge;
     std::shared_ptr<BootRom> m_boot_rom;
     std::shared_ptr<AddressBus> m_address_bus;
@@ -114,13 +148,23 @@ private:
     std::shared_ptr<Timer> m_timer;
     std::shared_ptr<SerialPort> m_serial_port;
     std::shared_ptr<Joypad> m_joypad;
-    std::shared_ptr<spdlog::logger> m_logger;
+    // Only exists if a CPU trace path was set in the options
+    std::shared_ptr<CpuTraceWriter> m_cpu_trace;
 
     // Function which is called on every VBlank. Can be used to draw the game framebuffer.
     std::function<void()> m_draw_function;
     // Function which is called on LD B,B instruction, which is used sort of as a debug
     // breakpoint.
     std::function<void()> m_debug_function;
-    // Function which is called with a new sample generated from the APU every cycle.
+    // Function which is called with every sample generated from the APU, one sample per cycle.
     std::function<void(SampleFrame s)> m_audio_function;
+    bool m_audio_buffer_enabled = false;
+    std::vector<SampleFrame> m_audio_buffer;
+    // The APU generates samples in batches, they are passed on every AUDIO_BATCH_CYCLES M cycles
+    // and at the end of run_frames.
+    static constexpr size_t AUDIO_BATCH_CYCLES = 1024;
+    void pass_audio_samples();
+
+    void write_state(StateWriter& writer) const;
+    void read_state(StateReader& reader);
 };
@@ -0,0 +1,199 @@
+#include "emulatorlanes.hpp"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "joypad.hpp"
+#include "ppu.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+EmulatorLanes::EmulatorLanes(std::shared_ptr<const std::vector<uint8_t>> rom,
+                             std::span<const uint8_t> initial_state, size_t num_lanes,
+                             EmulatorOptions options) :
+        m_rom(std::move(rom)), m_options(options), m_lane_groups(num_lanes, 0) {
+    if (num_lanes == 0) {
+        throw LogicError("Emulator lanes need at least one lane");
+    }
+    auto emulator = create_emulator();
+    if (!initial_state.empty()) {
+        emulator->load_state(initial_state);
+    }
+    m_lane_keys.assign(num_lanes, emulator->get_joypad()->get_pressed_keys());
+    m_groups.push_back({.emulator = std::move(emulator)});
+}
+
+EmulatorLanes::~EmulatorLanes() = default;
+
+size_t EmulatorLanes::size() const {
+    return m_lane_groups.size();
+}
+
+size_t EmulatorLanes::get_num_groups() const {
+    return m_groups.size();
+}
+
+bool EmulatorLanes::step_frame(std::span<const uint8_t> keys) {
+    if (keys.size() != size()) {
+        throw LogicError(fmt::format("{} emulator lanes got {} keys", size(), keys.size()));
+    }
+    std::vector<std::vector<size_t>> group_lanes(m_groups.size());
+    for (size_t lane = 0; lane < size(); ++lane) {
+        group_lanes[m_lane_groups[lane]].push_back(lane);
+    }
+    bool any_failed = false;
+    // Groups split off while stepping were already stepped
+    for (size_t group = 0; group < group_lanes.size(); ++group) {
+        if (m_groups[group].failed) {
+            continue;
+        }
+        if (!step_group(group, group_lanes[group], keys)) {
+            any_failed = true;
+        }
+    }
+    std::ranges::copy(keys, m_lane_keys.begin());
+    merge_groups();
+    return !any_failed;
+}
+
+const EmulatorLanes::Screen& EmulatorLanes::get_screen(size_t lane) const {
+    return m_groups[m_lane_groups.at(lane)].emulator->get_ppu()->get_game();
+}
+
+std::vector<uint8_t> EmulatorLanes::save_state(size_t lane) const {
+    auto& emulator = *m_groups[m_lane_groups.at(lane)].emulator;
+    // The held keys are part of the state, but the lanes of a group can differ in them
+    auto& joypad = *emulator.get_joypad();
+    const auto group_keys = joypad.get_pressed_keys();
+    joypad.restore_pressed_keys(m_lane_keys[lane]);
+    auto state = emulator.save_state();
+    joypad.restore_pressed_keys(group_keys);
+    return state;
+}
+
+bool EmulatorLanes::has_failed(size_t lane) const {
+    return m_groups[m_lane_groups.at(lane)].failed;
+}
+
+std::unique_ptr<Emulator> EmulatorLanes::create_emulator() {
+    if (!m_spare_emulators.empty()) {
+        auto emulator = std::move(m_spare_emulators.back());
+        m_spare_emulators.pop_back();
+        return emulator;
+    }
+    auto emulator = std::make_unique<Emulator>(m_options);
+    emulator->load_game(m_rom);
+    return emulator;
+}
+
+uint8_t EmulatorLanes::get_key_difference(size_t lane, size_t other_lane,
+                                          std::span<const uint8_t> keys) const {
+    // Newly pressed keys can request an interrupt, released keys have no effect by themselves.
+    const auto pressed = static_cast<uint8_t>(keys[lane] & ~m_lane_keys[lane]);
+    const auto other_pressed = static_cast<uint8_t>(keys[other_lane] & ~m_lane_keys[other_lane]);
+    return static_cast<uint8_t>((keys[lane] ^ keys[other_lane]) | (pressed ^ other_pressed));
+}
+
+bool EmulatorLanes::run_lane(Emulator& emulator, size_t lane,
+                             std::span<const uint8_t> keys) const {
+    auto& joypad = *emulator.get_joypad();
+    joypad.restore_pressed_keys(m_lane_keys[lane]);
+    joypad.clear_observed_keys();
+    joypad.set_pressed_keys(keys[lane]);
+    return emulator.run_frames();
+}
+
+bool EmulatorLanes::step_group(size_t group, std::span<const size_t> lanes,
+                               std::span<const uint8_t> keys) {
+    const auto first_lane = lanes.front();
+    const bool same_keys = std::ranges::all_of(lanes, [&](size_t lane) {
+        return get_key_difference(first_lane, lane, keys) == 0;
+    });
+    // Lanes which have to be split off run from the state before the frame
+    std::vector<uint8_t> state_before;
+    if (!same_keys) {
+        state_before = m_groups[group].emulator->save_state();
+    }
+    auto& emulator = *m_groups[group].emulator;
+    if (!run_lane(emulator, first_lane, keys)) {
+        m_groups[group].failed = true;
+        return false;
+    }
+    if (same_keys) {
+        return true;
+    }
+
+    struct Split {
+        // Lane whose keys the group was stepped with
+        size_t lane;
+        uint8_t observed_keys;
+    };
+    // Lanes join the first group which didn't observe the keys they differ in
+    std::vector<Split> splits{{first_lane, emulator.get_joypad()->get_observed_keys()}};
+    bool all_succeeded = true;
+    for (const auto lane : lanes.subspan(1)) {
+        const auto split = std::ranges::find_if(splits, [&](const Split& s) {
+            return (get_key_difference(s.lane, lane, keys) & s.observed_keys) == 0;
+        });
+        if (split != splits.end()) {
+            m_lane_groups[lane] = m_lane_groups[split->lane];
+            continue;
+        }
+        auto split_emulator = create_emulator();
+        split_emulator->restore_state(state_before);
+        const bool succeeded = run_lane(*split_emulator, lane, keys);
+        all_succeeded = all_succeeded && succeeded;
+        splits.push_back({lane, split_emulator->get_joypad()->get_observed_keys()});
+        m_groups.push_back({.emulator = std::move(split_emulator), .failed = !succeeded});
+        m_lane_groups[lane] = m_groups.size() - 1;
+    }
+    return all_succeeded;
+}
+
+void EmulatorLanes::merge_groups() {
+    if (m_groups.size() == 1) {
+        return;
+    }
+    std::vector<std::vector<uint8_t>> states(m_groups.size());
+    std::unordered_map<std::string_view, size_t> groups_by_state;
+    std::vector<size_t> merged_into(m_groups.size());
+    std::iota(merged_into.begin(), merged_into.end(), size_t{0});
+    for (size_t group = 0; group < m_groups.size(); ++group) {
+        // Failed groups are kept as they are, they are not stepped anymore.
+        if (m_groups[group].failed) {
+            continue;
+        }
+        // Compare the states without the held keys, which are kept for every lane
+        auto& joypad = *m_groups[group].emulator->get_joypad();
+        const auto group_keys = joypad.get_pressed_keys();
+        joypad.restore_pressed_keys(0);
+        states[group] = m_groups[group].emulator->save_state();
+        joypad.restore_pressed_keys(group_keys);
+        const std::string_view state{reinterpret_cast<const char*>(states[group].data()),
+                                     states[group].size()};
+        const auto [it, inserted] = groups_by_state.try_emplace(state, group);
+        if (!inserted) {
+            merged_into[group] = it->second;
+        }
+    }
+
+    // Compact the remaining groups and move the emulators of merged groups to the spares
+    std::vector<size_t> new_index(m_groups.size());
+    std::vector<Group> groups;
+    for (size_t group = 0; group < m_groups.size(); ++group) {
+        if (merged_into[group] == group) {
+            new_index[group] = groups.size();
+            groups.push_back(std::move(m_groups[group]));
+        } else {
+            m_spare_emulators.push_back(std::move(m_groups[group].emulator));
+        }
+    }
+    for (auto& group : m_lane_groups) {
+        group = new_index[merged_into[group]];
+    }
+    m_groups = std::move(groups);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "constants.h"
+#include "framebuffer.hpp"
+#include "graphics.hpp"
+#include "options.hpp"
+class Emulator;
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+/*
+ * Runs lanes of one game in lockstep, all starting from a common save state and each receiving
+ * its own keys, for example to explore input sequences while fuzzing. Lanes whose states are
+ * identical except for the held keys share one emulator, so they are only emulated once.
+ * A group is stepped with the keys of its first lane while the joypad records which keys the game
+ * could observe, by reading them or through the joypad interrupt. Only lanes whose keys differ in
+ * an observed key are split off: they are run from a copy of the state before the frame. After
+ * every frame, groups whose states became identical again are merged.
+ * Keys which the game doesn't look at therefore don't split lanes, while every other distinct
+ * input costs one emulated frame and copying the state.
+ */
+class EmulatorLanes {
+public:
+    using Screen = Framebuffer<graphics::gb::ColorGb, constants::SCREEN_RES_WIDTH,
+                               constants::SCREEN_RES_HEIGHT>;
+
+    // An empty initial state starts the game from the beginning.
+    EmulatorLanes(std::shared_ptr<const std::vector<uint8_t>> rom,
+                  std::span<const uint8_t> initial_state, size_t num_lanes,
+                  EmulatorOptions options = EmulatorOptions::headless());
+    EmulatorLanes(const EmulatorLanes&) = delete;
+    EmulatorLanes& operator=(const EmulatorLanes&) = delete;
+    EmulatorLanes(EmulatorLanes&&) = default;
+    EmulatorLanes& operator=(EmulatorLanes&&) = default;
+    ~EmulatorLanes();
+
+    [[nodiscard]] size_t size() const;
+    // Number of emulators currently running, at most the number of lanes
+    [[nodiscard]] size_t get_num_groups() const;
+
+    // Advance all lanes by one frame, keys contains the held keys of every lane as passed to
+    // Joypad::set_pressed_keys. Returns false if a lane failed during this frame. Failed lanes are
+    // not stepped again.
+    bool step_frame(std::span<const uint8_t> keys);
+
+    [[nodiscard]] const Screen& get_screen(size_t lane) const;
+    [[nodiscard]] std::vector<uint8_t> save_state(size_t lane) const;
+    [[nodiscard]] bool has_failed(size_t lane) const;
+
+private:
+    struct Group {
+        std::unique_ptr<Emulator> emulator;
+        bool failed = false;
+    };
+
+    std::shared_ptr<const std::vector<uint8_t>> m_rom;
+    EmulatorOptions m_options;
+    std::vector<Group> m_groups;
+    // Index into m_groups for every lane
+    std::vector<size_t> m_lane_groups;
+    // Keys held by every lane during the last frame. Lanes of a group can differ in them, the
+    // joypad of the group's emulator is set to the keys of the lane it emulates.
+    std::vector<uint8_t> m_lane_keys;
+    // Emulators of merged groups, reused for the next split instead of creating new ones
+    std::vector<std::unique_ptr<Emulator>> m_spare_emulators;
+
+    [[nodiscard]] std::unique_ptr<Emulator> create_emulator();
+    // Keys in which two lanes differ this frame, either held or newly pressed ones
+    [[nodiscard]] uint8_t get_key_difference(size_t lane, size_t other_lane,
+                                             std::span<const uint8_t> keys) const;
+    // Run one frame of the emulator with the keys of the lane, returns false on failure
+    bool run_lane(Emulator& emulator, size_t lane, std::span<const uint8_t> keys) const;
+    // Step the group with the keys of its first lane and move lanes which would have run
+    // differently to new groups. Returns false if a group failed.
+    bool step_group(size_t group, std::span<const size_t> lanes, std::span<const uint8_t> keys);
+    void merge_groups();
+};
@@ -0,0 +1,172 @@
+#include "emulatorpool.hpp"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "io.hpp"
+#include "joypad.hpp"
+#include "ppu.hpp"
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/stdout_sinks.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+void pin_current_thread(size_t core) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core % std::max(std::thread::hardware_concurrency(), 1U), &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        spdlog::warn("Failed to pin emulator pool worker to core {}", core);
+    }
+#else
+    (void)core;
+#endif
+}
+} // namespace
+
+EmulatorPool::EmulatorPool(const std::filesystem::path& rom_path, size_t num_instances,
+                           Options options) :
+        EmulatorPool(EmulatorIo().load_rom_file(rom_path), num_instances, options) {}
+
+EmulatorPool::EmulatorPool(std::shared_ptr<const std::vector<uint8_t>> rom, size_t num_instances,
+                           Options options) :
+        m_rom(std::move(rom)),
+        m_options(options),
+        m_emulators(num_instances),
+        m_failed(num_instances, 0) {
+    auto num_threads = m_options.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    num_threads = std::max(std::min(num_threads, num_instances), size_t{1});
+    m_worker_errors.resize(num_threads);
+    m_workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        m_workers.emplace_back(&EmulatorPool::run_worker, this, i);
+    }
+    try {
+        run_on_workers([this](size_t index) { create_instance(index); });
+    } catch (...) {
+        stop_workers();
+        throw;
+    }
+}
+
+EmulatorPool::~EmulatorPool() {
+    stop_workers();
+}
+
+size_t EmulatorPool::size() const {
+    return m_emulators.size();
+}
+
+size_t EmulatorPool::get_num_threads() const {
+    return m_workers.size();
+}
+
+void EmulatorPool::create_instance(size_t index) {
+    // Sinks are not shared either, so instances never wait for each other while logging.
+    auto logger = std::make_shared<spdlog::logger>(
+        fmt::format("emulator{}", index), std::make_shared<spdlog::sinks::stderr_sink_st>());
+    logger->set_level(spdlog::get_level());
+    auto& emulator = m_emulators[index].emplace(m_options.emulator_options, std::move(logger));
+    emulator.load_game(m_rom);
+}
+
+bool EmulatorPool::step_frame(std::span<const uint8_t> keys, std::span<uint8_t> observations) {
+    if (keys.size() != size() || observations.size() != size() * FRAME_SIZE) {
+        throw LogicError(fmt::format("Pool of {} instances got {} keys and {} observation bytes",
+                                     size(), keys.size(), observations.size()));
+    }
+    std::atomic<bool> any_failed = false;
+    run_on_workers([&](size_t index) {
+        if (m_failed[index] != 0) {
+            return;
+        }
+        auto& emulator = *m_emulators[index];
+        emulator.get_joypad()->set_pressed_keys(keys[index]);
+        if (!emulator.run_frames()) {
+            m_failed[index] = 1;
+            any_failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+        emulator.get_ppu()->get_game().copy_into(observations.data() + index * FRAME_SIZE);
+    });
+    return !any_failed.load(std::memory_order_relaxed);
+}
+
+Emulator& EmulatorPool::get_emulator(size_t index) {
+    return *m_emulators.at(index);
+}
+
+bool EmulatorPool::has_failed(size_t index) const {
+    return m_failed.at(index) != 0;
+}
+
+void EmulatorPool::run_on_workers(const std::function<void(size_t)>& job) {
+    m_job = &job;
+    std::ranges::fill(m_worker_errors, nullptr);
+    m_pending_workers.store(m_workers.size(), std::memory_order_relaxed);
+    // Publishes the job to the workers
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+    for (auto pending = m_pending_workers.load(std::memory_order_acquire); pending != 0;
+         pending = m_pending_workers.load(std::memory_order_acquire)) {
+        m_pending_workers.wait(pending, std::memory_order_acquire);
+    }
+    m_job = nullptr;
+    for (const auto& error : m_worker_errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void EmulatorPool::run_worker(size_t worker_index) {
+    if (m_options.pin_threads) {
+        pin_current_thread(worker_index);
+    }
+    // Every worker steps a contiguous range of instances
+    const auto num_workers = m_worker_errors.size();
+    const auto begin = worker_index * size() / num_workers;
+    const auto end = (worker_index + 1) * size() / num_workers;
+    uint64_t generation = 0;
+    while (true) {
+        // The next job can only start after all workers finished the previous one, so no
+        // generation is missed.
+        m_generation.wait(generation, std::memory_order_acquire);
+        generation = m_generation.load(std::memory_order_acquire);
+        if (m_stop.load(std::memory_order_relaxed)) {
+            return;
+        }
+        try {
+            for (auto i = begin; i < end; ++i) {
+                (*m_job)(i);
+            }
+        } catch (...) {
+            m_worker_errors[worker_index] = std::current_exception();
+        }
+        if (m_pending_workers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_pending_workers.notify_one();
+        }
+    }
+}
+
+void EmulatorPool::stop_workers() {
+    m_stop = true;
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
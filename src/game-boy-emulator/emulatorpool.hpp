@@ -0,0 +1,87 @@
+#pragma once
+
+#include "constants.h"
+#include "options.hpp"
+class Emulator;
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+/*
+ * Runs many instances of the same game side by side, for example as environments for
+ * reinforcement learning. Every call to step_frame advances all instances by one frame. The
+ * instances are split into contiguous ranges, each stepped by one worker thread which is optionally
+ * pinned to a core. Workers also create their instances, so the memory is allocated close to the
+ * core using it.
+ * Instances share nothing but the read-only ROM: each has its own logger and cartridge RAM is kept
+ * in memory instead of being saved.
+ */
+class EmulatorPool {
+public:
+    static constexpr size_t FRAME_SIZE = constants::SCREEN_RES_WIDTH * constants::SCREEN_RES_HEIGHT;
+
+    struct Options {
+        // 0 starts one worker per hardware thread. Never more workers than instances are started.
+        size_t num_threads = 0;
+        // Pin worker n to core n, only supported on Linux.
+        bool pin_threads = true;
+        EmulatorOptions emulator_options = EmulatorOptions::headless();
+    };
+
+    EmulatorPool(const std::filesystem::path& rom_path, size_t num_instances, Options options);
+    EmulatorPool(std::shared_ptr<const std::vector<uint8_t>> rom, size_t num_instances,
+                 Options options);
+    EmulatorPool(const EmulatorPool&) = delete;
+    EmulatorPool& operator=(const EmulatorPool&) = delete;
+    EmulatorPool(EmulatorPool&&) = delete;
+    EmulatorPool& operator=(EmulatorPool&&) = delete;
+    ~EmulatorPool();
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t get_num_threads() const;
+
+    // Advance all instances by one frame. keys contains the held keys of every instance as passed
+    // to Joypad::set_pressed_keys. The screen of every instance is written to observations as
+    // [instance][y][x], one color index 0..3 per pixel.
+    // Returns false if an instance failed during this frame. Failed instances are not stepped again
+    // and keep their last screen.
+    bool step_frame(std::span<const uint8_t> keys, std::span<uint8_t> observations);
+
+    // Only access instances between calls to step_frame.
+    [[nodiscard]] Emulator& get_emulator(size_t index);
+    [[nodiscard]] bool has_failed(size_t index) const;
+
+private:
+    std::shared_ptr<const std::vector<uint8_t>> m_rom;
+    Options m_options;
+    // Constructed by the workers. Never resized, the components of an instance point to it.
+    std::vector<std::optional<Emulator>> m_emulators;
+    // One byte per instance, only written by the worker owning the instance.
+    std::vector<uint8_t> m_failed;
+
+    std::vector<std::thread> m_workers;
+    // Exception thrown by each worker during the current job
+    std::vector<std::exception_ptr> m_worker_errors;
+    // Incremented to start a job on all workers
+    std::atomic<uint64_t> m_generation = 0;
+    // Number of workers which did not finish the current job
+    std::atomic<size_t> m_pending_workers = 0;
+    std::atomic<bool> m_stop = false;
+    // Job of the current generation, called for every instance of a worker
+    const std::function<void(size_t)>* m_job = nullptr;
+
+    // Run job for every instance on the workers and wait for them. Rethrows the first exception
+    // thrown by a job.
+    void run_on_workers(const std::function<void(size_t)>& job);
+    void run_worker(size_t worker_index);
+    void stop_workers();
+    void create_instance(size_t index);
+};
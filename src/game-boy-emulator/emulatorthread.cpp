@@ -0,0 +1,162 @@
+#include "emulatorthread.hpp"
+#include "emulator.hpp"
+#include "ppu.hpp"
+#include "joypad.hpp"
+#include "constants.h"
+
+#include "spdlog/spdlog.h"
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+EmulatorThread::EmulatorThread(Emulator& emulator) :
+        m_emulator(emulator), m_logger(spdlog::get("")) {
+    m_emulator.set_draw_function([this]() { frame_finished(); });
+}
+
+EmulatorThread::~EmulatorThread() {
+    stop();
+}
+
+void EmulatorThread::start() {
+    if (m_thread.joinable()) {
+        return;
+    }
+    m_stop = false;
+    m_pacer.reset();
+    m_thread = std::thread(&EmulatorThread::run, this);
+}
+
+void EmulatorThread::stop() {
+    m_stop = true;
+    m_wakeup_count.fetch_add(1);
+    m_wakeup_count.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool EmulatorThread::has_failed() const {
+    return m_failed;
+}
+
+void EmulatorThread::set_game_changed_function(std::function<void()> f) {
+    m_game_changed_function = std::move(f);
+}
+
+bool EmulatorThread::send(Command command) {
+    if (!m_commands.push(std::move(command))) {
+        m_logger->warn("Emulator command queue full, dropping command");
+        return false;
+    }
+    m_wakeup_count.fetch_add(1);
+    m_wakeup_count.notify_one();
+    return true;
+}
+
+void EmulatorThread::set_pressed_keys(uint8_t keys) {
+    m_pressed_keys = keys;
+    m_wakeup_count.fetch_add(1);
+    m_wakeup_count.notify_one();
+}
+
+bool EmulatorThread::update_frame() {
+    return m_frames.update();
+}
+
+const EmulatorThread::Frame& EmulatorThread::get_frame() const {
+    return m_frames.front();
+}
+
+void EmulatorThread::run() {
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        if (m_pending_game.has_value()) {
+            load_pending_game();
+        }
+        if (!m_emulator.get_state().rom_file_path.has_value() || m_emulator.get_options().paused) {
+            // Without frames, commands are only handled here. Sleep until one changes the state.
+            wait_for_commands();
+            process_commands();
+            m_pacer.reset();
+            continue;
+        }
+        if (!m_emulator.step()) {
+            m_failed = true;
+            return;
+        }
+    }
+}
+
+void EmulatorThread::load_pending_game() {
+    if (m_game_changed_function) {
+        m_game_changed_function();
+    }
+    m_emulator.reset_state();
+    m_emulator.load_game(*m_pending_game);
+    m_pending_game.reset();
+}
+
+void EmulatorThread::frame_finished() {
+    // The PPU didn't render skipped frames, only pass on the others.
+    if (!m_emulator.is_frame_skipped()) {
+        publish_frame();
+    }
+    process_commands();
+    m_pacer.wait_for_next_frame(m_emulator.get_options().get_speed());
+}
+
+void EmulatorThread::publish_frame() {
+    auto& frame = m_frames.back();
+    const auto& ppu = m_emulator.get_ppu();
+    frame.game = ppu->get_game();
+    const auto* sprites = ppu->get_sprites();
+    frame.has_sprites = sprites != nullptr;
+    if (frame.has_sprites) {
+        frame.sprites = *sprites;
+    }
+    const auto& state = m_emulator.get_state();
+    frame.rom_loaded = state.rom_file_path.has_value();
+    frame.game_title = state.game_title;
+    frame.frame_count = state.frame_count;
+    frame.instructions_executed = state.instructions_executed;
+    frame.memory_usage = m_emulator.get_memory_usage();
+    m_frames.publish();
+}
+
+void EmulatorThread::process_commands() {
+    while (auto command = m_commands.pop()) {
+        execute(*command);
+    }
+    if (have_keys_changed()) {
+        m_emulator.get_joypad()->set_pressed_keys(m_pressed_keys);
+    }
+}
+
+void EmulatorThread::execute(Command& command) {
+    std::visit(
+        [this](auto& c) {
+            using T = std::decay_t<decltype(c)>;
+            if constexpr (std::is_same_v<T, command::SetOptions>) {
+                m_emulator.get_options() = c.options;
+            } else if constexpr (std::is_same_v<T, command::LoadGame>) {
+                // Commands are executed from the VBlank callback of the PPU, the game can only be
+                // replaced between instructions.
+                m_pending_game = std::move(c.rom_path);
+            }
+        },
+        command);
+}
+
+void EmulatorThread::wait_for_commands() {
+    // Read the counter before checking for commands, so a command sent in between changes the
+    // counter and the wait returns immediately.
+    const auto wakeup_count = m_wakeup_count.load();
+    if (m_commands.empty() && !have_keys_changed() && !m_stop) {
+        m_wakeup_count.wait(wakeup_count);
+    }
+}
+
+bool EmulatorThread::have_keys_changed() const {
+    return m_pressed_keys != m_emulator.get_joypad()->get_pressed_keys();
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "constants.h"
+#include "framebuffer.hpp"
+#include "framepacer.hpp"
+#include "graphics.hpp"
+#include "options.hpp"
+#include "spscqueue.hpp"
+#include "triplebuffer.hpp"
+class Emulator;
+#include "spdlog/fwd.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+
+namespace command {
+// Replaces all options of the emulator
+struct SetOptions {
+    EmulatorOptions options;
+};
+// Reset the emulator and run the game
+struct LoadGame {
+    std::filesystem::path rom_path;
+};
+} // namespace command
+
+/*
+ * Runs the emulator on its own thread, decoupled from the frontend. Finished frames are passed to
+ * the frontend through a triple buffer, option changes are passed to the emulator through a command
+ * queue. Held keys are passed as a bitmask which always contains the latest state, so no key state
+ * is lost when the queue is full. All of them are lock-free, so neither side waits for the other: a
+ * slow frontend or waiting for vsync only drops presented frames and never delays emulation.
+ * Emulation is paced to the speed of the original hardware, multiplied by the game speed while
+ * fast-forwarding. While paused or without a game the thread blocks until it receives a command.
+ */
+class EmulatorThread {
+public:
+    using ScreenFramebuffer = Framebuffer<graphics::gb::ColorGb, constants::SCREEN_RES_WIDTH,
+                                          constants::SCREEN_RES_HEIGHT>;
+    using Command = std::variant<command::SetOptions, command::LoadGame>;
+
+    // Everything the frontend shows of a finished frame
+    struct Frame {
+        ScreenFramebuffer game{graphics::gb::ColorGb::White};
+        // Only drawn while the sprites debug view is enabled
+        bool has_sprites = false;
+        ScreenFramebuffer sprites{graphics::gb::ColorGb::White};
+        bool rom_loaded = false;
+        std::string game_title;
+        size_t frame_count = 0;
+        size_t instructions_executed = 0;
+        size_t memory_usage = 0;
+    };
+
+    // Takes over the draw function of the emulator. The emulator may only be accessed through this
+    // class while the thread is running.
+    explicit EmulatorThread(Emulator& emulator);
+    EmulatorThread(const EmulatorThread&) = delete;
+    EmulatorThread& operator=(const EmulatorThread&) = delete;
+    EmulatorThread(EmulatorThread&&) = delete;
+    EmulatorThread& operator=(EmulatorThread&&) = delete;
+    ~EmulatorThread();
+
+    void start();
+    void stop();
+    // True if the emulator stopped because of an error
+    [[nodiscard]] bool has_failed() const;
+
+    // Called on the emulator thread before a new game is loaded
+    void set_game_changed_function(std::function<void()> f);
+
+    // Frontend: queue a command which is executed on the emulator thread at the end of the current
+    // frame. Returns false if the queue is full and the command was dropped.
+    bool send(Command command);
+    // Frontend: set the keys which are held from the end of the current frame on, bit n
+    // corresponds to Joypad::Keys value n. Only the latest value is applied.
+    void set_pressed_keys(uint8_t keys);
+    // Frontend: switch to the newest finished frame. Returns false if there is none since the last
+    // call, in which case get_frame returns the same frame as before.
+    bool update_frame();
+    [[nodiscard]] const Frame& get_frame() const;
+
+private:
+    static constexpr size_t COMMAND_QUEUE_SIZE = 64;
+
+    Emulator& m_emulator;
+    std::shared_ptr<spdlog::logger> m_logger;
+    TripleBuffer<Frame> m_frames;
+    SpscQueue<Command, COMMAND_QUEUE_SIZE> m_commands;
+    // Latest keys set by the frontend
+    std::atomic<uint8_t> m_pressed_keys = 0;
+    std::function<void()> m_game_changed_function;
+    // Set by a LoadGame command, loaded after the current instruction
+    std::optional<std::filesystem::path> m_pending_game;
+    // Incremented on every command and on stop to wake up the thread while it is idle
+    std::atomic<uint32_t> m_wakeup_count = 0;
+    std::atomic<bool> m_stop = false;
+    std::atomic<bool> m_failed = false;
+    FramePacer m_pacer;
+    std::thread m_thread;
+
+    void run();
+    void load_pending_game();
+    // Called by the emulator on VBlank
+    void frame_finished();
+    void publish_frame();
+    void process_commands();
+    void execute(Command& command);
+    // True if the keys set by the frontend differ from the keys held in the emulator
+    [[nodiscard]] bool have_keys_changed() const;
+    // Block until a command is sent or the thread is stopped
+    void wait_for_commands();
+};
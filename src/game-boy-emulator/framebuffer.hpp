@@ -1,7 +1,7 @@
 #pragma once
 
-#include "SDL_surface.h"
-#include <vector>
+#include <array>
+#include <span>
 #include <cstdint>
 #include <cstddef>
 
@@ -9,13 +9,12 @@
  * x axes: horizontal (corresponds to width)
  * y axes: vertical (corresponds to height)
  * origin top left
+ * The pixels are stored inline, so a framebuffer can be allocated as part of its owner.
  */
 template <typename PixelType, size_t Width, size_t Height>
 class Framebuffer {
 
-    size_t m_width = Width;
-    size_t m_height = Height;
-    std::vector<PixelType> m_buffer;
+    std::array<PixelType, Width * Height> m_buffer;
 
     // Get the index a pixel would have in a 1D representation of the image data
     [[nodiscard]] size_t pixel_index(size_t x, size_t y) const;
@@ -35,6 +34,12 @@ public:
     void set_pixel_wraparound(int x, int y, PixelType color);
     [[nodiscard]] PixelType get_pixel_wraparound(int x, int y) const;
 
+    // Direct access to the pixels in row-major order
+    [[nodiscard]] std::span<const PixelType> pixels() const;
+    [[nodiscard]] std::span<PixelType> pixels();
+    // Pixels of one line
+    [[nodiscard]] std::span<PixelType, Width> row(size_t y);
+
     // Transfer frame buffer content into another buffer.
     void copy_into(void* ptr) const;
     // Transfer content from another buffer into this framebuffer
@@ -49,8 +54,8 @@ public:
 
     // Check if the two framebuffers have the same content
     bool operator==(const Framebuffer<PixelType, Width, Height>& other) const;
-
-    SDL_Surface* to_surface();
+    // Cheap, non-cryptographic hash of the content to detect changes between frames
+    [[nodiscard]] uint64_t hash() const;
 };
 
 template <typename PixelType, size_t Width, size_t Height>
@@ -1,13 +1,15 @@
+#include "hash.hpp"
 #include <cstring>
 #include <cstdlib>
 
 template <typename PixelType, size_t Width, size_t Height>
-Framebuffer<PixelType, Width, Height>::Framebuffer(PixelType fill) :
-        m_buffer(Width * Height, fill) {}
+Framebuffer<PixelType, Width, Height>::Framebuffer(PixelType fill) {
+    m_buffer.fill(fill);
+}
 
 template <typename PixelType, size_t Width, size_t Height>
 size_t Framebuffer<PixelType, Width, Height>::pixel_index(size_t x, size_t y) const {
-    return x + (y * m_width);
+    return x + (y * Width);
 }
 
 template <typename PixelType, size_t Width, size_t Height>
@@ -23,12 +25,12 @@ void Framebuffer<PixelType, Width, Height>::set_pixel(size_t x, size_t y, PixelT
 
 template <typename PixelType, size_t Width, size_t Height>
 size_t Framebuffer<PixelType, Width, Height>::width() const {
-    return m_width;
+    return Width;
 }
 
 template <typename PixelType, size_t Width, size_t Height>
 size_t Framebuffer<PixelType, Width, Height>::height() const {
-    return m_height;
+    return Height;
 }
 
 template <typename PixelType, size_t Width, size_t Height>
@@ -46,6 +48,21 @@ PixelType Framebuffer<PixelType, Width, Height>::get_pixel(size_t pixel_index) c
     return m_buffer[pixel_index];
 }
 
+template <typename PixelType, size_t Width, size_t Height>
+std::span<const PixelType> Framebuffer<PixelType, Width, Height>::pixels() const {
+    return m_buffer;
+}
+
+template <typename PixelType, size_t Width, size_t Height>
+std::span<PixelType> Framebuffer<PixelType, Width, Height>::pixels() {
+    return m_buffer;
+}
+
+template <typename PixelType, size_t Width, size_t Height>
+std::span<PixelType, Width> Framebuffer<PixelType, Width, Height>::row(size_t y) {
+    return std::span<PixelType, Width>{m_buffer.data() + pixel_index(0, y), Width};
+}
+
 template <typename PixelType, size_t Width, size_t Height>
 void Framebuffer<PixelType, Width, Height>::copy_into(void* ptr) const {
     std::memcpy(ptr, m_buffer.data(), sizeof(PixelType) * m_buffer.size());
@@ -58,7 +75,7 @@ void Framebuffer<PixelType, Width, Height>::take_from(void* ptr) {
 
 template <typename PixelType, size_t Width, size_t Height>
 void Framebuffer<PixelType, Width, Height>::reset(PixelType fill) {
-    m_buffer.assign(size(), fill);
+    m_buffer.fill(fill);
 }
 
 template <typename PixelType, size_t Width, size_t Height>
@@ -66,15 +83,15 @@ void Framebuffer<PixelType, Width, Height>::set_pixel_wraparound(int x, int y, P
 
     auto x_unsigned = [&] {
         if (x < 0) {
-            return static_cast<int>(m_width) - (std::abs(x) % static_cast<int>(m_width));
+            return static_cast<int>(Width) - (std::abs(x) % static_cast<int>(Width));
         }
-        return x % static_cast<int>(m_width);
+        return x % static_cast<int>(Width);
     }();
     auto y_unsigned = [&] {
         if (y < 0) {
-            return static_cast<int>(m_height) - (std::abs(y) % static_cast<int>(m_height));
+            return static_cast<int>(Height) - (std::abs(y) % static_cast<int>(Height));
         }
-        return y % static_cast<int>(m_height);
+        return y % static_cast<int>(Height);
     }();
     set_pixel(static_cast<size_t>(x_unsigned), static_cast<size_t>(y_unsigned), color);
 }
@@ -84,15 +101,15 @@ PixelType Framebuffer<PixelType, Width, Height>::get_pixel_wraparound(int x, int
 
     auto x_unsigned = [&] {
         if (x < 0) {
-            return static_cast<int>(m_width) - (std::abs(x) % static_cast<int>(m_width));
+            return static_cast<int>(Width) - (std::abs(x) % static_cast<int>(Width));
         }
-        return x % static_cast<int>(m_width);
+        return x % static_cast<int>(Width);
     }();
     auto y_unsigned = [&] {
         if (y < 0) {
-            return static_cast<int>(m_height) - (std::abs(y) % static_cast<int>(m_height));
+            return static_cast<int>(Height) - (std::abs(y) % static_cast<int>(Height));
         }
-        return y % static_cast<int>(m_height);
+        return y % static_cast<int>(Height);
     }();
     return get_pixel(static_cast<size_t>(x_unsigned), static_cast<size_t>(y_unsigned));
 }
@@ -104,9 +121,9 @@ bool Framebuffer<PixelType, Width, Height>::operator==(
 }
 
 template <typename PixelType, size_t Width, size_t Height>
-SDL_Surface* Framebuffer<PixelType, Width, Height>::to_surface() {
-    return SDL_CreateRGBSurfaceFrom(m_buffer.data(), width(), height(), sizeof(PixelType) * 8,
-                                    width() * sizeof(PixelType), 0x00000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+uint64_t Framebuffer<PixelType, Width, Height>::hash() const {
+    return hashing::hash_bytes(
+        std::span{reinterpret_cast<const uint8_t*>(m_buffer.data()), sizeof(m_buffer)});
 }
 
 /**
@@ -0,0 +1,97 @@
+#include "framepacer.hpp"
+#include "constants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#define HAS_CLOCK_NANOSLEEP
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_PAUSE
+#endif
+
+namespace {
+// The frame duration is CYCLES_PER_FRAME_T * 1e9 / CLOCK_SPEED_T nanoseconds, which is not a whole
+// number. It is kept as a fraction to accumulate deadlines without rounding errors.
+constexpr int64_t NANOSECONDS_PER_SECOND = 1'000'000'000;
+constexpr int64_t FRAME_DURATION_NUMERATOR = constants::CYCLES_PER_FRAME_T * NANOSECONDS_PER_SECOND;
+
+// Waking up from sleep can be late by the timer slack of the kernel (50 us by default) and the
+// scheduling latency. Sleep until this long before the deadline and spin for the rest.
+constexpr std::chrono::microseconds SPIN_DURATION{500};
+
+void sleep_until(FramePacer::Clock::time_point time) {
+#ifdef HAS_CLOCK_NANOSLEEP
+    // steady_clock is based on CLOCK_MONOTONIC, so its time points can be used directly.
+    const auto since_epoch = time.time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    timespec deadline{};
+    deadline.tv_sec = static_cast<time_t>(seconds.count());
+    deadline.tv_nsec = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count());
+    // Restart when interrupted by a signal
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(time);
+#endif
+}
+
+void spin_until(FramePacer::Clock::time_point time) {
+    while (FramePacer::Clock::now() < time) {
+#ifdef HAS_X86_PAUSE
+        __builtin_ia32_pause();
+#endif
+    }
+}
+} // namespace
+
+FramePacer::FramePacer() : m_next_frame_time(Clock::now()) {}
+
+void FramePacer::reset() {
+    m_next_frame_time = Clock::now();
+    m_remainder = 0;
+}
+
+void FramePacer::advance_deadline(int speed) {
+    speed = std::max(speed, 1);
+    if (speed != m_speed) {
+        // The remainder is in units of the previous speed, dropping it loses less than 1 ns.
+        m_speed = speed;
+        m_remainder = 0;
+    }
+    const int64_t denominator = static_cast<int64_t>(constants::CLOCK_SPEED_T) * speed;
+    m_next_frame_time += std::chrono::nanoseconds(FRAME_DURATION_NUMERATOR / denominator);
+    m_remainder += FRAME_DURATION_NUMERATOR % denominator;
+    if (m_remainder >= denominator) {
+        m_next_frame_time += std::chrono::nanoseconds(1);
+        m_remainder -= denominator;
+    }
+}
+
+void FramePacer::wait_for_next_frame(int speed) {
+    advance_deadline(speed);
+    const auto now = Clock::now();
+    const auto frame_duration
+        = std::chrono::nanoseconds(FRAME_DURATION_NUMERATOR / constants::CLOCK_SPEED_T);
+    if (m_next_frame_time + frame_duration < now) {
+        // Emulation fell behind by more than a frame, e.g. while loading a game. Continue from now
+        // instead of running fast until the lost time is caught up.
+        reset();
+        return;
+    }
+    if (m_next_frame_time - now > SPIN_DURATION) {
+        sleep_until(m_next_frame_time - SPIN_DURATION);
+    }
+    spin_until(m_next_frame_time);
+}
+
+FramePacer::Clock::time_point FramePacer::get_next_frame_time() const {
+    return m_next_frame_time;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Paces emulation to the frame rate of the original hardware, 4194304/70224 Hz, independent of the
+ * refresh rate of the display. Deadlines are accumulated exactly, so there is no drift over time.
+ * Most of the time until a deadline is slept, only the last part is spent spinning since waking up
+ * from sleep is not precise enough.
+ */
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FramePacer();
+
+    // Start pacing from now, e.g. after emulation was paused.
+    void reset();
+    // Wait until the current frame is due. The speed multiplier shortens the frame duration.
+    void wait_for_next_frame(int speed);
+    // Move the deadline one frame further without waiting, wait_for_next_frame does this before it
+    // waits.
+    void advance_deadline(int speed);
+
+    [[nodiscard]] Clock::time_point get_next_frame_time() const;
+
+private:
+    Clock::time_point m_next_frame_time;
+    // Accumulated fractions of a nanosecond which were not yet added to m_next_frame_time, as the
+    // numerator of a fraction with the denominator CLOCK_SPEED_T * m_speed.
+    int64_t m_remainder = 0;
+    int m_speed = 1;
+};
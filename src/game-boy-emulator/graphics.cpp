@@ -1,81 +1,172 @@
 #include <array>
+#include <bit>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <span>
 #include <cstddef>
 #include "graphics.hpp"
 #include "bitmanipulation.hpp"
 #include <magic_enum.hpp>
-#include "SDL_opengl.h"
-
-namespace graphics::render {
-
-void load_texture_rgba(const uint32_t* data, int width, int height, GLuint* out_texture) {
-    // Create a OpenGL texture identifier
-    GLuint image_texture{};
-    glGenTextures(1, &image_texture);
-    glBindTexture(GL_TEXTURE_2D, image_texture);
-
-    // Setup filtering parameters for display
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-                    GL_CLAMP_TO_EDGE); // This is required on WebGL for non power-of-two textures
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Same
-
-    // Upload pixels into texture
-#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
-    *out_texture = image_texture;
-}
-} // namespace graphics::render
+// SIMD code paths are selected at runtime, which requires the GCC/Clang target attribute.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_SIMD
+#include <immintrin.h>
+#endif
 
 namespace {
-constexpr std::array<std::array<graphics::gb::UnmappedColorGb, 8>, 256 * 256> cache{
-    // Initialize with immediately invoked lambda
-    []() consteval {
-        // Force pre-compution at compile time to avoid computing at runtime.
-        // This gives around a 10% rendering speedup.
-        std::array<std::array<graphics::gb::UnmappedColorGb, 8>, 256 * 256> arr{};
-        for (unsigned b1 = 0; b1 <= 255; ++b1) {
-            for (unsigned b2 = 0; b2 <= 255; ++b2) {
-                auto index = bitmanip::word_from_bytes(b1, b2);
-                for (uint8_t i = 0; i < 8; ++i) {
-                    auto msb = bitmanip::bit_value(b2, i);
-                    auto lsb = bitmanip::bit_value(b1, i);
-                    arr[index][7 - i] = static_cast<graphics::gb::UnmappedColorGb>((msb << 1) + lsb);
-                }
-            }
+// Spreads the 8 bits of a byte to the lowest bit of 8 bytes, the most significant bit going into
+// the first byte (leftmost pixel). Together with a shift, two spread bit planes give the color
+// indices of 8 pixels. The table is 2 KB, small enough to stay in L1 while rendering.
+constexpr std::array<uint64_t, 256> SPREAD_TABLE = [] {
+    std::array<uint64_t, 256> table{};
+    for (unsigned byte = 0; byte < table.size(); ++byte) {
+        for (unsigned i = 0; i < 8; ++i) {
+            table[byte] |= uint64_t{bitmanip::bit_value(byte, 7 - static_cast<int>(i))} << (i * 8);
         }
-        return arr;
-    }()
-};
-
-const std::array<graphics::gb::UnmappedColorGb, 8>& get_cached_tile_line(uint8_t byte1,
-                                                                         uint8_t byte2) {
-    auto index = bitmanip::word_from_bytes(byte1, byte2);
-    return cache[index];
-}
-
+    }
+    return table;
+}();
 } // namespace
 
 namespace graphics::gb {
 
-const std::array<UnmappedColorGb, 8>& convert_tile_line(uint8_t byte1, uint8_t byte2) {
-    const auto& line = get_cached_tile_line(byte1, byte2);
+std::array<UnmappedColorGb, 8> convert_tile_line(uint8_t byte1, uint8_t byte2) {
+    // byte1 has the lower bits of the color indices, byte2 the upper ones.
+    uint64_t spread = SPREAD_TABLE[byte1] | (SPREAD_TABLE[byte2] << 1);
+    if constexpr (std::endian::native == std::endian::big) {
+        // Byte i of spread has to be pixel i in memory
+        spread = std::byteswap(spread);
+    }
+    std::array<UnmappedColorGb, 8> line{};
+    static_assert(sizeof(line) == sizeof(spread));
+    std::memcpy(line.data(), &spread, sizeof(spread));
     return line;
 }
 
+const ScreenPalette DEFAULT_SCREEN_PALETTE = [] {
+    ScreenPalette palette{};
+    palette.fill(static_cast<ColorScreen>(0));
+    palette[magic_enum::enum_integer(ColorGb::White)] = ColorScreen::White;
+    palette[magic_enum::enum_integer(ColorGb::LightGray)] = ColorScreen::LightGray;
+    palette[magic_enum::enum_integer(ColorGb::DarkGray)] = ColorScreen::DarkGray;
+    palette[magic_enum::enum_integer(ColorGb::Black)] = ColorScreen::Black;
+    palette[magic_enum::enum_integer(ColorGb::DebugBackground)] = ColorScreen::TrueWhite;
+    palette[magic_enum::enum_integer(ColorGb::DebugHighlight)] = ColorScreen::Highlight;
+    return palette;
+}();
+
+ColorScreen to_screen_color(ColorGb color_gb) {
+    return DEFAULT_SCREEN_PALETTE[magic_enum::enum_integer(color_gb)];
+}
+
 namespace {
-const std::array<ColorScreen, 4> PALETTE
-    = {ColorScreen::White, ColorScreen::LightGray, ColorScreen::DarkGray, ColorScreen::Black};
+void map_to_screen_colors_scalar(std::span<const ColorGb> in, std::span<ColorScreen> out,
+                                 const ScreenPalette& palette) {
+    for (size_t i = 0; i < in.size(); ++i) {
+        out[i] = palette[magic_enum::enum_integer(in[i]) & 0xF];
+    }
 }
 
-ColorScreen to_screen_color(ColorGb color_gb) {
-    return PALETTE[magic_enum::enum_integer(color_gb)];
+#ifdef HAS_X86_SIMD
+// Expands 16 pixels per iteration. The palette is split into four 16 byte tables, one per byte of
+// the 32 bit color. A byte shuffle with the color indices then looks up one byte of every
+// pixel's color and the four results are interleaved into the final colors.
+__attribute__((target("ssse3"))) void
+map_to_screen_colors_ssse3(std::span<const ColorGb> in, std::span<ColorScreen> out,
+                           const ScreenPalette& palette) {
+    std::array<std::array<uint8_t, 16>, 4> byte_tables{};
+    for (size_t i = 0; i < palette.size(); ++i) {
+        const auto color = static_cast<uint32_t>(palette[i]);
+        for (size_t byte = 0; byte < 4; ++byte) {
+            byte_tables[byte][i] = static_cast<uint8_t>(color >> (byte * 8));
+        }
+    }
+    const auto table0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_tables[0].data()));
+    const auto table1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_tables[1].data()));
+    const auto table2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_tables[2].data()));
+    const auto table3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_tables[3].data()));
+    const auto index_mask = _mm_set1_epi8(0xF);
+
+    size_t i = 0;
+    for (; i + 16 <= in.size(); i += 16) {
+        auto indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + i));
+        indices = _mm_and_si128(indices, index_mask);
+        const auto byte0 = _mm_shuffle_epi8(table0, indices);
+        const auto byte1 = _mm_shuffle_epi8(table1, indices);
+        const auto byte2 = _mm_shuffle_epi8(table2, indices);
+        const auto byte3 = _mm_shuffle_epi8(table3, indices);
+        const auto low01 = _mm_unpacklo_epi8(byte0, byte1);
+        const auto high01 = _mm_unpackhi_epi8(byte0, byte1);
+        const auto low23 = _mm_unpacklo_epi8(byte2, byte3);
+        const auto high23 = _mm_unpackhi_epi8(byte2, byte3);
+        auto* dst = reinterpret_cast<__m128i*>(out.data() + i);
+        _mm_storeu_si128(dst, _mm_unpacklo_epi16(low01, low23));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low01, low23));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high01, high23));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high01, high23));
+    }
+    map_to_screen_colors_scalar(in.subspan(i), out.subspan(i), palette);
+}
+#endif
+} // namespace
+
+void map_to_screen_colors(std::span<const ColorGb> in, std::span<ColorScreen> out,
+                          const ScreenPalette& palette) {
+    assert(out.size() >= in.size() && "Output buffer too small");
+#ifdef HAS_X86_SIMD
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3") != 0;
+    if (has_ssse3) {
+        map_to_screen_colors_ssse3(in, out, palette);
+        return;
+    }
+#endif
+    map_to_screen_colors_scalar(in, out, palette);
+}
+
+namespace {
+void apply_palette_scalar(std::span<const UnmappedColorGb> in, std::span<ColorGb> out,
+                          const std::array<ColorGb, 4>& palette) {
+    for (size_t i = 0; i < in.size(); ++i) {
+        out[i] = palette[magic_enum::enum_integer(in[i]) & 0b11];
+    }
+}
+
+#ifdef HAS_X86_SIMD
+// The palette fits into the first 4 bytes of a shuffle table, so one pshufb maps 16 pixels.
+__attribute__((target("ssse3"))) void apply_palette_ssse3(std::span<const UnmappedColorGb> in,
+                                                          std::span<ColorGb> out,
+                                                          const std::array<ColorGb, 4>& palette) {
+    std::array<uint8_t, 16> table{};
+    for (size_t i = 0; i < palette.size(); ++i) {
+        table[i] = magic_enum::enum_integer(palette[i]);
+    }
+    const auto lookup = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data()));
+    const auto index_mask = _mm_set1_epi8(0b11);
+    size_t i = 0;
+    for (; i + 16 <= in.size(); i += 16) {
+        auto indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + i));
+        indices = _mm_and_si128(indices, index_mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + i),
+                         _mm_shuffle_epi8(lookup, indices));
+    }
+    apply_palette_scalar(in.subspan(i), out.subspan(i), palette);
+}
+#endif
+} // namespace
+
+void apply_palette(std::span<const UnmappedColorGb> in, std::span<ColorGb> out,
+                   const std::array<ColorGb, 4>& palette) {
+    assert(out.size() >= in.size() && "Output buffer too small");
+#ifdef HAS_X86_SIMD
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3") != 0;
+    if (has_ssse3) {
+        apply_palette_ssse3(in, out, palette);
+        return;
+    }
+#endif
+    apply_palette_scalar(in, out, palette);
 }
 
 std::array<UnmappedColorGb, 64> tile_to_gb_color(std::span<uint8_t, 16> tile_data) {
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "SDL_opengl.h"
 #include "magic_enum.hpp"
 
 #include <algorithm>
@@ -10,26 +9,6 @@
 
 
 namespace graphics {
-/**
- * Functions in this namespace are for dealing with external graphic libraries.
- */
-namespace render {
-
-// Simple helper function to load an image into a OpenGL texture with common settings
-bool load_texture_from_file(const char* filename, GLuint* out_texture, int* out_width,
-                            int* out_height);
-
-/**
- * Load image from RGBA array and transfer it into the texture
- * @param data
- * @param width
- * @param height
- * @param out_texture
- */
-void load_texture_rgba(const uint32_t* data, int width, int height, GLuint* out_texture);
-
-} // namespace render
-
 
 /**
  * Functions in this namespace are for dealing with game boy graphics formats
@@ -44,15 +23,19 @@ enum class UnmappedColorGb : uint8_t {
     Color3 = 3,
 };
 
-// Colors after a palette was applied to their values
+// Colors after a palette was applied to their values. Framebuffers store these (one byte per pixel)
+// and they are converted to screen colors once per frame by map_to_screen_colors.
 enum class ColorGb : uint8_t {
     White = 0,
     LightGray = 1,
     DarkGray = 2,
     Black = 3,
+    // Not produced by the game boy, only used to draw the debug views.
+    DebugBackground = 4,
+    DebugHighlight = 5,
 };
 
-// Color values used for SDL rendering
+// Color values used for rendering to the screen
 enum class ColorScreen : uint32_t {
     // Format is ARGB
     TrueWhite = 0xFFFFFFFF,
@@ -63,14 +46,41 @@ enum class ColorScreen : uint32_t {
     Highlight = 0x00ffff,
 };
 
+// Maps every ColorGb value to a screen color. The palette has 16 entries so it can be used as a
+// lookup table for a single byte shuffle, unused entries should be black.
+using ScreenPalette = std::array<ColorScreen, 16>;
+
+// Palette with the classic green shades of the DMG.
+extern const ScreenPalette DEFAULT_SCREEN_PALETTE;
+
 ColorScreen to_screen_color(ColorGb color_gb);
 
+/**
+ * Convert a buffer of game boy colors to screen colors using the palette. This is the only place
+ * where a full frame is expanded to 32 bit colors, it is called when uploading to a texture or
+ * exporting a frame. Uses SSSE3 when available.
+ * @param in Game boy colors
+ * @param out Screen colors, has to be at least as large as in.
+ * @param palette
+ */
+void map_to_screen_colors(std::span<const ColorGb> in, std::span<ColorScreen> out,
+                          const ScreenPalette& palette = DEFAULT_SCREEN_PALETTE);
+
 /*
  * Convert two bytes of a tile (which represent a row of 8 pixels) to the 4 color values
  * available on the game boy.
  * Will return an array of values 0b0, 0b01, 0b10, 0b11, which has to be colorized by a palette.
  */
-const std::array<UnmappedColorGb, 8>& convert_tile_line(uint8_t byte1, uint8_t byte2);
+std::array<UnmappedColorGb, 8> convert_tile_line(uint8_t byte1, uint8_t byte2);
+
+/**
+ * Apply a palette (BGP, OBP0, OBP1) to colors. Uses SSSE3 when available.
+ * @param in Colors as stored in the tile data
+ * @param out Colors after applying the palette, has to be at least as large as in.
+ * @param palette
+ */
+void apply_palette(std::span<const UnmappedColorGb> in, std::span<ColorGb> out,
+                   const std::array<ColorGb, 4>& palette);
 
 /**
  * This takes one tile and converts it from the 2bpp format to rgba format.
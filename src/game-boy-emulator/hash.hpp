@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// Cheap, non-cryptographic hashing used to detect changes of frames and emulator states. Multiply
+// and xorshift on 8 bytes at a time, which is fast enough to hash a state after every frame.
+namespace hashing {
+constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15;
+
+// Mix the next 8 bytes into the hash
+[[nodiscard]] inline uint64_t combine(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * MULTIPLIER;
+    return hash ^ (hash >> 29);
+}
+
+[[nodiscard]] inline uint64_t hash_bytes(std::span<const uint8_t> bytes) {
+    uint64_t hash = bytes.size();
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        hash = combine(hash, word);
+    }
+    for (; i < bytes.size(); ++i) {
+        hash = (hash ^ bytes[i]) * MULTIPLIER;
+    }
+    return hash;
+}
+} // namespace hashing
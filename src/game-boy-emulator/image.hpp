@@ -2,9 +2,12 @@
 
 #include "framebuffer.hpp"
 #include "graphics.hpp"
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 #include "SDL_render.h"
+#include "SDL_surface.h"
 struct SDL_Texture;
 struct SDL_Renderer;
 template <typename PixelType, size_t Width, size_t Height>
@@ -20,13 +23,17 @@ struct SdlTextureDeleter {
 };
 
 /**
- * Couples a framebuffer to SDL rendering.
+ * Couples a framebuffer to SDL rendering. The texture is only written when the framebuffer content
+ * or the palette changed since the last upload.
  */
 template <size_t Width, size_t Height>
 class Image {
     size_t m_width = Width;
     size_t m_height = Height;
     std::unique_ptr<SDL_Texture, SdlTextureDeleter> m_texture;
+    // Content hash and palette of the last upload
+    std::optional<uint64_t> m_uploaded_hash;
+    graphics::gb::ScreenPalette m_uploaded_palette{};
 
 public:
     // Create image with a texture using the given renderer. If no renderer is given, init_texture
@@ -35,7 +42,11 @@ public:
 
     void init_texture(SDL_Renderer* sdl_renderer);
 
-    void upload_to_texture(const Framebuffer<graphics::gb::ColorScreen, Width, Height>& buffer);
+    // Convert the framebuffer to screen colors using the palette and write them directly into the
+    // locked texture. Returns false if the texture was not written since it is up to date.
+    bool upload_to_texture(
+        const Framebuffer<graphics::gb::ColorGb, Width, Height>& buffer,
+        const graphics::gb::ScreenPalette& palette = graphics::gb::DEFAULT_SCREEN_PALETTE);
 
     [[nodiscard]] size_t width() const;
     [[nodiscard]] size_t height() const;
@@ -46,4 +57,8 @@ public:
     void save_as_bitmap(std::string filename) const;
 };
 
+// Create a surface using the pixels of the framebuffer, which has to outlive the surface.
+template <typename PixelType, size_t Width, size_t Height>
+SDL_Surface* to_surface(Framebuffer<PixelType, Width, Height>& buffer);
+
 #include "image.tpp"
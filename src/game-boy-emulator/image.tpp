@@ -1,6 +1,8 @@
 #include "SDL.h"
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <span>
 
 template <size_t Width, size_t Height>
 Image<Width, Height>::Image(SDL_Renderer* sdl_renderer) : m_texture(nullptr) {
@@ -13,18 +15,41 @@ Image<Width, Height>::Image(SDL_Renderer* sdl_renderer) : m_texture(nullptr) {
 }
 
 template <size_t Width, size_t Height>
-void Image<Width, Height>::upload_to_texture(
-    const Framebuffer<graphics::gb::ColorScreen, Width, Height>& buffer) {
+bool Image<Width, Height>::upload_to_texture(
+    const Framebuffer<graphics::gb::ColorGb, Width, Height>& buffer,
+    const graphics::gb::ScreenPalette& palette) {
     assert(m_texture != nullptr && "Call init_texture or pass SDL_Renderer in constructor");
+    const auto hash = buffer.hash();
+    if (m_uploaded_hash == hash && m_uploaded_palette == palette) {
+        return false;
+    }
     void* pixels = nullptr;
     int pitch = 0;
     auto rc = SDL_LockTexture(m_texture.get(), nullptr, &pixels, &pitch);
     (void)rc;
     assert(rc == 0 && "Failed to lock texture");
-    assert(pitch == int(buffer.width() * sizeof(graphics::gb::ColorScreen))
-           && "Pitch size assumption error");
-    buffer.copy_into(pixels);
+    const auto row_size = Width * sizeof(graphics::gb::ColorScreen);
+    if (static_cast<size_t>(pitch) == row_size) {
+        graphics::gb::map_to_screen_colors(
+            buffer.pixels(),
+            std::span<graphics::gb::ColorScreen>{static_cast<graphics::gb::ColorScreen*>(pixels),
+                                                 buffer.size()},
+            palette);
+    } else {
+        // Rows of the texture are padded, convert them one by one.
+        for (size_t y = 0; y < Height; ++y) {
+            auto* row = static_cast<uint8_t*>(pixels) + (y * static_cast<size_t>(pitch));
+            graphics::gb::map_to_screen_colors(
+                buffer.pixels().subspan(y * Width, Width),
+                std::span<graphics::gb::ColorScreen>{
+                    reinterpret_cast<graphics::gb::ColorScreen*>(row), Width},
+                palette);
+        }
+    }
     SDL_UnlockTexture(m_texture.get());
+    m_uploaded_hash = hash;
+    m_uploaded_palette = palette;
+    return true;
 }
 
 template <size_t Width, size_t Height>
@@ -33,6 +58,7 @@ void Image<Width, Height>::init_texture(SDL_Renderer* sdl_renderer) {
         = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
                             static_cast<int>(m_width), static_cast<int>(m_height));
     m_texture = std::unique_ptr<SDL_Texture, SdlTextureDeleter>(texture);
+    m_uploaded_hash.reset();
 }
 
 template <size_t Width, size_t Height>
@@ -63,3 +89,11 @@ void Image<Width, Height>::save_as_bitmap(std::string filename) const {
     res = SDL_SaveBMP(surf, filename.data());
     assert(res == 0);
 }
+
+template <typename PixelType, size_t Width, size_t Height>
+SDL_Surface* to_surface(Framebuffer<PixelType, Width, Height>& buffer) {
+    return SDL_CreateRGBSurfaceFrom(buffer.pixels().data(), static_cast<int>(buffer.width()),
+                                    static_cast<int>(buffer.height()), sizeof(PixelType) * 8,
+                                    static_cast<int>(buffer.width() * sizeof(PixelType)),
+                                    0x00000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+}
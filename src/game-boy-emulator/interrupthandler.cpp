@@ -3,6 +3,7 @@
 #include "emulator.hpp"
 #include "bitmanipulation.hpp"
 #include "cpu.hpp"
+#include "savestate.hpp"
 
 #include "magic_enum.hpp"
 #include "spdlog/spdlog.h"
@@ -10,7 +11,7 @@
 #include <array>
 
 InterruptHandler::InterruptHandler(Emulator* emulator) :
-        m_emulator(emulator), m_logger(spdlog::get("")) {}
+        m_emulator(emulator), m_logger(emulator->get_logger()) {}
 
 bool InterruptHandler::get_global_interrupt_enable_status() const {
     return m_global_interrupt_enabled_status;
@@ -90,3 +91,17 @@ uint8_t InterruptHandler::read_interrupt_enable() const {
 uint8_t InterruptHandler::read_interrupt_flag() const {
     return m_interrupt_request_flags;
 }
+
+void InterruptHandler::save_state(StateWriter& writer) const {
+    writer.write(m_global_enabled_instruction_countdown);
+    writer.write(m_global_interrupt_enabled_status);
+    writer.write(m_interrupt_enable_register);
+    writer.write(m_interrupt_request_flags);
+}
+
+void InterruptHandler::load_state(StateReader& reader) {
+    reader.read(m_global_enabled_instruction_countdown);
+    reader.read(m_global_interrupt_enabled_status);
+    reader.read(m_interrupt_enable_register);
+    reader.read(m_interrupt_request_flags);
+}
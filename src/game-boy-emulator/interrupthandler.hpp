@@ -1,6 +1,8 @@
 #pragma once
 
 class Emulator;
+class StateWriter;
+class StateReader;
 #include "spdlog/fwd.h"
 #include <cstdint>
 #include <memory>
@@ -34,6 +36,9 @@ public:
     // other values intact.
     void request_interrupt(InterruptType interrupt_type);
 
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
 private:
     // Enabling interrupts is delayed by one instruction.
     int8_t m_global_enabled_instruction_countdown = -1;
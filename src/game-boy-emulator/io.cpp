@@ -10,7 +10,10 @@
 #include <algorithm>
 #include <vector>
 #include <iterator>
+#include <memory>
 #include "constants.h"
+#include "exceptions.hpp"
+#include "fmt/format.h"
 #include "spdlog/spdlog.h"
 
 
@@ -34,24 +37,22 @@ EmulatorIo::load_boot_rom_file(const std::filesystem::path& path) {
     return boot_rom;
 }
 
-std::optional<std::vector<uint8_t>> EmulatorIo::load_rom_file(const std::filesystem::path& path) {
+std::shared_ptr<const std::vector<uint8_t>>
+EmulatorIo::load_rom_file(const std::filesystem::path& path) {
     if (!std::filesystem::exists(path)) {
-        m_logger->error("Rom file {} not found", path.c_str());
-        return std::nullopt;
+        throw LoadError(fmt::format("Rom file {} not found", path.string()));
     }
     std::ifstream rom_file(path, std::ios::binary | std::ios::ate);
     if (!rom_file.is_open()) {
-        m_logger->error("Could not load rom file {}", path.string());
-        return std::nullopt;
+        throw LoadError(fmt::format("Could not load rom file {}", path.string()));
     }
     auto pos = rom_file.tellg();
     if (pos <= 0) {
-        m_logger->error("Error loading rom file {}", path.string());
-        return std::nullopt;
+        throw LoadError(fmt::format("Error loading rom file {}", path.string()));
     }
-    std::vector<uint8_t> rom(static_cast<size_t>(pos));
+    auto rom = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(pos));
     rom_file.seekg(0, std::ios::beg);
-    rom_file.read(std::bit_cast<char*>(rom.data()), pos);
+    rom_file.read(std::bit_cast<char*>(rom->data()), pos);
     return rom;
 }
 
@@ -3,6 +3,7 @@
 #include "constants.h"
 
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <array>
 #include <fstream>
@@ -19,7 +20,9 @@ public:
     std::optional<std::array<uint8_t, constants::BOOT_ROM_SIZE>>
     load_boot_rom_file(const std::filesystem::path& path);
 
-    std::optional<std::vector<uint8_t>> load_rom_file(const std::filesystem::path& path);
+    // Read the complete ROM into memory, so it can be shared by many emulator instances. Throws
+    // LoadError if the file can't be read.
+    std::shared_ptr<const std::vector<uint8_t>> load_rom_file(const std::filesystem::path& path);
 
     static void create_file(const std::filesystem::path& path, size_t filesize_bytes);
 };
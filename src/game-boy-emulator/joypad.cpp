@@ -3,6 +3,7 @@
 #include "bitmanipulation.hpp"
 #include "emulator.hpp"
 #include "interrupthandler.hpp"
+#include "savestate.hpp"
 #include <cstddef>
 #include <cstdint>
 
@@ -25,7 +26,66 @@ void Joypad::release_key(Joypad::Keys key) {
     set_key_state(key, KeyStatus::Released);
 }
 
+bool Joypad::is_pressed(Joypad::Keys key) const {
+    return get_key_state(key) == KeyStatus::Pressed;
+}
+
+void Joypad::set_pressed_keys(uint8_t keys) {
+    // Pressing a key of a selected type requests an interrupt
+    m_observed_keys |= get_selected_keys();
+    for (uint8_t i = 0; i < m_key_states.size(); ++i) {
+        const auto key = static_cast<Keys>(i);
+        const bool held = bitmanip::is_bit_set(keys, i);
+        if (held == is_pressed(key)) {
+            continue;
+        }
+        if (held) {
+            press_key(key);
+        } else {
+            release_key(key);
+        }
+    }
+}
+
+uint8_t Joypad::get_pressed_keys() const {
+    uint8_t keys = 0;
+    for (uint8_t i = 0; i < m_key_states.size(); ++i) {
+        if (m_key_states[i] == KeyStatus::Pressed) {
+            bitmanip::set(keys, i);
+        }
+    }
+    return keys;
+}
+
+void Joypad::restore_pressed_keys(uint8_t keys) {
+    for (uint8_t i = 0; i < m_key_states.size(); ++i) {
+        m_key_states[i] = bitmanip::is_bit_set(keys, i) ? KeyStatus::Pressed : KeyStatus::Released;
+    }
+}
+
+uint8_t Joypad::get_observed_keys() const {
+    return m_observed_keys;
+}
+
+void Joypad::clear_observed_keys() {
+    m_observed_keys = 0;
+}
+
+uint8_t Joypad::get_selected_keys() const {
+    uint8_t keys = 0;
+    if (!bitmanip::is_bit_set(m_register,
+                              static_cast<int>(Joypad::BitValues::SelectDirectionButtons))) {
+        keys |= 0x0F;
+    }
+    if (!bitmanip::is_bit_set(m_register,
+                              static_cast<int>(Joypad::BitValues::SelectActionButtons))) {
+        keys |= 0xF0;
+    }
+    return keys;
+}
+
 uint8_t Joypad::read_byte() {
+    m_observed_keys |= get_selected_keys();
     // Update register content on the fly
     auto select_action = !bitmanip::is_bit_set(
         m_register, static_cast<int>(Joypad::BitValues::SelectActionButtons));
@@ -72,3 +132,13 @@ Joypad::Joypad(Emulator* emulator) : m_emulator(emulator) {
 void Joypad::set_key_state(Joypad::Keys key, Joypad::KeyStatus status) {
     m_key_states[static_cast<size_t>(key)] = status;
 }
+
+void Joypad::save_state(StateWriter& writer) const {
+    writer.write(m_register);
+    writer.write(m_key_states);
+}
+
+void Joypad::load_state(StateReader& reader) {
+    reader.read(m_register);
+    reader.read(m_key_states);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 class Emulator;
+class StateWriter;
+class StateReader;
 #include <cstdint>
 #include <array>
 #include <memory>
@@ -27,6 +29,9 @@ class Joypad {
     // Indexed by keys, store if a key is pressed.
     // Indexed by enum Keys
     std::array<KeyStatus, 8> m_key_states{};
+    // Bit n is set if the state of key n could have changed the emulation since the last call to
+    // clear_observed_keys, because it was read or could have requested an interrupt.
+    uint8_t m_observed_keys = 0;
 
     Emulator* m_emulator;
 
@@ -48,11 +53,26 @@ public:
 
     void press_key(Keys key);
     void release_key(Keys key);
+    [[nodiscard]] bool is_pressed(Keys key) const;
+    // Press and release keys until exactly the keys whose bit is set are held, bit n corresponds
+    // to Keys value n.
+    void set_pressed_keys(uint8_t keys);
+    // Keys which are held, bit n corresponds to Keys value n.
+    [[nodiscard]] uint8_t get_pressed_keys() const;
+    // Set the held keys without requesting interrupts, for restoring a previous state.
+    void restore_pressed_keys(uint8_t keys);
+    [[nodiscard]] uint8_t get_observed_keys() const;
+    void clear_observed_keys();
 
     [[nodiscard]] uint8_t read_byte();
     void write_byte(uint8_t value);
 
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
 private:
+    // Keys of the button types currently selected by the game in bits 4 and 5 of the register
+    [[nodiscard]] uint8_t get_selected_keys() const;
     void set_key_state(Joypad::Keys key, KeyStatus status);
     [[nodiscard]] Joypad::KeyStatus get_key_state(Joypad::Keys key) const;
 };
@@ -0,0 +1,121 @@
+#include "linkcable.hpp"
+#include "constants.h"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+
+#include <mutex>
+#include <thread>
+
+LinkCable::LinkCable(Emulator& first, Emulator& second, size_t window_cycles) :
+        m_emulators{&first, &second}, m_window_cycles(window_cycles), m_sync(2, WindowEnd{this}) {
+    if (&first == &second) {
+        throw LogicError("Link cable can not connect an emulator to itself");
+    }
+    if (m_window_cycles == 0) {
+        throw LogicError("Link cable window has to be at least one cycle");
+    }
+    for (auto* emulator : m_emulators) {
+        emulator->get_serial_port()->set_linked(true);
+    }
+}
+
+LinkCable::~LinkCable() {
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_shutdown = true;
+    }
+    m_run_changed.notify_all();
+    if (m_second_thread.joinable()) {
+        m_second_thread.join();
+    }
+    for (auto* emulator : m_emulators) {
+        emulator->get_serial_port()->set_linked(false);
+    }
+}
+
+bool LinkCable::run_cycles(size_t num_cycles) {
+    const auto num_windows = (num_cycles + m_window_cycles - 1) / m_window_cycles;
+    if (num_windows == 0) {
+        return true;
+    }
+    // The second thread is idle, so the state of the run can be reset without synchronization.
+    m_num_windows = num_windows;
+    m_windows_run = 0;
+    m_failed = {false, false};
+    m_stop = false;
+    if (!m_second_thread.joinable()) {
+        m_second_thread = std::thread(&LinkCable::run_second_thread, this);
+    }
+    {
+        const std::scoped_lock lock{m_mutex};
+        m_running = true;
+    }
+    m_run_changed.notify_all();
+    run_side(0);
+    std::unique_lock lock{m_mutex};
+    m_run_changed.wait(lock, [this] { return !m_running; });
+    return !m_failed[0] && !m_failed[1];
+}
+
+bool LinkCable::run_frames(size_t num_frames) {
+    return run_cycles(num_frames * constants::CYCLES_PER_FRAME_T / 4);
+}
+
+void LinkCable::WindowEnd::operator()() const noexcept {
+    cable->exchange();
+    ++cable->m_windows_run;
+    cable->m_stop = cable->m_failed[0] || cable->m_failed[1]
+                    || cable->m_windows_run == cable->m_num_windows;
+}
+
+void LinkCable::run_side(size_t side) {
+    auto& emulator = *m_emulators[side];
+    auto window_end = emulator.get_state().cycles_m;
+    while (!m_stop) {
+        window_end += m_window_cycles;
+        while (emulator.get_state().cycles_m < window_end) {
+            if (!emulator.step()) {
+                m_failed[side] = true;
+                break;
+            }
+        }
+        m_sync.arrive_and_wait();
+    }
+}
+
+void LinkCable::run_second_thread() {
+    std::unique_lock lock{m_mutex};
+    while (true) {
+        m_run_changed.wait(lock, [this] { return m_running || m_shutdown; });
+        if (m_shutdown) {
+            return;
+        }
+        lock.unlock();
+        run_side(1);
+        lock.lock();
+        m_running = false;
+        m_run_changed.notify_all();
+    }
+}
+
+void LinkCable::exchange() {
+    // Check both sides first, when both clocked a transfer neither waits for the other.
+    std::array<bool, 2> done{};
+    for (size_t side = 0; side < 2; ++side) {
+        done[side] = m_emulators[side]->get_serial_port()->is_transfer_done();
+    }
+    for (size_t side = 0; side < 2; ++side) {
+        if (!done[side]) {
+            continue;
+        }
+        auto& port = *m_emulators[side]->get_serial_port();
+        auto& other = *m_emulators[1 - side]->get_serial_port();
+        if (other.is_transferring() && !other.uses_internal_clock()) {
+            const auto sent = port.get_data();
+            port.complete_transfer(other.get_data());
+            other.complete_transfer(sent);
+        } else {
+            port.complete_transfer(0xFF);
+        }
+    }
+}
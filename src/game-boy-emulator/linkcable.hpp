@@ -0,0 +1,70 @@
+#pragma once
+
+#include "serial_port.hpp"
+class Emulator;
+#include <array>
+#include <barrier>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+/*
+ * Connects the serial ports of two emulators and runs each of them on its own thread. Instead of
+ * synchronizing after every cycle, both emulators run a window of cycles independently and wait
+ * for each other at its end. Bytes are only exchanged while both are waiting, so linked emulation
+ * stays deterministic. A transfer clocked by one side completes at the end of the window in which
+ * its last bit was shifted, the default window of one bit time delays it by less than a bit.
+ * If the other side is not waiting for an externally clocked transfer, the clocking side receives
+ * 0xFF like without a cable. Externally clocked transfers wait until the other side clocks one.
+ * Load the games before connecting, loading a game disconnects the cable.
+ */
+class LinkCable {
+public:
+    static constexpr size_t DEFAULT_WINDOW_CYCLES = SerialPort::CYCLES_PER_BIT;
+
+    LinkCable(Emulator& first, Emulator& second, size_t window_cycles = DEFAULT_WINDOW_CYCLES);
+    LinkCable(const LinkCable&) = delete;
+    LinkCable& operator=(const LinkCable&) = delete;
+    LinkCable(LinkCable&&) = delete;
+    LinkCable& operator=(LinkCable&&) = delete;
+    ~LinkCable();
+
+    // Run both emulators for num_cycles M cycles, rounded up to whole windows. The second emulator
+    // runs on a thread of the cable, which is started by the first run and waits between runs.
+    // Returns false if an emulator failed, both stop at the end of the window in which that
+    // happened.
+    bool run_cycles(size_t num_cycles);
+    bool run_frames(size_t num_frames);
+
+private:
+    // Called by the barrier when both emulators reached the end of a window
+    struct WindowEnd {
+        LinkCable* cable;
+        void operator()() const noexcept;
+    };
+
+    std::array<Emulator*, 2> m_emulators;
+    size_t m_window_cycles;
+    // State of the current run. Every side only writes its own failed flag, everything else is
+    // written while both sides wait at the barrier or while the second thread waits for a run.
+    size_t m_num_windows = 0;
+    size_t m_windows_run = 0;
+    std::array<bool, 2> m_failed{};
+    bool m_stop = false;
+    std::barrier<WindowEnd> m_sync;
+
+    std::mutex m_mutex;
+    std::condition_variable m_run_changed;
+    // Protected by m_mutex. Set when a run starts, cleared by the second thread when its side of
+    // the run is done.
+    bool m_running = false;
+    bool m_shutdown = false;
+    std::thread m_second_thread;
+
+    // Run the windows of one emulator until the run stops
+    void run_side(size_t side);
+    void run_second_thread();
+    // Complete transfers which finished during the last window
+    void exchange();
+};
@@ -3,30 +3,42 @@
 #include "cartridge_info.hpp"
 #include "spdlog/spdlog.h"
 #include "exceptions.hpp"
+#include "memorymap.hpp"
+#include "savestate.hpp"
+#include "fmt/format.h"
 #include <spdlog/logger.h>
-#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <span>
-#include <utility>
 #include <memory>
+#include <utility>
 
 namespace {
 const int ROM_SIZE = 0x148;
 const int RAM_SIZE = 0x149;
 } // namespace
 
-Mbc::Mbc(std::vector<uint8_t> rom, std::span<uint8_t> ram) :
-        m_rom(std::move(rom)),
+Mbc::Mbc(std::span<const uint8_t> rom, std::span<uint8_t> ram) :
+        m_rom(rom),
         m_ram(ram),
         m_logger(spdlog::get("")),
         m_rom_info(read_rom_size_info(m_rom)),
-        m_ram_info(read_ram_size_info(m_rom)) {}
+        m_ram_info(read_ram_size_info(m_rom)),
+        m_dirty_ram_pages((m_ram.size() / RAM_PAGE_SIZE + 63) / 64, 0) {
+    if (m_rom.size() < memmap::CartridgeRomSize) {
+        throw LogicError(fmt::format("ROM only {} bytes, smaller than two banks", m_rom.size()));
+    }
+    // Every MBC starts with bank 0 and 1 mapped and RAM disabled
+    map_rom_banks(0, memmap::CartridgeRomBankSwitchableBegin);
+}
 
-std::vector<uint8_t>& Mbc::get_rom() {
+std::span<const uint8_t> Mbc::get_rom() const {
     return m_rom;
 }
 
-const std::vector<uint8_t>& Mbc::get_rom() const {
-    return m_rom;
+void Mbc::set_logger(std::shared_ptr<spdlog::logger> logger) {
+    m_logger = std::move(logger);
 }
 
 std::shared_ptr<spdlog::logger> Mbc::get_logger() const {
@@ -41,6 +53,60 @@ std::span<const uint8_t> Mbc::get_ram() const {
     return m_ram;
 }
 
+void Mbc::write_ram(size_t address_in_ram, uint8_t value) {
+    m_ram[address_in_ram] = value;
+    const auto page = address_in_ram / RAM_PAGE_SIZE;
+    m_dirty_ram_pages[page / 64] |= uint64_t{1} << (page % 64);
+    m_ram_dirty = true;
+}
+
+bool Mbc::is_ram_dirty() const {
+    return m_ram_dirty;
+}
+
+std::span<const uint64_t> Mbc::get_dirty_ram_pages() const {
+    return m_dirty_ram_pages;
+}
+
+void Mbc::clear_dirty_ram_pages() {
+    std::ranges::fill(m_dirty_ram_pages, 0);
+    m_ram_dirty = false;
+}
+
+void Mbc::save_state(StateWriter& writer) const {
+    writer.write_span(get_ram());
+}
+
+void Mbc::load_state(StateReader& reader) {
+    reader.read_span(m_ram);
+    if (!m_ram.empty()) {
+        std::ranges::fill(m_dirty_ram_pages, ~uint64_t{0});
+        m_ram_dirty = true;
+    }
+}
+
+void Mbc::map_rom_banks(size_t fixed_bank_offset, size_t switchable_bank_offset) {
+    assert(fixed_bank_offset + memmap::CartridgeRomFixedBankSize <= m_rom.size()
+           && "Mapped ROM fixed bank out of bounds");
+    assert(switchable_bank_offset + memmap::CartridgeRomBankSwitchableSize <= m_rom.size()
+           && "Mapped ROM switchable bank out of bounds");
+    m_mapped_banks.rom_fixed = m_rom.data() + fixed_bank_offset;
+    m_mapped_banks.rom_switchable = m_rom.data() + switchable_bank_offset;
+}
+
+void Mbc::map_ram_bank(size_t offset) {
+    assert(offset + memmap::CartridgeRamSize <= m_ram.size() && "Mapped RAM bank out of bounds");
+    m_mapped_banks.ram = m_ram.data() + offset;
+}
+
+void Mbc::unmap_ram_bank() {
+    m_mapped_banks.ram = nullptr;
+}
+
+const MappedBanks& Mbc::get_mapped_banks() const {
+    return m_mapped_banks;
+}
+
 Mbc::~Mbc() = default;
 
 const RomInfo& Mbc::get_rom_info() const {
@@ -51,7 +117,7 @@ const RamInfo& Mbc::get_ram_info() const {
     return m_ram_info;
 }
 
-RomInfo Mbc::read_rom_size_info(std::span<uint8_t> rom) {
+RomInfo Mbc::read_rom_size_info(std::span<const uint8_t> rom) {
     auto val = rom[ROM_SIZE];
     if (val > 0x8) {
         throw LogicError("Invalid value for ROM size");
@@ -60,7 +126,7 @@ RomInfo Mbc::read_rom_size_info(std::span<uint8_t> rom) {
             .num_banks = static_cast<size_t>(1 << (val + 1))};
 }
 
-RamInfo Mbc::read_ram_size_info(std::span<uint8_t> rom) {
+RamInfo Mbc::read_ram_size_info(std::span<const uint8_t> rom) {
     auto val = rom[RAM_SIZE];
     switch (val) {
     case 0:
@@ -2,18 +2,26 @@
 
 #include "spdlog/fwd.h"
 #include "cartridge_info.hpp"
-#include <vector>
+class StateWriter;
+class StateReader;
+#include <cstdint>
 #include <memory>
 #include <span>
+#include <vector>
 
 class Mbc {
-    std::vector<uint8_t> m_rom;
+    // A view of the memory mapped ROM file, which is owned by the cartridge.
+    std::span<const uint8_t> m_rom;
     // A view of the memory mapped file representing the ram.
     std::span<uint8_t> m_ram;
     std::shared_ptr<spdlog::logger> m_logger;
 
     RomInfo m_rom_info;
     RamInfo m_ram_info;
+    // Bit n is set if RAM page n was written since the last call to clear_dirty_ram_pages.
+    std::vector<uint64_t> m_dirty_ram_pages;
+    bool m_ram_dirty = false;
+    MappedBanks m_mapped_banks;
 
 protected:
     // Protect them to avoid polymorphic copying, which would lead to slicing.
@@ -22,20 +30,44 @@ protected:
     Mbc& operator=(const Mbc&) = default;
     Mbc& operator=(Mbc&&) = default;
 
-    std::vector<uint8_t>& get_rom();
-    [[nodiscard]] const std::vector<uint8_t>& get_rom() const;
+    [[nodiscard]] std::span<const uint8_t> get_rom() const;
     [[nodiscard]] std::span<uint8_t> get_ram();
     [[nodiscard]] std::span<const uint8_t> get_ram() const;
+    // All writes to RAM have to go through this to be tracked for saving.
+    void write_ram(size_t address_in_ram, uint8_t value);
+    // Update the mapped banks, has to be called by the MBCs whenever a register write changes them.
+    // Offsets are in bytes from the start of ROM/RAM.
+    void map_rom_banks(size_t fixed_bank_offset, size_t switchable_bank_offset);
+    void map_ram_bank(size_t offset);
+    void unmap_ram_bank();
     [[nodiscard]] std::shared_ptr<spdlog::logger> get_logger() const;
     [[nodiscard]] const RomInfo& get_rom_info() const;
     [[nodiscard]] const RamInfo& get_ram_info() const;
 
 public:
+    // Size of the RAM pages for which writes are tracked
+    static constexpr size_t RAM_PAGE_SIZE = 256;
+
     [[nodiscard]] virtual uint8_t read_byte(uint16_t address) const = 0;
     virtual void write_byte(uint16_t address, uint8_t value) = 0;
-    Mbc(std::vector<uint8_t> rom, std::span<uint8_t> ram);
+    Mbc(std::span<const uint8_t> rom, std::span<uint8_t> ram);
     virtual ~Mbc();
 
-    [[nodiscard]] static RomInfo read_rom_size_info(std::span<uint8_t> rom);
-    [[nodiscard]] static RamInfo read_ram_size_info(std::span<uint8_t> rom);
+    [[nodiscard]] const MappedBanks& get_mapped_banks() const;
+    // Replace the default logger by the logger of the emulator
+    void set_logger(std::shared_ptr<spdlog::logger> logger);
+
+    // True if RAM was written since the last call to clear_dirty_ram_pages.
+    [[nodiscard]] bool is_ram_dirty() const;
+    // Bitmap of the RAM pages written since the last call to clear_dirty_ram_pages.
+    [[nodiscard]] std::span<const uint64_t> get_dirty_ram_pages() const;
+    void clear_dirty_ram_pages();
+
+    // Saves the RAM, MBCs with registers save them after it. Loading a state marks all of RAM as
+    // dirty, so it is written to the battery file.
+    virtual void save_state(StateWriter& writer) const;
+    virtual void load_state(StateReader& reader);
+
+    [[nodiscard]] static RomInfo read_rom_size_info(std::span<const uint8_t> rom);
+    [[nodiscard]] static RamInfo read_ram_size_info(std::span<const uint8_t> rom);
 };
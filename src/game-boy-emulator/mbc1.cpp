@@ -2,14 +2,13 @@
 
 #include "mbc.hpp"
 #include "memorymap.hpp"
+#include "savestate.hpp"
 #include "bitmanipulation.hpp"
 #include "exceptions.hpp"
 #include "fmt/format.h"
 #include <cassert>
 #include <cstdint>
-#include <vector>
 #include <span>
-#include <utility>
 #include <cmath>
 #include "spdlog/logger.h"
 
@@ -27,6 +26,8 @@ uint32_t Mbc1::get_address_in_rom(uint16_t address, uint32_t bank_number) const
 }
 
 uint8_t Mbc1::read_byte(uint16_t address) const {
+    // The address bus reads ROM through the mapped banks, computing the address from the registers
+    // here is the reference for them.
     if (memmap::is_in(address, memmap::CartridgeRomFixedBank)) {
         uint32_t bank_number = 0;
         if (m_banking_mode_select == 1) {
@@ -78,10 +79,27 @@ void Mbc1::write_registers(uint16_t address, uint8_t value) {
     } else if (memmap::is_in(address, memmap::BankingModeSelect)) {
         m_banking_mode_select = value & 1;
     }
+    update_mapped_banks();
     get_logger()->debug("Cartridge registers: RAMG {:02X}, BANK1 {:05B}, BANK2 {:02b}, MODE {:1B}",
                         m_ramg, m_bank1, m_bank2, m_banking_mode_select);
 }
 
+void Mbc1::update_mapped_banks() {
+    // In advanced banking mode BANK2 also selects the bank mapped to the fixed bank area
+    uint32_t fixed_bank_number = 0;
+    if (m_banking_mode_select == 1) {
+        fixed_bank_number = static_cast<uint32_t>(m_bank2 << 5);
+    }
+    const auto switchable_bank_number = static_cast<uint32_t>((m_bank2 << 5) | m_bank1);
+    map_rom_banks(get_address_in_rom(0, fixed_bank_number),
+                  get_address_in_rom(0, switchable_bank_number));
+    if (m_ramg == RAM_ENABLE_VALUE && !get_ram().empty()) {
+        map_ram_bank(get_address_in_ram(memmap::CartridgeRamBegin));
+    } else {
+        unmap_ram_bank();
+    }
+}
+
 uint32_t Mbc1::get_address_in_ram(uint16_t address) const {
     if (m_banking_mode_select == 0) {
         // In simple banking mode only bank 0 can be accessed
@@ -103,12 +121,29 @@ void Mbc1::write_values(uint16_t address, uint8_t value) {
     }
     auto address_in_ram = get_address_in_ram(address);
     assert(address_in_ram < get_ram().size() && "Write to cartridge RAM bank out of bounds");
-    get_ram()[address_in_ram] = value;
+    write_ram(address_in_ram, value);
 }
 
-Mbc1::Mbc1(std::vector<uint8_t> rom, std::span<uint8_t> ram) :
-        Mbc(std::move(rom), ram),
+Mbc1::Mbc1(std::span<const uint8_t> rom, std::span<uint8_t> ram) :
+        Mbc(rom, ram),
         m_required_rom_bits(static_cast<decltype(m_required_rom_bits)>(
             std::ceil(std::log2(get_rom_info().size_bytes)))),
         m_required_ram_bits(static_cast<decltype(m_required_ram_bits)>(
             std::ceil(std::log2(get_ram_info().size_bytes)))) {}
+
+void Mbc1::save_state(StateWriter& writer) const {
+    Mbc::save_state(writer);
+    writer.write(m_ramg);
+    writer.write(m_bank1);
+    writer.write(m_bank2);
+    writer.write(m_banking_mode_select);
+}
+
+void Mbc1::load_state(StateReader& reader) {
+    Mbc::load_state(reader);
+    reader.read(m_ramg);
+    reader.read(m_bank1);
+    reader.read(m_bank2);
+    reader.read(m_banking_mode_select);
+    update_mapped_banks();
+}
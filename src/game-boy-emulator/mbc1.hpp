@@ -21,12 +21,15 @@ class Mbc1 : public Mbc {
 
     void write_registers(uint16_t address, uint8_t value);
     void write_values(uint16_t address, uint8_t value);
+    void update_mapped_banks();
 
     [[nodiscard]] uint32_t get_address_in_rom(uint16_t address, uint32_t bank_number) const;
     [[nodiscard]] uint32_t get_address_in_ram(uint16_t address) const;
 
 public:
-    Mbc1(std::vector<uint8_t> rom, std::span<uint8_t> ram);
+    Mbc1(std::span<const uint8_t> rom, std::span<uint8_t> ram);
     [[nodiscard]] uint8_t read_byte(uint16_t address) const override;
     void write_byte(uint16_t address, uint8_t value) override;
+    void save_state(StateWriter& writer) const override;
+    void load_state(StateReader& reader) override;
 };
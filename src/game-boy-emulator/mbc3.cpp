@@ -1,6 +1,7 @@
 #include "mbc3.hpp"
 
 #include "memorymap.hpp"
+#include "savestate.hpp"
 #include "exceptions.hpp"
 
 #include "spdlog/logger.h"
@@ -12,18 +13,25 @@
 #include <cstddef>
 
 
+Mbc3::Mbc3(std::span<const uint8_t> rom, std::span<uint8_t> ram, Rtc* rtc) :
+        Mbc(rom, ram), m_rtc(rtc) {
+    update_mapped_banks();
+}
+
 uint8_t Mbc3::read_byte(uint16_t address) const {
+    // The address bus reads ROM through the mapped banks, computing the address from the registers
+    // here is the reference for them.
     if (memmap::is_in(address, memmap::CartridgeRomFixedBank)) {
         // Bank 0 is fixed. Subtracting offset from address is not required since the bank zeroes
         // address range starts at 0.
         return get_rom()[address];
     }
     if (memmap::is_in(address, memmap::CartridgeRomBankSwitchable)) {
-        const auto address_in_rom = address - memmap::CartridgeRomBankSwitchableBegin
-                                    + (m_rom_bank_number * memmap::CartridgeRomBankSwitchableSize);
-        assert(address_in_rom < static_cast<int>(get_rom().size())
-               && "Read ROM switchable bank out of bounds");
-        return get_rom()[static_cast<size_t>(address_in_rom)];
+        const size_t rom_bank_number = m_rom_bank_number % get_rom_info().num_banks;
+        const size_t address_in_rom = address - memmap::CartridgeRomBankSwitchableBegin
+                                      + (rom_bank_number * memmap::CartridgeRomBankSwitchableSize);
+        assert(address_in_rom < get_rom().size() && "Read ROM switchable bank out of bounds");
+        return get_rom()[address_in_rom];
     }
     if (memmap::is_in(address, memmap::CartridgeRam)) {
         if (m_ram_or_rtc_mapped == RamOrRtcMapped::RamMapped) {
@@ -35,27 +43,20 @@ uint8_t Mbc3::read_byte(uint16_t address) const {
             return get_ram()[static_cast<size_t>(address_in_ram)];
         }
         // RTC mapped
-        switch (m_current_rtc_register) {
-        case RtcRegisterValue::RTC_S:
-            return m_rtc.m_seconds;
-        case RtcRegisterValue::RTC_M:
-            return m_rtc.m_minutes;
-        case RtcRegisterValue::RTC_H:
-            return m_rtc.m_hours;
-        case RtcRegisterValue::RTC_DL:
-            return m_rtc.m_days_low;
-        case RtcRegisterValue::RTC_DH:
-            return m_rtc.m_days_high_and_flags;
-        default:
-            assert(false && "Unknown RTC register");
+        if (m_rtc == nullptr) {
+            return 0xFF;
         }
+        return m_rtc->read(get_current_rtc_register());
     }
     throw LogicError(fmt::format("Cartridge trying to read from {:04X}", address));
 }
 
 void Mbc3::write_byte(uint16_t address, uint8_t value) {
-    write_registers(address, value);
-    write_values(address, value);
+    if (memmap::is_in(address, memmap::CartridgeRam)) {
+        write_values(address, value);
+    } else {
+        write_registers(address, value);
+    }
 }
 
 void Mbc3::write_registers(uint16_t address, uint8_t value) {
@@ -74,6 +75,7 @@ void Mbc3::write_registers(uint16_t address, uint8_t value) {
             value = 1;
         }
         m_rom_bank_number = (value & 0b1111111);
+        update_mapped_banks();
     } else if (memmap::is_in(address, memmap::RamBankNumber)) {
         // Ram bank number or RTC register select
         if (value <= 3) {
@@ -89,50 +91,85 @@ void Mbc3::write_registers(uint16_t address, uint8_t value) {
                 get_logger()->warn("Ineffective write to cartridge register {:04X}", address);
             }
         }
+        update_mapped_banks();
     } else if (memmap::is_in(address, memmap::BankingModeSelect)) {
         // Latch clock data if previous write was 0x0 and this write was 0x1
-        get_logger()->warn("Latch clock data not implemented");
+        if (m_rtc != nullptr) {
+            m_rtc->write_latch(value);
+        }
     }
     //    get_logger()->debug("Cartridge registers: RAMG {}, BANK1 {:05B}, BANK2 {:02b}, MODE
     //    {:1B}",
     //                        m_ram_and_timer_enable, m_bank1, m_bank2, m_banking_mode_select);
 }
 
+Rtc::Register Mbc3::get_current_rtc_register() const {
+    switch (m_current_rtc_register) {
+    case RtcRegisterValue::RTC_S:
+        return Rtc::Register::Seconds;
+    case RtcRegisterValue::RTC_M:
+        return Rtc::Register::Minutes;
+    case RtcRegisterValue::RTC_H:
+        return Rtc::Register::Hours;
+    case RtcRegisterValue::RTC_DL:
+        return Rtc::Register::DaysLow;
+    case RtcRegisterValue::RTC_DH:
+        return Rtc::Register::DaysHigh;
+    }
+    throw LogicError("Unknown RTC register");
+}
+
+void Mbc3::update_mapped_banks() {
+    // Bank numbers larger than the ROM wrap around
+    const size_t rom_bank_number = m_rom_bank_number % get_rom_info().num_banks;
+    map_rom_banks(0, rom_bank_number * memmap::CartridgeRomBankSwitchableSize);
+    const size_t ram_bank_offset = m_ram_bank_number * memmap::CartridgeRamSize;
+    // RAM reads of MBC3 don't depend on the RAM enable register
+    if (m_ram_or_rtc_mapped == RamOrRtcMapped::RamMapped
+        && ram_bank_offset + memmap::CartridgeRamSize <= get_ram().size()) {
+        map_ram_bank(ram_bank_offset);
+    } else {
+        unmap_ram_bank();
+    }
+}
+
 void Mbc3::write_values(uint16_t address, uint8_t value) {
     // Actual RAM/RTC writes
-    if (memmap::is_in(address, memmap::CartridgeRam)) {
-        if (!m_ram_and_timer_enable) {
-            get_logger()->warn("Write to {:04X} with disabled ram/timer");
-            return;
-        }
-        if (m_ram_or_rtc_mapped == RamOrRtcMapped::RamMapped) {
-            // Access RAM
-            const auto address_in_ram = address - memmap::CartridgeRamBegin
-                                        + (m_ram_bank_number * memmap::CartridgeRamSize);
-            assert(address_in_ram < static_cast<int>(get_ram().size())
-                   && "Write to cartridge RAM bank out of bounds");
-            get_ram()[static_cast<size_t>(address_in_ram)] = value;
-        } else {
-            // Access RTC
-            switch (m_current_rtc_register) {
-            case RtcRegisterValue::RTC_S:
-                m_rtc.m_seconds = value;
-                break;
-            case RtcRegisterValue::RTC_M:
-                m_rtc.m_minutes = value;
-                break;
-            case RtcRegisterValue::RTC_H:
-                m_rtc.m_hours = value;
-                break;
-            case RtcRegisterValue::RTC_DL:
-                m_rtc.m_days_low = value;
-                break;
-            case RtcRegisterValue::RTC_DH:
-                m_rtc.m_days_high_and_flags = value;
-                break;
-            default:
-                assert(false && "Unknown RTC register");
-            }
+    if (!m_ram_and_timer_enable) {
+        get_logger()->warn("Write to {:04X} with disabled ram/timer", address);
+        return;
+    }
+    if (m_ram_or_rtc_mapped == RamOrRtcMapped::RamMapped) {
+        // Access RAM
+        const auto address_in_ram = address - memmap::CartridgeRamBegin
+                                    + (m_ram_bank_number * memmap::CartridgeRamSize);
+        assert(address_in_ram < static_cast<int>(get_ram().size())
+               && "Write to cartridge RAM bank out of bounds");
+        write_ram(static_cast<size_t>(address_in_ram), value);
+    } else {
+        // Access RTC
+        if (m_rtc != nullptr) {
+            m_rtc->write(get_current_rtc_register(), value);
         }
     }
 }
+
+// The RTC is saved by the cartridge.
+void Mbc3::save_state(StateWriter& writer) const {
+    Mbc::save_state(writer);
+    writer.write(m_ram_and_timer_enable);
+    writer.write(m_rom_bank_number);
+    writer.write(m_ram_bank_number);
+    writer.write(m_ram_or_rtc_mapped);
+    writer.write(m_current_rtc_register);
+}
+
+void Mbc3::load_state(StateReader& reader) {
+    Mbc::load_state(reader);
+    reader.read(m_ram_and_timer_enable);
+    reader.read(m_rom_bank_number);
+    reader.read(m_ram_bank_number);
+    reader.read(m_ram_or_rtc_mapped);
+    reader.read(m_current_rtc_register);
+    update_mapped_banks();
+}
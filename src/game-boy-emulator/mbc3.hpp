@@ -1,17 +1,7 @@
 #pragma once
 
 #include "mbc.hpp"
-#include <functional>
-
-struct Rtc {
-    uint8_t m_seconds = 0;
-    uint8_t m_minutes = 0;
-    uint8_t m_hours = 0;
-    // Lower 8 bits of day counter
-    uint8_t m_days_low = 0;
-    // Upper 1 bit of day counter, halt and Day counter carry bit
-    uint8_t m_days_high_and_flags = 0;
-};
+#include "rtc.hpp"
 
 class Mbc3 : public Mbc {
     // Registers
@@ -28,7 +18,8 @@ class Mbc3 : public Mbc {
     };
     RamOrRtcMapped m_ram_or_rtc_mapped = RamOrRtcMapped::RamMapped;
 
-    Rtc m_rtc{};
+    // Owned by the cartridge, nullptr for cartridges without timer.
+    Rtc* m_rtc;
 
     // Value required to map the corresponding RTC register to A000-BFFF
     enum class RtcRegisterValue: uint8_t {
@@ -44,9 +35,13 @@ class Mbc3 : public Mbc {
 
     void write_registers(uint16_t address, uint8_t value);
     void write_values(uint16_t address, uint8_t value);
+    void update_mapped_banks();
+    [[nodiscard]] Rtc::Register get_current_rtc_register() const;
 
 public:
-    using Mbc::Mbc;
+    Mbc3(std::span<const uint8_t> rom, std::span<uint8_t> ram, Rtc* rtc);
     [[nodiscard]] uint8_t read_byte(uint16_t address) const override;
     void write_byte(uint16_t address, uint8_t value) override;
+    void save_state(StateWriter& writer) const override;
+    void load_state(StateReader& reader) override;
 };
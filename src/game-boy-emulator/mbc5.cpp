@@ -2,6 +2,7 @@
 
 #include "mbc.hpp"
 #include "memorymap.hpp"
+#include "savestate.hpp"
 #include "bitmanipulation.hpp"
 #include "exceptions.hpp"
 
@@ -9,16 +10,14 @@
 #include "spdlog/logger.h"
 
 #include <cassert>
-#include <vector>
 #include <cstdint>
 #include <span>
-#include <utility>
 #include <cmath>
 #include <cstddef>
 
 
-Mbc5::Mbc5(std::vector<uint8_t> rom, std::span<uint8_t> ram) :
-        Mbc(std::move(rom), ram),
+Mbc5::Mbc5(std::span<const uint8_t> rom, std::span<uint8_t> ram) :
+        Mbc(rom, ram),
         m_required_rom_bits(static_cast<decltype(m_required_rom_bits)>(
             std::ceil(std::log2(get_rom_info().size_bytes)))),
         m_required_ram_bits(static_cast<decltype(m_required_ram_bits)>(
@@ -32,6 +31,8 @@ bool decide_ram_enable(uint8_t value) {
 } // namespace
 
 uint8_t Mbc5::read_byte(uint16_t address) const {
+    // The address bus reads ROM through the mapped banks, computing the address from the registers
+    // here is the reference for them.
     if (memmap::is_in(address, memmap::CartridgeRomFixedBank)) {
         assert(address < get_rom().size() && "Read ROM fixed bank out of bounds");
         // Subtracting start not required because the address range starts at 0.
@@ -43,7 +44,7 @@ uint8_t Mbc5::read_byte(uint16_t address) const {
         const size_t address_in_bank = address - memmap::CartridgeRomBankSwitchableBegin;
         auto address_rom = address_bank_begin + address_in_bank;
         address_rom = bitmanip::mask(address_rom, m_required_rom_bits);
-        assert(address_rom < get_rom().size() && "Read to cartridge RAM bank out of bounds");
+        assert(address_rom < get_rom().size() && "Read ROM switchable bank out of bounds");
         return get_rom()[address_rom];
     }
     if (memmap::is_in(address, memmap::CartridgeRam)) {
@@ -85,6 +86,7 @@ void Mbc5::write_registers(uint16_t address, uint8_t value) {
     } else if (memmap::is_in(address, memmap::RamBankNumber)) {
         m_ram_bank_number = value;
     }
+    update_mapped_banks();
     get_logger()->debug("MBC5 registers: RAM enable {} RAM bank {} ROM_LOW {} ROM_HIGH {}",
                         m_ram_enable, m_ram_bank_number, m_rom_bank_number_low,
                         m_rom_bank_number_high);
@@ -102,9 +104,37 @@ void Mbc5::write_values(uint16_t address, uint8_t value) {
     auto address_in_ram = address_bank_begin + address_in_bank;
     address_in_ram = bitmanip::mask(address_in_ram, m_required_ram_bits);
     assert(address_in_ram < get_ram().size() && "Read to cartridge RAM bank out of bounds");
-    get_ram()[address_in_ram] = value;
+    write_ram(address_in_ram, value);
+}
+
+void Mbc5::update_mapped_banks() {
+    const size_t rom_bank_begin = get_rom_bank_number() * memmap::CartridgeRomBankSwitchableSize;
+    map_rom_banks(0, bitmanip::mask(rom_bank_begin, m_required_rom_bits));
+    if (m_ram_enable && !get_ram().empty()) {
+        const size_t ram_bank_begin = (m_ram_bank_number & 0x0F) * memmap::CartridgeRamSize;
+        map_ram_bank(bitmanip::mask(ram_bank_begin, m_required_ram_bits));
+    } else {
+        unmap_ram_bank();
+    }
 }
 
 uint16_t Mbc5::get_rom_bank_number() const {
     return bitmanip::word_from_bytes(m_rom_bank_number_high & 1, m_rom_bank_number_low);
 }
+
+void Mbc5::save_state(StateWriter& writer) const {
+    Mbc::save_state(writer);
+    writer.write(m_ram_enable);
+    writer.write(m_rom_bank_number_low);
+    writer.write(m_rom_bank_number_high);
+    writer.write(m_ram_bank_number);
+}
+
+void Mbc5::load_state(StateReader& reader) {
+    Mbc::load_state(reader);
+    reader.read(m_ram_enable);
+    reader.read(m_rom_bank_number_low);
+    reader.read(m_rom_bank_number_high);
+    reader.read(m_ram_bank_number);
+    update_mapped_banks();
+}
@@ -21,11 +21,14 @@ class Mbc5 : public Mbc {
 
     void write_registers(uint16_t address, uint8_t value);
     void write_values(uint16_t address, uint8_t value);
+    void update_mapped_banks();
 
     [[nodiscard]] uint16_t get_rom_bank_number() const;
 
 public:
-    Mbc5(std::vector<uint8_t> rom, std::span<uint8_t> ram);
+    Mbc5(std::span<const uint8_t> rom, std::span<uint8_t> ram);
     [[nodiscard]] uint8_t read_byte(uint16_t address) const override;
     void write_byte(uint16_t address, uint8_t value) override;
+    void save_state(StateWriter& writer) const override;
+    void load_state(StateReader& reader) override;
 };
@@ -1,6 +1,7 @@
 #include "memorymappedfile.hpp"
 #include "io.hpp"
 #include <filesystem>
+#include <cassert>
 #include <cstddef>
 #include <span>
 #include <cstdint>
@@ -20,14 +21,34 @@ MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& filepath, size_t
                                                          m_file_size};
 }
 
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& filepath) :
+        m_file_size(std::filesystem::file_size(filepath)), m_read_only(true) {
+    m_file = boost::interprocess::file_mapping{filepath.string().c_str(),
+                                               boost::interprocess::read_only};
+    // read_private maps with MAP_PRIVATE and PROT_READ. Pages are shared with the page cache and
+    // all other mappings of the file.
+    m_mapped_region = boost::interprocess::mapped_region{
+        m_file, boost::interprocess::read_private, 0, m_file_size};
+}
+
 std::span<uint8_t> MemoryMappedFile::get_data() {
+    assert(!m_read_only && "Mutable access to read-only file mapping");
     return {std::bit_cast<uint8_t*>(m_mapped_region.get_address()), m_file_size};
 }
 
+std::span<const uint8_t> MemoryMappedFile::get_data() const {
+    return {std::bit_cast<const uint8_t*>(m_mapped_region.get_address()), m_file_size};
+}
+
 void MemoryMappedFile::sync(bool async) {
+    if (m_read_only) {
+        return;
+    }
     m_mapped_region.flush(0, 0, async);
 }
 
 MemoryMappedFile::~MemoryMappedFile() {
-    m_mapped_region.flush(0, 0, true);
+    if (!m_read_only) {
+        m_mapped_region.flush(0, 0, true);
+    }
 }
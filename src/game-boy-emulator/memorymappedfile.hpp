@@ -10,10 +10,16 @@ class MemoryMappedFile {
     size_t m_file_size;
     boost::interprocess::file_mapping m_file;
     boost::interprocess::mapped_region m_mapped_region;
+    bool m_read_only = false;
 
 public:
+    // Map a file for reading and writing, creating it with the given size if it does not exist.
     MemoryMappedFile(const std::filesystem::path& filepath, size_t file_size);
+    // Map a whole existing file read-only. The mapping is private, so it is never written back.
+    explicit MemoryMappedFile(const std::filesystem::path& filepath);
+    // Only allowed for files mapped for writing
     std::span<uint8_t> get_data();
+    [[nodiscard]] std::span<const uint8_t> get_data() const;
     void sync(bool async = false);
 
     ~MemoryMappedFile();
@@ -1,6 +1,196 @@
 #include "noisechannel.hpp"
+#include "audiochannel.hpp"
+#include "bitmanipulation.hpp"
+#include "savestate.hpp"
+#include <array>
 #include <cstdint>
+#include <cstddef>
+
+namespace {
+constexpr int LFSR_BITS = 15;
+// The 15 bit LFSR visits all non-zero states before repeating.
+constexpr size_t PERIOD_LONG = (1U << LFSR_BITS) - 1;
+// In short mode the lower 7 bits form a LFSR with period 127. The upper bits are completely
+// determined by the lower bits after the first 8 clocks (shifted in feedback bits).
+constexpr size_t PERIOD_SHORT = (1U << 7) - 1;
+constexpr size_t TRANSIENT_SHORT = 8;
+
+constexpr uint16_t step_impl(uint16_t state, bool short_mode) {
+    const uint16_t feedback = (state ^ (state >> 1)) & 1;
+    state = static_cast<uint16_t>((state >> 1) | (feedback << 14));
+    if (short_mode) {
+        state = static_cast<uint16_t>((state & ~(1U << 6)) | (feedback << 6));
+    }
+    return state;
+}
+
+// Clocking the LFSR is a linear function over GF(2), so it can be described by a 15x15 bit
+// matrix. Each matrix is stored as its columns, where column i is the result of applying the
+// matrix to the state with only bit i set.
+using Matrix = std::array<uint16_t, LFSR_BITS>;
+
+constexpr uint16_t apply_matrix(const Matrix& matrix, uint16_t state) {
+    uint16_t out = 0;
+    for (int i = 0; i < LFSR_BITS; ++i) {
+        if (((state >> i) & 1) != 0) {
+            out ^= matrix[static_cast<size_t>(i)];
+        }
+    }
+    return out;
+}
+
+// Table entry k contains the matrix advancing the LFSR by 2^k clocks.
+using JumpTable = std::array<Matrix, LFSR_BITS>;
+
+constexpr JumpTable make_jump_table(bool short_mode) {
+    JumpTable table{};
+    for (int i = 0; i < LFSR_BITS; ++i) {
+        table[0][static_cast<size_t>(i)] = step_impl(static_cast<uint16_t>(1U << i), short_mode);
+    }
+    for (size_t k = 1; k < table.size(); ++k) {
+        // Squaring the previous matrix doubles the number of clocks.
+        for (size_t i = 0; i < table[k].size(); ++i) {
+            table[k][i] = apply_matrix(table[k - 1], table[k - 1][i]);
+        }
+    }
+    return table;
+}
+
+constexpr JumpTable JUMP_TABLE_LONG = make_jump_table(false);
+constexpr JumpTable JUMP_TABLE_SHORT = make_jump_table(true);
+
+// Below this number of clocks stepping one by one is cheaper than using the jump table.
+constexpr size_t SINGLE_STEP_LIMIT = 8;
+} // namespace
+
+namespace lfsr {
+
+uint16_t step(uint16_t state, bool short_mode) {
+    return step_impl(state, short_mode);
+}
+
+uint16_t advance(uint16_t state, bool short_mode, size_t n) {
+    if (n < SINGLE_STEP_LIMIT) {
+        for (size_t i = 0; i < n; ++i) {
+            state = step_impl(state, short_mode);
+        }
+        return state;
+    }
+    // Reduce the number of clocks to less than one period of the LFSR, which leaves a number
+    // with at most 15 bits.
+    if (short_mode) {
+        n = TRANSIENT_SHORT + ((n - TRANSIENT_SHORT) % PERIOD_SHORT);
+    } else {
+        n %= PERIOD_LONG;
+    }
+    const auto& table = short_mode ? JUMP_TABLE_SHORT : JUMP_TABLE_LONG;
+    for (size_t k = 0; n != 0; ++k, n >>= 1) {
+        if ((n & 1) != 0) {
+            state = apply_matrix(table[k], state);
+        }
+    }
+    return state;
+}
+
+} // namespace lfsr
+
+namespace {
+constexpr unsigned NOISE_LENGTH_TIMER_MAX = 64;
+} // namespace
+
+void NoiseChannel::advance_waveform(size_t steps) {
+    // Clock shifts of 14 and 15 stop the LFSR from being clocked at all.
+    if (get_clock_shift() < 14) {
+        m_lfsr = lfsr::advance(m_lfsr, is_short_mode(), steps);
+    }
+}
 
 uint8_t NoiseChannel::get_sample() {
-    return 0;
+    // The output is the inverted bit 0 of the LFSR.
+    const auto output = static_cast<uint8_t>(~m_lfsr & 1);
+    return output * get_current_volume();
+}
+
+void NoiseChannel::trigger() {
+    trigger_envelope();
+    if (!is_dac_enabled()) {
+        set_enabled(false);
+        return;
+    }
+    m_lfsr = lfsr::INITIAL_STATE;
+    restart_period();
+    if (m_length_timer == NOISE_LENGTH_TIMER_MAX) {
+        m_length_timer = 0;
+    }
+}
+
+void NoiseChannel::do_sound_length() {
+    if (!is_length_enabled() || m_length_timer == NOISE_LENGTH_TIMER_MAX) {
+        return;
+    }
+    m_length_timer++;
+    if (m_length_timer == NOISE_LENGTH_TIMER_MAX) {
+        set_enabled(false);
+    }
+}
+
+void NoiseChannel::set_nrx1(uint8_t value) {
+    AudioChannel::set_nrx1(value);
+    m_length_timer = value & 0b111111;
+}
+
+void NoiseChannel::set_nrx2(uint8_t value) {
+    AudioChannel::set_nrx2(value);
+    if (!is_dac_enabled()) {
+        // Turning the DAC off also disables the channel.
+        set_enabled(false);
+    }
+}
+
+void NoiseChannel::set_nrx4(uint8_t value) {
+    AudioChannel::set_nrx4(value);
+    if (bitmanip::is_bit_set(value, 7)) {
+        set_enabled(true);
+        trigger();
+    }
+}
+
+bool NoiseChannel::is_dac_enabled() const {
+    return (read_nrx2() & 0b11111000) != 0;
+}
+
+uint8_t NoiseChannel::get_clock_shift() const {
+    return (read_nrx3() & 0b11110000) >> 4;
+}
+
+bool NoiseChannel::is_short_mode() const {
+    return bitmanip::is_bit_set(read_nrx3(), 3);
+}
+
+uint8_t NoiseChannel::get_clock_divider() const {
+    return read_nrx3() & 0b111;
+}
+
+size_t NoiseChannel::get_period() const {
+    // A divider of 0 is treated as 0.5. In T cycles this gives a base period of 8 for divider 0
+    // and 16 * divider otherwise, which is then shifted by the clock shift.
+    const size_t divider = get_clock_divider();
+    const size_t base_period = (divider == 0) ? 8 : divider * 16;
+    return base_period << get_clock_shift();
+}
+
+bool NoiseChannel::is_length_enabled() const {
+    return bitmanip::is_bit_set(read_nrx4(), 6);
+}
+
+void NoiseChannel::save_state(StateWriter& writer) const {
+    AudioChannel::save_state(writer);
+    writer.write(m_lfsr);
+    writer.write(m_length_timer);
+}
+
+void NoiseChannel::load_state(StateReader& reader) {
+    AudioChannel::load_state(reader);
+    reader.read(m_lfsr);
+    reader.read(m_length_timer);
 }
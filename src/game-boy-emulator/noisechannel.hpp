@@ -1,8 +1,56 @@
 #pragma once
 
 #include "audiochannel.hpp"
+#include <cstddef>
+#include <cstdint>
 
+namespace lfsr {
+// LFSR state after triggering the noise channel
+constexpr uint16_t INITIAL_STATE = 0x7FFF;
+
+// Clock the LFSR once. In short mode the feedback bit is also written to bit 6, which gives a
+// 7 bit LFSR.
+uint16_t step(uint16_t state, bool short_mode);
+
+// Clock the LFSR n times. Uses precomputed jump tables, so the cost is independent of n.
+uint16_t advance(uint16_t state, bool short_mode, size_t n);
+} // namespace lfsr
+
+/*
+ * Channel producing pseudo random noise from a linear feedback shift register.
+ * The LFSR is advanced in bulk by the number of clocks elapsed since the last catch up.
+ */
 class NoiseChannel : public AudioChannel {
+    uint16_t m_lfsr = lfsr::INITIAL_STATE;
+
+    // Counts up at 256 Hz, the channel is turned off when it reaches 64.
+    unsigned m_length_timer = 0;
+
+    // DAC is enabled when any of the bits 3..7 of NR42 are set
+    [[nodiscard]] bool is_dac_enabled() const;
+    // Bits 4..7 of NR43
+    [[nodiscard]] uint8_t get_clock_shift() const;
+    // Bit 3 of NR43
+    [[nodiscard]] bool is_short_mode() const;
+    // Bits 0..2 of NR43
+    [[nodiscard]] uint8_t get_clock_divider() const;
+    // Number of T cycles between two LFSR clocks
+    [[nodiscard]] size_t get_period() const override;
+    void advance_waveform(size_t steps) override;
+    // Bit 6 of NR44
+    [[nodiscard]] bool is_length_enabled() const;
+
+    void trigger();
+
 public:
     uint8_t get_sample() override;
+
+    void do_sound_length();
+
+    void set_nrx1(uint8_t value) override;
+    void set_nrx2(uint8_t value) override;
+    void set_nrx4(uint8_t value) override;
+
+    void save_state(StateWriter& writer) const override;
+    void load_state(StateReader& reader) override;
 };
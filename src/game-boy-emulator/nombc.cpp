@@ -5,6 +5,13 @@
 #include "exceptions.hpp"
 #include "spdlog/logger.h"
 
+NoMbc::NoMbc(std::span<const uint8_t> rom, std::span<uint8_t> ram) : Mbc(rom, ram) {
+    // Without an MBC, RAM is always accessible
+    if (!get_ram().empty()) {
+        map_ram_bank(0);
+    }
+}
+
 uint8_t NoMbc::read_byte(uint16_t address) const {
     if (memmap::is_in(address, memmap::CartridgeRom)) {
         return get_rom()[address];
@@ -30,6 +37,6 @@ void NoMbc::write_byte(uint16_t address, uint8_t value) {
         }
         const uint16_t relative_address = address - memmap::CartridgeRamBegin;
         assert(relative_address < get_ram().size() && "No MBC write out of bounds");
-        get_ram()[relative_address] = value;
+        write_ram(relative_address, value);
     }
 }
@@ -4,7 +4,7 @@
 
 class NoMbc : public Mbc {
 public:
-    using Mbc::Mbc;
+    NoMbc(std::span<const uint8_t> rom, std::span<uint8_t> ram);
     [[nodiscard]] uint8_t read_byte(uint16_t address) const override;
     void write_byte(uint16_t address, uint8_t value) override;
 };
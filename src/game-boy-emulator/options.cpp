@@ -1 +1,34 @@
 #include "options.hpp"
+
+#include <algorithm>
+
+int EmulatorOptions::get_frame_skip() const {
+    if (frame_skip != FRAME_SKIP_AUTO) {
+        return frame_skip;
+    }
+    // Display frames at the normal rate, the additional frames from fast-forwarding are skipped.
+    return fast_forward ? game_speed - 1 : 0;
+}
+
+int EmulatorOptions::get_speed() const {
+    return fast_forward ? std::max(game_speed, 1) : 1;
+}
+
+EmulatorOptions EmulatorOptions::headless() {
+    return {.draw_info_window = false,
+            .draw_debug_background = false,
+            .draw_debug_window = false,
+            .draw_debug_sprites = false,
+            .draw_debug_tiles = false,
+            .frame_skip = 0,
+            .sound_enabled = false,
+            .rtc_follows_emulated_time = true};
+}
+
+EmulatorOptions EmulatorOptions::reference() {
+    auto options = headless();
+    options.use_tile_cache = false;
+    options.use_mapped_banks = false;
+    options.lazy_audio_channels = false;
+    return options;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <filesystem>
+
 struct EmulatorOptions {
     // Used for unit test cpu state comparison. Fix LY (0xFF44) constantly at the given value if
     // this value is non negative.
@@ -12,10 +14,20 @@ struct EmulatorOptions {
     bool draw_debug_sprites = true;
     // Draw the complete tile map of the PPU
     bool draw_debug_tiles = true;
+    // The background, window and tile debug views are only updated this often (in Hz) while they
+    // are visible.
+    double debug_views_refresh_rate = 10.0;
+    // Stops emulation until unpaused
+    bool paused = false;
     // Controls fast-forward
     bool fast_forward = false;
     // Fast-forward multiplier
     int game_speed = 1;
+    // Value of frame_skip which selects the number of skipped frames from the fast-forward speed.
+    static constexpr int FRAME_SKIP_AUTO = -1;
+    // Number of frames which are emulated without rendering after every displayed frame. The PPU
+    // only does timing and interrupts for skipped frames.
+    int frame_skip = FRAME_SKIP_AUTO;
     bool sound_enabled = true;
     // Global sound volume
     float volume = 0.1f;
@@ -24,4 +36,42 @@ struct EmulatorOptions {
     bool apu_channel2_enabled = true;
     bool apu_channel3_enabled = true;
     bool apu_channel4_enabled = true;
+    // Battery backed cartridge RAM is written to disk at most this often, in milliseconds. Only
+    // pages changed by the game are written and it is always written when the game is closed.
+    int battery_ram_flush_interval_ms = 1000;
+    // Write the RAM to a temporary file which then replaces the RAM file, so the save survives a
+    // crash while writing.
+    bool battery_ram_atomic_save = false;
+    // The real time clock of MBC3 cartridges follows the emulated time, so it runs faster while
+    // fast-forwarding and stops while paused or when the game is closed. Otherwise it follows the
+    // wall time.
+    bool rtc_follows_emulated_time = false;
+    // Write the CPU state before every instruction to this file as a binary trace, which can be
+    // compared with a reference log by compare_cpu_trace. Only read when the emulator is created,
+    // no trace is written if it is empty.
+    std::filesystem::path cpu_trace_path{};
+    // The following select between a fast path and the straightforward reference implementation it
+    // replaces, so shadow execution can check that both behave the same. They are only read when
+    // the emulator is created.
+    // Draw tiles from the decoded tile cache instead of decoding every tile line from VRAM.
+    bool use_tile_cache = true;
+    // Read cartridge memory through the mapped bank pointers instead of letting the MBC compute
+    // the address from its registers on every read.
+    bool use_mapped_banks = true;
+    // Bring the audio channels up to date only when they are sampled or written, instead of every
+    // M cycle one waveform step at a time.
+    bool lazy_audio_channels = true;
+
+    // Number of frames to skip after every displayed frame, with FRAME_SKIP_AUTO resolved.
+    [[nodiscard]] int get_frame_skip() const;
+    // Multiplier for the emulation speed, game_speed while fast-forwarding and 1 otherwise.
+    [[nodiscard]] int get_speed() const;
+
+    // Options for running without a frontend: no debug views, every frame is rendered, no sound
+    // and the real time clock follows the emulated time, so runs are reproducible.
+    [[nodiscard]] static EmulatorOptions headless();
+    // Headless options with all fast paths replaced by their reference implementations.
+    [[nodiscard]] static EmulatorOptions reference();
+
+    bool operator==(const EmulatorOptions&) const = default;
 };
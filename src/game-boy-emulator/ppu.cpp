@@ -8,6 +8,7 @@
 #include "bitmanipulation.hpp"
 #include "graphics.hpp"
 #include "ppu_registers.hpp"
+#include "savestate.hpp"
 
 #include "fmt/format.h"
 #include "spdlog/spdlog.h"
@@ -18,17 +19,19 @@
 #include <cstddef>
 #include <cassert>
 #include <array>
+#include <bit>
+#include <bitset>
 #include <ranges>
 #include <span>
-#include <vector>
+#include <utility>
 
 Ppu::Ppu(Emulator* emulator) :
+        m_tile_cache(m_tile_data),
+        m_use_tile_cache(emulator->get_options().use_tile_cache),
         m_registers(emulator->get_options().stub_ly_value),
-        m_logger(spdlog::get("")),
+        m_logger(emulator->get_logger()),
         m_emulator(emulator),
-        m_game_framebuffer(graphics::gb::ColorScreen::White),
-        m_background_framebuffer(graphics::gb::ColorScreen::White),
-        m_window_framebuffer(graphics::gb::ColorScreen::White),
+        m_game_framebuffer(graphics::gb::ColorGb::White),
         m_oam_dma_transfer(emulator->get_bus(), std::as_writable_bytes(std::span{m_oam_ram})) {}
 
 
@@ -65,6 +68,7 @@ void Ppu::write_byte(uint16_t address, uint8_t value) {
             m_logger->error("PPU: VRAM write at {:04X} during pixel transfer", address);
         }
         m_tile_data[address - memmap::VRamBegin] = value;
+        m_tile_cache.invalidate(address - memmap::VRamBegin);
     } else if (memmap::is_in(address, memmap::PpuIoRegisters)) {
         m_registers.set_register_value(address, value);
     } else if (memmap::is_in(address, memmap::OamRam)) {
@@ -74,8 +78,14 @@ void Ppu::write_byte(uint16_t address, uint8_t value) {
             m_logger->error("PPU: Oam write at {:04X} during mode {}", address,
                             magic_enum::enum_name(m_registers.get_mode()));
         }
-        std::as_writable_bytes(std::span{m_oam_ram})[address - memmap::OamRamBegin]
-            = std::byte{value};
+        const auto oam_offset = address - memmap::OamRamBegin;
+        if (oam_offset % sizeof(OamEntry) == offsetof(OamEntry, m_y_position)) {
+            // Move the object to the lines covered at its new y position
+            const auto object_index = oam_offset / sizeof(OamEntry);
+            update_objects_on_line(object_index, m_oam_ram[object_index].m_y_position, false);
+            update_objects_on_line(object_index, value, true);
+        }
+        std::as_writable_bytes(std::span{m_oam_ram})[oam_offset] = std::byte{value};
     } else if (memmap::is_in(address, memmap::TileMaps)) {
         if (m_registers.is_ppu_enabled() && m_registers.get_mode() == PpuMode::PixelTransfer_3) {
             m_logger->error("PPU: VRAM write at {:04X} during pixel transfer", address);
@@ -99,6 +109,10 @@ void Ppu::cycle_elapsed_callback(size_t cycles_m_num) {
     if (m_registers.was_oam_transfer_requested()) {
         start_oam_dma_transfer();
     }
+    if (m_oam_dma_transfer.is_active()) {
+        // The transfer writes to OAM directly, so the objects on each line are rebuilt afterwards
+        m_objects_on_line_dirty = true;
+    }
     m_oam_dma_transfer.callback_cycle();
 
     (void)cycles_m_num;
@@ -177,19 +191,20 @@ void Ppu::do_mode0_hblank() {
         if (m_registers.get_register_value(PpuRegisters::Register::LyRegister) == 144) {
             new_mode = PpuMode::VBlank_1;
             m_registers.set_mode(new_mode);
-            auto options = m_emulator->get_options();
-            if (options.draw_debug_background) {
-                draw_background_debug();
-            }
-            if (options.draw_debug_window) {
-                draw_window_debug();
-            }
-            if (options.draw_debug_tiles) {
-                draw_vram_debug();
+            // Skipped frames don't render pixels, so there is nothing to update for the debug
+            // views or to reset.
+            const bool frame_skipped = m_emulator->is_frame_skipped();
+            if (!frame_skipped
+                && m_debug_views.is_update_due(
+                    m_emulator->get_options().debug_views_refresh_rate)) {
+                m_debug_views.update({m_tile_data, m_tile_maps, m_registers});
             }
+            m_debug_views.release_if_hidden();
             m_emulator->draw();
-            m_game_framebuffer.reset();
-            m_sprites_framebuffer.reset(graphics::gb::ColorScreen::TrueWhite);
+            if (!frame_skipped) {
+                m_game_framebuffer.reset();
+                reset_sprites_framebuffer();
+            }
             m_emulator->get_interrupt_handler()->request_interrupt(
                 InterruptHandler::InterruptType::VBlank);
             set_stat_interrupt_line_bit(PpuRegisters::StatInterruptSource::VBlank, 1);
@@ -243,31 +258,8 @@ void Ppu::set_stat_interrupt_line_bit(PpuRegisters::StatInterruptSource position
     bitmanip::set_bit(m_stat_interrupt_line, static_cast<uint8_t>(position), value);
 }
 
-std::span<uint8_t, constants::BYTES_PER_TILE> Ppu::get_tile(uint8_t tile_index) {
-    // Unsigned when bit 4 is set
-    if (m_registers.get_bg_win_address_mode() == PpuRegisters::BgWinAddressMode::Unsigned) {
-        // In unsigned indexing, the sprites are in order in memory, starting at 0x8000
-        const size_t index_begin = tile_index * constants::BYTES_PER_TILE;
-        return std::span<uint8_t, constants::BYTES_PER_TILE>{m_tile_data.data() + index_begin,
-                                                             constants::BYTES_PER_TILE};
-    }
-    // In signed indexing, the first 0-127 tiles are from 0x9000-0x97FF (last block of the tile
-    // data portion of the vram). The tiles 128-255 are in the second block from 0x8800-0x8FFF.
-    if (static_cast<int8_t>(tile_index) >= 0) {
-        // Skip the first 256 sprites (block 0 and 1) and index into block 2.
-        size_t const index_begin
-            = (256 * constants::BYTES_PER_TILE) + (tile_index * constants::BYTES_PER_TILE);
-        return std::span<uint8_t, constants::BYTES_PER_TILE>{m_tile_data.data() + index_begin,
-                                                             constants::BYTES_PER_TILE};
-    }
-    // Tiles 128-255 lie within block 1. We can use the index from 0;
-    size_t const index_begin = tile_index * constants::BYTES_PER_TILE;
-    return std::span<uint8_t, constants::BYTES_PER_TILE>{m_tile_data.data() + index_begin,
-                                                         constants::BYTES_PER_TILE};
-}
-
-std::span<uint8_t, constants::BYTES_PER_TILE>
-Ppu::get_tile_from_map(TileType tile_type, uint8_t tile_map_x, uint8_t tile_map_y) {
+size_t Ppu::get_tile_number_from_map(TileType tile_type, unsigned tile_map_x,
+                                     unsigned tile_map_y) const {
     unsigned address_offset = 0;
     switch (tile_type) {
     case TileType::Background:
@@ -284,21 +276,16 @@ Ppu::get_tile_from_map(TileType tile_type, uint8_t tile_map_x, uint8_t tile_map_
         assert(false && "Invalid TileType");
     }
     auto tile_map_index = address_offset + tile_map_x + (tile_map_y * 32);
-    auto tile_index = m_tile_maps[tile_map_index];
-    return get_tile(tile_index);
+    return m_registers.get_tile_number(m_tile_maps[tile_map_index]);
 }
 
 void Ppu::write_scanline() {
-    if (!m_registers.is_ppu_enabled()) {
+    if (!m_registers.is_ppu_enabled() || m_emulator->is_frame_skipped()) {
         return;
     }
     draw_background_line();
     draw_window_line();
-    if (m_registers.get_sprite_height() == 8) {
-        draw_sprites_line();
-    } else {
-        draw_tall_sprites_line();
-    }
+    draw_sprites_line();
 }
 
 namespace {
@@ -315,23 +302,6 @@ bool bg_window_over_sprite(const OamEntry& oam_entry) {
     return bitmanip::is_bit_set(oam_entry.m_flags, 7);
 }
 
-size_t calculate_pixel_index(const OamEntry& oam_entry, size_t x, size_t y, size_t sprite_height) {
-    if (should_mirror_horizontally(oam_entry) && should_mirror_vertically(oam_entry)) {
-        const graphics::gb::TileIndexMirrorBothAxes tim(8, sprite_height);
-        return tim.pixel_index(x, y);
-    }
-    if (should_mirror_horizontally(oam_entry)) {
-        const graphics::gb::TileIndexMirrorHorizontal tih(8, sprite_height);
-        return tih.pixel_index(x, y);
-    }
-    if (should_mirror_vertically(oam_entry)) {
-        const graphics::gb::TileIndexMirrorVertical tiv(8, sprite_height);
-        return tiv.pixel_index(x, y);
-    }
-    const graphics::gb::TileIndex ti(8, sprite_height);
-    return ti.pixel_index(x, y);
-};
-
 } // namespace
 
 void Ppu::draw_sprites_line() {
@@ -341,139 +311,88 @@ void Ppu::draw_sprites_line() {
 
     const auto screen_y = m_registers.get_register_value(PpuRegisters::Register::LyRegister);
     auto visible_sprites = get_visible_sprites(screen_y);
+    const auto sprite_height = m_registers.get_sprite_height();
     const auto obj_palette_0 = m_registers.get_obj0_palette();
     const auto obj_palette_1 = m_registers.get_obj1_palette();
-    const auto debug = m_emulator->get_options().draw_debug_sprites;
+    auto line = m_game_framebuffer.row(screen_y);
+    std::span<graphics::gb::ColorGb> debug_line;
+    if (m_sprites_framebuffer && m_emulator->get_options().draw_debug_sprites) {
+        debug_line = m_sprites_framebuffer->row(screen_y);
+    }
 
     // When opaque pixels from two objects overlap, the pixels belonging to the higher priority
     // objects are displayed. The smaller the x coordinate, the higher the priority. For identical x
     // coordinates, the object located first in OAM has the higher priority.
-    // Initially visible_sprites is ordered by OAM order. Sort by x coordinate but use stable_sort
-    // to keep the relative order from OAM for the same x coordinates.
-    std::ranges::stable_sort(visible_sprites, [](const OamEntry& a, const OamEntry& b) {
-        return a.m_x_position < b.m_x_position;
+    auto objects = std::span{visible_sprites.indices}.first(visible_sprites.count);
+    std::ranges::sort(objects, [this](uint8_t a, uint8_t b) {
+        return std::pair{m_oam_ram[a].m_x_position, a} < std::pair{m_oam_ram[b].m_x_position, b};
     });
-    // Reverse order so the objects first in OAM stay (because they have higher priority).
-    for (const auto& oam_entry: std::ranges::reverse_view(visible_sprites)) {
+    // Pixels where a higher priority object already has an opaque pixel. This includes pixels
+    // where that object is hidden behind the background, lower priority objects aren't shown there
+    // either.
+    std::bitset<constants::SCREEN_RES_WIDTH> taken;
+    for (auto object_index: objects) {
+        const auto& oam_entry = m_oam_ram[object_index];
         // Skip offscreen sprites
-        if (oam_entry.m_y_position == 0 || oam_entry.m_y_position >= 160
-            || oam_entry.m_x_position == 0 || oam_entry.m_x_position >= 168) {
+        if (oam_entry.m_x_position >= 168) {
             continue;
         }
 
-        auto sprite_data = get_sprite_tile(oam_entry.m_tile_index);
-        auto tile = graphics::gb::tile_to_gb_color(sprite_data);
         auto palette_bit = bitmanip::is_bit_set(oam_entry.m_flags, 4);
         auto palette = palette_bit ? obj_palette_1 : obj_palette_0;
 
-        // Y position in sprite (0...15)
-        const auto sprite_y = screen_y - (oam_entry.m_y_position - 16);
+        // Y position in sprite (0...7 or 0...15)
+        const auto sprite_y = screen_y + 16 - oam_entry.m_y_position;
+        const auto tile_y
+            = should_mirror_vertically(oam_entry) ? sprite_height - 1 - sprite_y : sprite_y;
+        // For 8x16 objects bit 0 of the tile index is ignored. The upper tile has the index with
+        // bit 0 cleared, the lower one with bit 0 set.
+        const auto first_tile_index
+            = sprite_height == 16 ? oam_entry.m_tile_index & 0xFE : oam_entry.m_tile_index;
+        const auto tile_number = static_cast<size_t>(first_tile_index + (tile_y / 8));
+        const auto& tile_line = get_tile_line(tile_number, static_cast<size_t>(tile_y % 8),
+                                              should_mirror_horizontally(oam_entry));
         for (unsigned sprite_x = 0; sprite_x < 8; ++sprite_x) {
             auto x = static_cast<int>(oam_entry.m_x_position + sprite_x) - 8;
-            auto y = static_cast<int>(oam_entry.m_y_position + sprite_y) - 16;
-            if (x < 0 || y < 0 || x >= static_cast<int>(m_game_framebuffer.width())
-                || y >= static_cast<int>(m_game_framebuffer.height())) {
+            if (x < 0 || x >= static_cast<int>(line.size())) {
                 // This pixel of the sprite is hidden
                 continue;
             }
-            auto pixel_index
-                = calculate_pixel_index(oam_entry, sprite_x, static_cast<size_t>(sprite_y), 8);
-            auto pixel_color = tile[pixel_index];
-            if (pixel_color == graphics::gb::UnmappedColorGb::Color0) {
-                // Color 0 is transparent for sprites, so those pixels are not drawn.
+            auto pixel_color = tile_line[sprite_x];
+            // Color 0 is transparent for sprites, so those pixels are not drawn.
+            if (pixel_color == graphics::gb::UnmappedColorGb::Color0 || taken.test(x)) {
                 continue;
             }
-
-            auto gb_color = palette[magic_enum::enum_integer(pixel_color)];
-            auto screen_color = graphics::gb::to_screen_color(gb_color);
-            // TODO The existing color was already mapped by the background palette at this point.
-            // For this comparison the unmapped color should be used.
-            auto existing_color
-                = m_game_framebuffer.get_pixel(static_cast<size_t>(x), static_cast<size_t>(y));
+            taken.set(x);
             if (bg_window_over_sprite(oam_entry)
-                && existing_color != graphics::gb::ColorScreen::White) {
+                && m_background_line[x] != graphics::gb::UnmappedColorGb::Color0) {
                 continue;
             }
-            m_game_framebuffer.set_pixel(static_cast<size_t>(x), static_cast<size_t>(y),
-                                         screen_color);
-            if (debug) {
-                m_sprites_framebuffer.set_pixel(static_cast<size_t>(x), static_cast<size_t>(y),
-                                                screen_color);
+            auto gb_color = palette[magic_enum::enum_integer(pixel_color)];
+            line[x] = gb_color;
+            if (!debug_line.empty()) {
+                debug_line[x] = gb_color;
             }
         }
     }
 }
 
-void Ppu::draw_tall_sprites_line() {
-    if (!m_registers.is_sprites_enabled()) {
-        return;
+void Ppu::fetch_tile_row(TileType tile_type, unsigned tile_map_x, unsigned tile_map_y,
+                         unsigned tile_pixel_y, TileRow& out) {
+    for (size_t i = 0; i < TILES_PER_ROW; ++i) {
+        // Tile map coordinates wrap around at the right edge of the 32x32 tile map
+        auto tile_number = get_tile_number_from_map(tile_type, (tile_map_x + i) % 32, tile_map_y);
+        const auto& tile_line = get_tile_line(tile_number, tile_pixel_y);
+        std::ranges::copy(tile_line, out.begin() + (i * constants::PIXELS_PER_TILE));
     }
+}
 
-    const auto screen_y = m_registers.get_register_value(PpuRegisters::Register::LyRegister);
-    auto visible_sprites = get_visible_sprites(screen_y);
-    const auto obj_palette_0 = m_registers.get_obj0_palette();
-    const auto obj_palette_1 = m_registers.get_obj1_palette();
-    const auto debug = m_emulator->get_options().draw_debug_sprites;
-
-    // When opaque pixels from two objects overlap, the pixels belonging to the higher priority
-    // objects are displayed. The smaller the x coordinate, the higher the priority. For identical x
-    // coordinates, the object located first in OAM has the higher priority.
-    // Initially visible_sprites is ordered by OAM order. Sort by x coordinate but use stable_sort
-    // to keep the relative order from OAM for the same x coordinates.
-    std::ranges::stable_sort(visible_sprites, [](const OamEntry& a, const OamEntry& b) {
-        return a.m_x_position < b.m_x_position;
-    });
-    // Reverse order so the objects first in OAM stay (because they have higher priority).
-    for (auto oam_entry: std::ranges::reverse_view(visible_sprites)) {
-        // Skip sprites which are completly offscreen
-        if (oam_entry.m_y_position == 0 || oam_entry.m_y_position >= 160
-            || oam_entry.m_x_position == 0 || oam_entry.m_x_position >= 168) {
-            continue;
-        }
-
-        auto tile_index = oam_entry.m_tile_index & 0xFE;
-        auto sprite_data = get_tall_sprite_tile(tile_index);
-        // TODO Only convert the required line from the tile (accounting for x-flip/y-flip).
-        auto tile = graphics::gb::tile_to_gb_color(sprite_data);
-        auto palette_bit = bitmanip::is_bit_set(oam_entry.m_flags, 4);
-        auto palette = palette_bit ? obj_palette_1 : obj_palette_0;
-
-        // Y position in sprite (0...15)
-        const auto sprite_y = screen_y - (oam_entry.m_y_position - 16);
-        for (unsigned sprite_x = 0; sprite_x < 8; ++sprite_x) {
-            auto x = static_cast<int>(oam_entry.m_x_position + sprite_x) - 8;
-            auto y = static_cast<int>(oam_entry.m_y_position + sprite_y) - 16;
-            if (x < 0 || y < 0 || x >= static_cast<int>(m_game_framebuffer.width())
-                || y >= static_cast<int>(m_game_framebuffer.height())) {
-                // This pixel of the sprite is hidden
-                continue;
-            }
-            auto pixel_index
-                = calculate_pixel_index(oam_entry, sprite_x, static_cast<size_t>(sprite_y), 16);
-            auto pixel_color = tile[pixel_index];
-            if (pixel_color == graphics::gb::UnmappedColorGb::Color0) {
-                // Color 0 is transparent for sprites, so those pixels are not drawn.
-                continue;
-            }
-
-            auto gb_color = palette[magic_enum::enum_integer(pixel_color)];
-            auto screen_color = graphics::gb::to_screen_color(gb_color);
-            // TODO The existing color was already mapped by the background palette at this point.
-            // For this comparison the unmapped color should be used.
-            auto existing_color
-                = m_game_framebuffer.get_pixel(static_cast<size_t>(x), static_cast<size_t>(y));
-            if (bg_window_over_sprite(oam_entry)
-                && existing_color != graphics::gb::ColorScreen::White) {
-                continue;
-            }
-            m_game_framebuffer.set_pixel(static_cast<size_t>(x), static_cast<size_t>(y),
-                                         screen_color);
-            if (debug) {
-                m_sprites_framebuffer.set_pixel(static_cast<size_t>(x), static_cast<size_t>(y),
-                                                screen_color);
-            }
-        }
+const TileCache::TileLine& Ppu::get_tile_line(size_t tile_number, size_t y, bool mirrored) {
+    if (m_use_tile_cache) {
+        return m_tile_cache.get_line(tile_number, y, mirrored);
     }
+    m_decoded_tile_line = TileCache::decode_line(m_tile_data, tile_number, y, mirrored);
+    return m_decoded_tile_line;
 }
 
 void Ppu::draw_window_line() {
@@ -484,16 +403,6 @@ void Ppu::draw_window_line() {
 
     const auto screen_y = m_registers.get_register_value(PpuRegisters::Register::LyRegister);
     auto palette = m_registers.get_background_window_palette();
-
-    if (!m_registers.background_window_enabled()) {
-        // Window disabled for this line, draw color0 from BGP
-        for (unsigned screen_x = 0; screen_x < constants::SCREEN_RES_WIDTH; ++screen_x) {
-            m_game_framebuffer.set_pixel(screen_x, screen_y,
-                                         graphics::gb::to_screen_color(palette[0]));
-        }
-        return;
-    }
-
     const auto wx = m_registers.get_register_value(PpuRegisters::Register::WxRegister);
     const auto wy = m_registers.get_register_value(PpuRegisters::Register::WyRegister);
 
@@ -504,29 +413,18 @@ void Ppu::draw_window_line() {
         return;
     }
 
-    for (unsigned screen_x = 0; screen_x < static_cast<int>(constants::SCREEN_RES_WIDTH);
-         ++screen_x) {
-        // WX stores the window x coordinate plus 7. Don't draw anything if we are left of the
-        // window.
-        if (screen_x + 7 < static_cast<unsigned>(wx)) {
-            continue;
-        }
-        // X position within the window, e.g. at the left side of the window this will be 0.
-        auto in_window_x = screen_x + 7 - wx;
-        // Index of tile in map
-        auto tile_map_x = in_window_x / constants::PIXELS_PER_TILE;
-        auto tile_map_y = m_window_internal_line_counter / constants::PIXELS_PER_TILE;
-        auto tile = get_tile_from_map(TileType::Window, tile_map_x, tile_map_y);
-        // Index of the pixel in the tile
-        auto tile_pixel_x = in_window_x % constants::PIXELS_PER_TILE;
-        auto tile_pixel_y = m_window_internal_line_counter % constants::PIXELS_PER_TILE;
-        auto tile_line
-            = graphics::gb::convert_tile_line(tile[tile_pixel_y * 2], tile[(tile_pixel_y * 2) + 1]);
-        auto color_index = tile_line[tile_pixel_x];
-        auto color = palette[static_cast<size_t>(color_index)];
-        auto screencolor = graphics::gb::to_screen_color(color);
-        m_game_framebuffer.set_pixel(screen_x, screen_y, screencolor);
-    }
+    // WX stores the window x coordinate plus 7. For WX < 7 the left part of the window is cut off
+    // by the screen edge.
+    const unsigned window_screen_x = wx < 7 ? 0 : wx - 7;
+    const unsigned skipped_pixels = wx < 7 ? 7 - wx : 0;
+    TileRow tile_row{};
+    fetch_tile_row(TileType::Window, 0, m_window_internal_line_counter / constants::PIXELS_PER_TILE,
+                   m_window_internal_line_counter % constants::PIXELS_PER_TILE, tile_row);
+    auto window_line = std::span{m_background_line}.subspan(window_screen_x);
+    std::ranges::copy(std::span{tile_row}.subspan(skipped_pixels, window_line.size()),
+                      window_line.begin());
+    graphics::gb::apply_palette(window_line,
+                                m_game_framebuffer.row(screen_y).subspan(window_screen_x), palette);
 
     // Increment internal window line counter on lines where the window is visible
     m_window_internal_line_counter++;
@@ -535,154 +433,72 @@ void Ppu::draw_window_line() {
 void Ppu::draw_background_line() {
     unsigned const screen_y = m_registers.get_register_value(PpuRegisters::Register::LyRegister);
     auto palette = m_registers.get_background_window_palette();
+    auto line = m_game_framebuffer.row(screen_y);
 
     if (!m_registers.background_window_enabled()) {
         // Background disabled for this line, draw color0 from BGP
-        for (unsigned screen_x = 0; screen_x < constants::SCREEN_RES_WIDTH; ++screen_x) {
-            m_game_framebuffer.set_pixel(screen_x, screen_y,
-                                         graphics::gb::to_screen_color(palette[0]));
-        }
+        std::ranges::fill(m_background_line, graphics::gb::UnmappedColorGb::Color0);
+        std::ranges::fill(line, palette[0]);
         return;
     }
 
     auto scx = m_registers.get_register_value(PpuRegisters::Register::ScxRegister);
     auto scy = m_registers.get_register_value(PpuRegisters::Register::ScyRegister);
-
-    for (unsigned screen_x = 0; screen_x < constants::SCREEN_RES_WIDTH; ++screen_x) {
-        // Index of pixel in full background map
-        auto bg_x = (screen_x + scx) % constants::BACKGROUND_SIZE_PIXELS;
-        auto bg_y = (screen_y + scy) % constants::BACKGROUND_SIZE_PIXELS;
-        // Index of tile in tile map
-        auto tile_index_x = bg_x / constants::PIXELS_PER_TILE;
-        auto tile_index_y = bg_y / constants::PIXELS_PER_TILE;
-        // Index of the pixel in the tile
-        auto tile_pixel_x = bg_x % constants::PIXELS_PER_TILE;
-        auto tile_pixel_y = bg_y % constants::PIXELS_PER_TILE;
-
-        auto tile = get_tile_from_map(TileType::Background, tile_index_x, tile_index_y);
-        // The tile provides an 8 pixel line from 2 bytes
-        auto tile_line
-            = graphics::gb::convert_tile_line(tile[tile_pixel_y * 2], tile[(tile_pixel_y * 2) + 1]);
-        auto color_index = tile_line[tile_pixel_x];
-        auto color_gb = palette[magic_enum::enum_integer(color_index)];
-        auto screen_color = graphics::gb::to_screen_color(color_gb);
-        m_game_framebuffer.set_pixel(screen_x, screen_y, screen_color);
-    }
-}
-
-std::span<uint8_t, constants::BYTES_PER_TILE> Ppu::get_sprite_tile(uint8_t tile_index) {
-    return std::span<uint8_t, constants::BYTES_PER_TILE>{
-        m_tile_data.begin() + (tile_index * constants::BYTES_PER_TILE), constants::BYTES_PER_TILE};
+    auto bg_y = (screen_y + scy) % constants::BACKGROUND_SIZE_PIXELS;
+
+    // Decode the 21 tiles touched by this line once. When SCX is not a multiple of 8, the first
+    // tile is only partially visible, which is handled by skipping its first pixels. The 21st tile
+    // provides the pixels cut off at the start of the first one.
+    TileRow tile_row{};
+    fetch_tile_row(TileType::Background, scx / constants::PIXELS_PER_TILE,
+                   bg_y / constants::PIXELS_PER_TILE, bg_y % constants::PIXELS_PER_TILE, tile_row);
+    const auto fine_scroll_x = scx % constants::PIXELS_PER_TILE;
+    std::ranges::copy(std::span{tile_row}.subspan(fine_scroll_x, m_background_line.size()),
+                      m_background_line.begin());
+    graphics::gb::apply_palette(m_background_line, line, palette);
 }
 
-std::span<uint8_t, constants::BYTES_PER_TILE * 2> Ppu::get_tall_sprite_tile(uint8_t tile_index) {
-    return std::span<uint8_t, constants::BYTES_PER_TILE * 2>{
-        m_tile_data.begin() + (tile_index * constants::BYTES_PER_TILE),
-        constants::BYTES_PER_TILE * 2};
-};
-
-void Ppu::draw_background_debug() {
-    auto palette = m_registers.get_background_window_palette();
-    for (unsigned screen_y = 0; screen_y < constants::BACKGROUND_SIZE_PIXELS; ++screen_y) {
-        // Tile index
-        unsigned const tile_y = screen_y / 8;
-        // Pixel offset in tile
-        auto in_tile_y = screen_y % 8;
-        // First update the line in the complete background framebuffer
-        for (unsigned tile_x = 0; tile_x < 32; ++tile_x) {
-            // Get tile by reading index from tile map and fetching indexed tile from tile data.
-            auto tile = get_tile_from_map(TileType::Background, tile_x, tile_y);
-            // The tile provides an 8 pixel line from 2 bytes
-            auto tile_line
-                = graphics::gb::convert_tile_line(tile[in_tile_y * 2], tile[(in_tile_y * 2) + 1]);
-            // Map the colors using the current palette and transfer this tiles line to the buffer
-            for (unsigned tile_line_x = 0; tile_line_x < 8; tile_line_x++) {
-                auto pixel = palette[magic_enum::enum_integer(tile_line[tile_line_x])];
-                auto screen_x = (tile_x * 8) + tile_line_x;
-                m_background_framebuffer.set_pixel(screen_x, screen_y,
-                                                   graphics::gb::to_screen_color(pixel));
-            }
-        }
-    }
-    auto scx = m_registers.get_register_value(PpuRegisters::Register::ScxRegister);
-    auto scy = m_registers.get_register_value(PpuRegisters::Register::ScyRegister);
-
-    draw_rectangle_border(m_background_framebuffer, scx, scy, constants::SCREEN_RES_WIDTH,
-                          constants::SCREEN_RES_HEIGHT, graphics::gb::ColorScreen::Highlight);
-}
-
-void Ppu::draw_window_debug() {
-    auto palette = m_registers.get_background_window_palette();
-
-    for (unsigned screen_y = 0; screen_y < constants::BACKGROUND_SIZE_PIXELS; ++screen_y) {
-        auto tile_y = screen_y / constants::PIXELS_PER_TILE;
-        for (unsigned tile_x = 0; tile_x < 32; ++tile_x) {
-            // Get tile by reading index from tile map and fetching indexed tile from tile data.
-            auto tile = get_tile_from_map(TileType::Window, tile_x, tile_y);
-            size_t const in_tile_y = screen_y % 8;
-            // The tile provides an 8 pixel line from 2 bytes
-            auto tile_line
-                = graphics::gb::convert_tile_line(tile[in_tile_y * 2], tile[(in_tile_y * 2) + 1]);
-            // Map the colors using the current palette and transfer this tiles line to the buffer
-            for (unsigned tile_line_x = 0; tile_line_x < 8; tile_line_x++) {
-                auto pixel = palette[magic_enum::enum_integer(tile_line[tile_line_x])];
-                auto screen_x = (tile_x * 8) + tile_line_x;
-                m_window_framebuffer.set_pixel(screen_x, screen_y,
-                                               graphics::gb::to_screen_color(pixel));
-            }
-        }
+void Ppu::reset_sprites_framebuffer() {
+    if (!m_emulator->get_options().draw_debug_sprites) {
+        m_sprites_framebuffer.reset();
+    } else if (!m_sprites_framebuffer) {
+        m_sprites_framebuffer
+            = std::make_unique<SpritesFramebuffer>(graphics::gb::ColorGb::DebugBackground);
+    } else {
+        m_sprites_framebuffer->reset(graphics::gb::ColorGb::DebugBackground);
     }
-
-    auto wx = m_registers.get_register_value(PpuRegisters::Register::WxRegister) - 7;
-    auto wy = m_registers.get_register_value(PpuRegisters::Register::WyRegister);
-    draw_rectangle_border(m_window_framebuffer, wx, wy, constants::SCREEN_RES_WIDTH,
-                          constants::SCREEN_RES_HEIGHT, graphics::gb::ColorScreen::Highlight);
 }
 
-
-void Ppu::draw_vram_debug() {
-    // Iterate over the three tile data blocks
-    std::array<Framebuffer<graphics::gb::ColorScreen,
-                           constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
-                           constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>*,
-               3>
-        buffers{&m_tiledata_block0, &m_tiledata_block1, &m_tiledata_block2};
-    for (unsigned block = 0; block < 3; ++block) {
-        for (unsigned tile_x = 0; tile_x < 16; ++tile_x) {
-            for (unsigned tile_y = 0; tile_y < 8; ++tile_y) {
-                auto tile_index = tile_x + (tile_y * 16);
-                auto tile = get_tile(block, tile_index);
-                auto tile_color = graphics::gb::tile_to_gb_color(tile);
-                // Transfer the tile to the framebuffer.
-                // The framebuffer is 16x8 tiles or 128x64 pixels
-                for (unsigned in_tile_x = 0; in_tile_x < 8; ++in_tile_x) {
-                    for (unsigned in_tile_y = 0; in_tile_y < 8; ++in_tile_y) {
-                        auto in_tile_index = (in_tile_y * 8) + in_tile_x;
-                        auto color = tile_color[in_tile_index];
-                        auto x = (tile_x * 8) + in_tile_x;
-                        auto y = (tile_y * 8) + in_tile_y;
-                        auto screen_color = graphics::gb::to_screen_color(
-                            static_cast<graphics::gb::ColorGb>(color));
-                        buffers[block]->set_pixel(x, y, screen_color);
-                    }
-                }
-            }
-        }
-    }
+size_t Ppu::get_memory_usage() const {
+    return sizeof(Ppu) + (m_sprites_framebuffer ? sizeof(SpritesFramebuffer) : 0)
+           + m_debug_views.get_allocated_memory();
 }
 
-std::array<const Framebuffer<graphics::gb::ColorScreen,
-                             constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
-                             constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>*,
-           3>
-Ppu::get_tiledata() {
-    return {&m_tiledata_block0, &m_tiledata_block1, &m_tiledata_block2};
+void Ppu::save_state(StateWriter& writer) const {
+    writer.write(m_tile_data);
+    writer.write(m_tile_maps);
+    writer.write(m_oam_ram);
+    m_registers.save_state(writer);
+    writer.write(m_clock_count);
+    writer.write_span(m_game_framebuffer.pixels());
+    m_oam_dma_transfer.save_state(writer);
+    writer.write(m_stat_interrupt_line);
+    writer.write(m_window_internal_line_counter);
 }
 
-std::span<uint8_t, 16> Ppu::get_tile(unsigned int block, unsigned int index_in_block) {
-    auto start = (index_in_block * 16) + (block * 128 * 16);
-    auto end = start + 16;
-    return std::span<uint8_t, 16>{m_tile_data.data() + start, m_tile_data.data() + end};
+void Ppu::load_state(StateReader& reader) {
+    reader.read(m_tile_data);
+    reader.read(m_tile_maps);
+    reader.read(m_oam_ram);
+    m_registers.load_state(reader);
+    reader.read(m_clock_count);
+    reader.read_span(m_game_framebuffer.pixels());
+    m_oam_dma_transfer.load_state(reader);
+    reader.read(m_stat_interrupt_line);
+    reader.read(m_window_internal_line_counter);
+    // Both caches are derived from the loaded VRAM and OAM.
+    m_tile_cache.invalidate_all();
+    m_objects_on_line_dirty = true;
 }
 
 void Ppu::start_oam_dma_transfer() {
@@ -693,16 +509,44 @@ void Ppu::start_oam_dma_transfer() {
     m_logger->debug("OAM DMA transfer from {:04X}", start_address);
 }
 
-std::vector<OamEntry> Ppu::get_visible_sprites(uint8_t screen_y) const {
-    std::vector<OamEntry> out;
-    for (const auto& oam_entry : m_oam_ram) {
-        if (oam_entry.m_x_position != 0 && screen_y + 16 >= oam_entry.m_y_position
-            && screen_y + 16 < oam_entry.m_y_position + m_registers.get_sprite_height()) {
-            out.push_back(oam_entry);
-        }
-        if (out.size() == 10) {
-            break;
+Ppu::LineObjects Ppu::get_visible_sprites(uint8_t screen_y) {
+    if (m_objects_on_line_dirty) {
+        rebuild_objects_on_line();
+    }
+    LineObjects out;
+    const auto sprite_height = m_registers.get_sprite_height();
+    // Iterate over the objects covering this line in OAM order
+    for (auto candidates = m_objects_on_line[screen_y];
+         candidates != 0 && out.count < LineObjects::MAX_OBJECTS; candidates &= candidates - 1) {
+        const auto object_index = static_cast<uint8_t>(std::countr_zero(candidates));
+        const auto& oam_entry = m_oam_ram[object_index];
+        if (oam_entry.m_x_position != 0
+            && screen_y + 16 < oam_entry.m_y_position + sprite_height) {
+            out.indices[out.count++] = object_index;
         }
     }
     return out;
 }
+
+void Ppu::update_objects_on_line(size_t object_index, uint8_t y_position, bool visible) {
+    // The y position is the screen y coordinate plus 16, so a 16 pixel tall object covers the
+    // lines y_position - 16 ... y_position - 1.
+    const auto first_line = std::max(0, y_position - 16);
+    const auto end_line = std::min(static_cast<int>(m_objects_on_line.size()), int{y_position});
+    const auto object_bit = uint64_t{1} << object_index;
+    for (auto line = first_line; line < end_line; ++line) {
+        if (visible) {
+            m_objects_on_line[line] |= object_bit;
+        } else {
+            m_objects_on_line[line] &= ~object_bit;
+        }
+    }
+}
+
+void Ppu::rebuild_objects_on_line() {
+    std::ranges::fill(m_objects_on_line, 0);
+    for (size_t i = 0; i < m_oam_ram.size(); ++i) {
+        update_objects_on_line(i, m_oam_ram[i].m_y_position, true);
+    }
+    m_objects_on_line_dirty = false;
+}
@@ -5,12 +5,15 @@
 #include "constants.h"
 #include "framebuffer.hpp"
 #include "dmatransfer.hpp"
+#include "tilecache.hpp"
+#include "debugviews.hpp"
 class Emulator;
+class StateWriter;
+class StateReader;
 #include "spdlog/fwd.h"
 #include <array>
 #include <span>
 #include <memory>
-#include <vector>
 
 struct OamEntry {
     uint8_t m_y_position;
@@ -24,6 +27,11 @@ static_assert(alignof(OamEntry) == 1, "Invalid alignment of OamEntry detected");
 class Ppu {
     // 0x8000-0x97FFF
     std::array<uint8_t, memmap::TileDataSize> m_tile_data{};
+    // Decoded tiles from m_tile_data, shared by the renderer and the debug views.
+    TileCache m_tile_cache;
+    // Otherwise tile lines are decoded from the tile data whenever they are drawn
+    bool m_use_tile_cache;
+    TileCache::TileLine m_decoded_tile_line{};
     // 0x9800-0x9FFF
     std::array<uint8_t, memmap::TileMapsSize> m_tile_maps{};
     // 0xFE00-0xFE9F
@@ -33,56 +41,53 @@ class Ppu {
     std::shared_ptr<spdlog::logger> m_logger;
     Emulator* m_emulator;
     int m_clock_count = 0;
-    // Framebuffer for the game
-    Framebuffer<graphics::gb::ColorScreen, constants::SCREEN_RES_WIDTH,
+    // Framebuffer for the game. All framebuffers store one game boy color per pixel, which is
+    // mapped to a screen color when displaying them.
+    Framebuffer<graphics::gb::ColorGb, constants::SCREEN_RES_WIDTH,
                 constants::SCREEN_RES_HEIGHT>
         m_game_framebuffer;
-    // Framebuffers for debug elements
-    Framebuffer<graphics::gb::ColorScreen, constants::BACKGROUND_SIZE_PIXELS,
-                constants::BACKGROUND_SIZE_PIXELS>
-        m_background_framebuffer;
-    Framebuffer<graphics::gb::ColorScreen, constants::SCREEN_RES_WIDTH,
-                constants::SCREEN_RES_HEIGHT>
-        m_sprites_framebuffer;
-    Framebuffer<graphics::gb::ColorScreen, constants::BACKGROUND_SIZE_PIXELS,
-                constants::BACKGROUND_SIZE_PIXELS>
-        m_window_framebuffer;
-    Framebuffer<graphics::gb::ColorScreen,
-                constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
-                constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>
-        m_tiledata_block0;
-    Framebuffer<graphics::gb::ColorScreen,
-                constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
-                constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>
-        m_tiledata_block1;
-    Framebuffer<graphics::gb::ColorScreen,
-                constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
-                constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>
-        m_tiledata_block2;
+    using SpritesFramebuffer = Framebuffer<graphics::gb::ColorGb, constants::SCREEN_RES_WIDTH,
+                                           constants::SCREEN_RES_HEIGHT>;
+    // Framebuffer for the sprites debug view, drawn together with the game. Only allocated while
+    // the view is enabled.
+    std::unique_ptr<SpritesFramebuffer> m_sprites_framebuffer;
+    // Background, window and tile data debug views, rendered from VRAM snapshots
+    DebugViews m_debug_views;
     OamDmaTransfer m_oam_dma_transfer;
     uint8_t m_stat_interrupt_line = 0;
     uint8_t m_window_internal_line_counter = 0;
+    // Unmapped background/window colors of the current line. Objects with the BG priority flag are
+    // hidden behind colors 1-3, which has to be checked before the BG palette is applied.
+    std::array<graphics::gb::UnmappedColorGb, constants::SCREEN_RES_WIDTH> m_background_line{};
+    // For every screen line, bit n is set if object n of OAM covers this line when it is 16 pixels
+    // tall. Objects which are 8 pixels tall are filtered when selecting the objects of a line.
+    // Kept up to date from OAM writes, after an OAM DMA transfer it is rebuilt completely.
+    std::array<uint64_t, constants::SCREEN_RES_HEIGHT> m_objects_on_line{};
+    bool m_objects_on_line_dirty = true;
 
     void write_scanline();
     void draw_window_line();
     void draw_background_line();
     void draw_sprites_line();
-    void draw_tall_sprites_line();
-    void draw_background_debug();
-    void draw_window_debug();
-    void draw_vram_debug();
-
-    std::span<uint8_t, constants::BYTES_PER_TILE> get_sprite_tile(uint8_t tile_index);
-    std::span<uint8_t, constants::BYTES_PER_TILE * 2> get_tall_sprite_tile(uint8_t tile_index);
-
-    std::span<uint8_t, 16> get_tile(unsigned block, unsigned index_in_block);
+    // Clear the sprites debug view for the next frame, or allocate/release it when the view was
+    // enabled/disabled.
+    void reset_sprites_framebuffer();
 
     enum class TileType: uint8_t { Background, Window };
-    // Get one background or window tile from vram using the tile index.
-    std::span<uint8_t, constants::BYTES_PER_TILE> get_tile(uint8_t tile_index);
-    // Get one background or window tile from vram using tile coordinates (of 32x32)
-    std::span<uint8_t, constants::BYTES_PER_TILE>
-    get_tile_from_map(TileType tile_type, uint8_t tile_map_x, uint8_t tile_map_y);
+    // A line of the screen can touch up to 21 tiles when it is not aligned to the tile grid.
+    static constexpr size_t TILES_PER_ROW
+        = (constants::SCREEN_RES_WIDTH / constants::PIXELS_PER_TILE) + 1;
+    using TileRow
+        = std::array<graphics::gb::UnmappedColorGb, TILES_PER_ROW * constants::PIXELS_PER_TILE>;
+    // Decode one pixel row of TILES_PER_ROW consecutive tiles of a tile map, starting at the given
+    // tile map coordinates.
+    void fetch_tile_row(TileType tile_type, unsigned tile_map_x, unsigned tile_map_y,
+                        unsigned tile_pixel_y, TileRow& out);
+    // Get a decoded line of a tile, which stays valid until the next call.
+    const TileCache::TileLine& get_tile_line(size_t tile_number, size_t y, bool mirrored = false);
+    // Get the number of a background or window tile using tile coordinates (of 32x32)
+    [[nodiscard]] size_t get_tile_number_from_map(TileType tile_type, unsigned tile_map_x,
+                                                  unsigned tile_map_y) const;
 
     void set_stat_interrupt_line_bit(PpuRegisters::StatInterruptSource position, uint8_t value);
 
@@ -93,8 +98,17 @@ class Ppu {
     void do_mode0_hblank();
     void do_mode1_vblank();
 
-    // Get up to 10 sprites visible in this line
-    [[nodiscard]] std::vector<OamEntry> get_visible_sprites(uint8_t screen_y) const;
+    // Objects selected for one line, as indices into OAM
+    struct LineObjects {
+        static constexpr size_t MAX_OBJECTS = 10;
+        std::array<uint8_t, MAX_OBJECTS> indices{};
+        size_t count = 0;
+    };
+    // Get up to 10 sprites visible in this line, ordered by OAM index
+    [[nodiscard]] LineObjects get_visible_sprites(uint8_t screen_y);
+    // Set or clear the bit of an object in m_objects_on_line for all lines covered by it
+    void update_objects_on_line(size_t object_index, uint8_t y_position, bool visible);
+    void rebuild_objects_on_line();
 
 public:
     explicit Ppu(Emulator* emulator);
@@ -108,18 +122,17 @@ public:
     const auto& get_game() {
         return m_game_framebuffer;
     }
-    const auto& get_background() {
-        return m_background_framebuffer;
+    // Returns nullptr while the sprites debug view is disabled
+    [[nodiscard]] const SpritesFramebuffer* get_sprites() const {
+        return m_sprites_framebuffer.get();
     }
-    const auto& get_sprites() {
-        return m_sprites_framebuffer;
+    DebugViews& get_debug_views() {
+        return m_debug_views;
     }
-    const auto& get_window() {
-        return m_window_framebuffer;
-    }
-    std::array<const Framebuffer<graphics::gb::ColorScreen,
-                                 constants::SPRITE_VIEWER_WIDTH * constants::PIXELS_PER_TILE,
-                                 constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>*,
-               3>
-    get_tiledata();
+    // Size of the PPU including allocated framebuffers in bytes
+    [[nodiscard]] size_t get_memory_usage() const;
+
+    // Debug views are not part of the state, they are rendered again from the loaded VRAM.
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 };
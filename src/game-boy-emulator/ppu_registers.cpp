@@ -1,6 +1,8 @@
 #include "ppu_registers.hpp"
 #include "bitmanipulation.hpp"
 #include "graphics.hpp"
+#include "savestate.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <array>
 
@@ -162,3 +164,29 @@ bool PpuRegisters::is_sprites_enabled() const {
     auto lcdc = get(Register::LcdcRegister);
     return bitmanip::is_bit_set(lcdc, static_cast<uint8_t>(LcdcBits::ObjEnable));
 }
+
+size_t PpuRegisters::get_tile_number(uint8_t tile_index) const {
+    // Unsigned when bit 4 is set
+    if (get_bg_win_address_mode() == BgWinAddressMode::Unsigned) {
+        // In unsigned indexing, the sprites are in order in memory, starting at 0x8000
+        return tile_index;
+    }
+    // In signed indexing, the first 0-127 tiles are from 0x9000-0x97FF (last block of the tile
+    // data portion of the vram). The tiles 128-255 are in the second block from 0x8800-0x8FFF.
+    if (static_cast<int8_t>(tile_index) >= 0) {
+        // Skip the first 256 sprites (block 0 and 1) and index into block 2.
+        return 256 + size_t{tile_index};
+    }
+    // Tiles 128-255 lie within block 1. We can use the index from 0;
+    return tile_index;
+}
+
+void PpuRegisters::save_state(StateWriter& writer) const {
+    writer.write(m_registers);
+    writer.write(m_oam_transfer_requested);
+}
+
+void PpuRegisters::load_state(StateReader& reader) {
+    reader.read(m_registers);
+    reader.read(m_oam_transfer_requested);
+}
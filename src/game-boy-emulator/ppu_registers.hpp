@@ -2,8 +2,11 @@
 
 #include "memorymap.hpp"
 #include "graphics.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <array>
+class StateWriter;
+class StateReader;
 
 enum class PpuMode: uint8_t {
     HBlank_0 = 0,
@@ -90,6 +93,9 @@ public:
     [[nodiscard]] uint8_t get_sprite_height() const;
     // Get bit 4 in LCDC register
     [[nodiscard]] BgWinAddressMode get_bg_win_address_mode() const;
+    // Get the number (0..383) of a background or window tile in the tile data from the tile index
+    // stored in the tile map. Depends on the addressing mode set by bit 4 in LCDC register.
+    [[nodiscard]] size_t get_tile_number(uint8_t tile_index) const;
     // Get bit 3 in LCDC register
     [[nodiscard]] TileMapAddressRange get_background_address_range() const;
     // Get bit 6 in LCDC register
@@ -113,6 +119,10 @@ public:
     void set_register_bit(PpuRegisters::Register r, uint8_t bit_position, uint8_t bit_value);
     void increment_register(PpuRegisters::Register r);
 
+    // The fixed LY value is an option and not part of the state.
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
+
 private:
     uint8_t& get(PpuRegisters::Register r);
     [[nodiscard]] const uint8_t& get(PpuRegisters::Register r) const;
@@ -1,8 +1,10 @@
 #include "pulsechannel.hpp"
 #include "audiochannel.hpp"
 #include "bitmanipulation.hpp"
+#include "savestate.hpp"
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cassert>
 #include <cstdint>
 
@@ -14,8 +16,9 @@ const std::array<std::array<int, 8>, 4> WAVE_DUTY_CYCLES{
 
 void PulseChannel::trigger() {
     // Triggering for volume envelope
-    m_volume_sweep_counter = get_volume_sweep_pace();
-    m_current_volume = get_volume();
+    trigger_envelope();
+    // Triggering reloads the wavelength timer, but keeps the position in the waveform
+    restart_period();
     // Triggering for frequency sweep
     m_shadow_frequency = get_current_wavelength();
     m_freq_sweep_timer = get_wavelength_sweep_pace();
@@ -37,7 +40,7 @@ void PulseChannel::trigger() {
 
 uint8_t PulseChannel::get_sample() {
     const auto& wave_duty = WAVE_DUTY_CYCLES[get_wave_duty()];
-    return wave_duty[m_waveform_index] * m_current_volume;
+    return wave_duty[m_waveform_index] * get_current_volume();
 }
 
 unsigned PulseChannel::calculate_frequency() const {
@@ -80,31 +83,6 @@ void PulseChannel::do_frequency_sweep() {
     }
 }
 
-void PulseChannel::do_envelope_sweep() {
-    auto envelope_sweep_pace = get_volume_sweep_pace();
-    if (envelope_sweep_pace == 0) {
-        return;
-    }
-    if (m_volume_sweep_counter > 0) {
-        m_volume_sweep_counter--;
-    }
-    if (m_volume_sweep_counter == 0) {
-        m_volume_sweep_counter = get_volume_sweep_pace();
-        // Actually do the sweep every pace ticks of the envelope
-        if (bitmanip::is_bit_set(read_nrx2(), 3)) {
-            // Increase volume envelope
-            if (m_current_volume < 14) {
-                m_current_volume++;
-            }
-        } else {
-            // Decrease volume envelope
-            if (m_current_volume > 0) {
-                m_current_volume--;
-            }
-        }
-    }
-}
-
 void PulseChannel::do_sound_length() {
     if (!is_length_enabled()) {
         return;
@@ -169,23 +147,34 @@ void PulseChannel::set_length_timer(uint8_t length_timer) {
     set_nrx1(new_value);
 }
 
-void PulseChannel::tick_wave() {
-    m_cycle_count++;
-    if (m_cycle_count + get_current_wavelength() > 2048) {
-        m_cycle_count = 0;
-        m_waveform_index++;
-        m_waveform_index %= 8;
-    }
-}
-
-uint8_t PulseChannel::get_volume() const {
-    return (read_nrx2() & 0b11110000) >> 4;
+size_t PulseChannel::get_period() const {
+    // The square wave advances one of its 8 steps at 1 MHz / (2048 - wavelength), meaning every
+    // 4 * (2048 - wavelength) T cycles.
+    return 4 * (2048 - static_cast<size_t>(get_current_wavelength()));
 }
 
-uint8_t PulseChannel::get_volume_sweep_pace() const {
-    return read_nrx2() & 0b111;
+void PulseChannel::advance_waveform(size_t steps) {
+    m_waveform_index = static_cast<uint8_t>((m_waveform_index + steps) % 8);
 }
 
 bool PulseChannel::is_length_enabled() const {
     return bitmanip::is_bit_set(read_nrx4(), 6);
 }
+
+void PulseChannel::save_state(StateWriter& writer) const {
+    AudioChannel::save_state(writer);
+    writer.write(m_dac_enabled);
+    writer.write(m_freq_sweep_timer);
+    writer.write(m_sweep_enabled);
+    writer.write(m_shadow_frequency);
+    writer.write(m_waveform_index);
+}
+
+void PulseChannel::load_state(StateReader& reader) {
+    AudioChannel::load_state(reader);
+    reader.read(m_dac_enabled);
+    reader.read(m_freq_sweep_timer);
+    reader.read(m_sweep_enabled);
+    reader.read(m_shadow_frequency);
+    reader.read(m_waveform_index);
+}
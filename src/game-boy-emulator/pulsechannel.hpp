@@ -1,7 +1,6 @@
 #pragma once
 
 #include "audiochannel.hpp"
-#include "clocktimer.hpp"
 #include <cstddef>
 
 /*
@@ -47,28 +46,20 @@ class PulseChannel : public AudioChannel {
 
     // Index into the 8 step square waveform
     uint8_t m_waveform_index = 0;
-    size_t m_cycle_count = 0;
-
+    // Number of T cycles between two steps in the square waveform
+    [[nodiscard]] size_t get_period() const override;
+    void advance_waveform(size_t steps) override;
 
     void trigger();
 
-    /*
-     * Volume sweep
-     */
-    // Bits 4..7 if NR12
-    [[nodiscard]] uint8_t get_volume() const;
-    // Bits 0..2 fo NR12
-    [[nodiscard]] uint8_t get_volume_sweep_pace() const;
-    uint8_t m_volume_sweep_counter = 0;
-    uint8_t m_current_volume = 0;
-
 public:
-    void tick_wave();
     uint8_t get_sample() override;
 
     void do_frequency_sweep();
-    void do_envelope_sweep();
     void do_sound_length();
 
     void set_nrx4(uint8_t value) override;
+
+    void save_state(StateWriter& writer) const override;
+    void load_state(StateReader& reader) override;
 };
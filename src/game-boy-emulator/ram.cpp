@@ -5,9 +5,10 @@
 #include <cstdint>
 #include <fmt/format.h>
 #include "memorymap.hpp"
+#include "savestate.hpp"
 #include "spdlog/spdlog.h"
 
-Ram::Ram(Emulator* emulator) : m_emulator(emulator), m_logger(spdlog::get("")) {}
+Ram::Ram(Emulator* emulator) : m_emulator(emulator), m_logger(emulator->get_logger()) {}
 
 uint8_t Ram::read_byte(uint16_t address) const {
     if (memmap::is_in(address, memmap::InternalRam)) {
@@ -33,3 +34,13 @@ void Ram::write_byte(uint16_t address, uint8_t value) {
             fmt::format("Invalid ram write of {:02X} to address {:04X}", value, address));
     }
 }
+
+void Ram::save_state(StateWriter& writer) const {
+    writer.write(internalRam);
+    writer.write(highRam);
+}
+
+void Ram::load_state(StateReader& reader) {
+    reader.read(internalRam);
+    reader.read(highRam);
+}
@@ -8,6 +8,8 @@
 
 #include "spdlog/fwd.h"
 class Emulator;
+class StateWriter;
+class StateReader;
 
 
 class Ram {
@@ -28,4 +30,7 @@ public:
      * Write value to ram at address.
      */
     void write_byte(uint16_t address, uint8_t value);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 };
@@ -0,0 +1,48 @@
+#include "romcache.hpp"
+#include "memorymappedfile.hpp"
+#include "exceptions.hpp"
+
+#include "fmt/format.h"
+
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+RomCache& RomCache::instance() {
+    static RomCache cache;
+    return cache;
+}
+
+std::shared_ptr<const MemoryMappedFile> RomCache::open(const std::filesystem::path& path) {
+    Key key;
+    try {
+        key = {std::filesystem::canonical(path), std::filesystem::file_size(path),
+               std::filesystem::last_write_time(path)};
+    } catch (const std::filesystem::filesystem_error& e) {
+        throw LoadError(fmt::format("Failed to load {}: {}", path.string(), e.what()));
+    }
+
+    const std::scoped_lock lock{m_mutex};
+    // Drop entries of ROMs which are no longer used
+    std::erase_if(m_files, [](const auto& entry) { return entry.second.expired(); });
+    if (auto it = m_files.find(key); it != m_files.end()) {
+        if (auto file = it->second.lock()) {
+            return file;
+        }
+    }
+    std::shared_ptr<const MemoryMappedFile> file;
+    try {
+        file = std::make_shared<const MemoryMappedFile>(key.path);
+    } catch (const std::exception& e) {
+        throw LoadError(fmt::format("Failed to map {}: {}", path.string(), e.what()));
+    }
+    m_files[key] = file;
+    return file;
+}
+
+size_t RomCache::size() {
+    const std::scoped_lock lock{m_mutex};
+    std::erase_if(m_files, [](const auto& entry) { return entry.second.expired(); });
+    return m_files.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+class MemoryMappedFile;
+
+/*
+ * Process wide cache of memory mapped ROM files. All emulator instances running the same ROM share
+ * one read-only mapping, so loading a ROM doesn't copy it and takes the same time for any ROM
+ * size. A ROM is unmapped when the last instance using it is destroyed.
+ */
+class RomCache {
+public:
+    static RomCache& instance();
+
+    // Map the ROM or return the existing mapping of the same file. Files are identified by their
+    // canonical path, size and modification time, so a ROM which changed on disk is mapped again.
+    // Throws LoadError if the file can't be mapped.
+    [[nodiscard]] std::shared_ptr<const MemoryMappedFile> open(const std::filesystem::path& path);
+
+    // Number of ROMs currently mapped
+    [[nodiscard]] size_t size();
+
+private:
+    struct Key {
+        std::filesystem::path path;
+        uintmax_t file_size = 0;
+        std::filesystem::file_time_type last_write_time;
+
+        bool operator<(const Key& other) const {
+            return std::tie(path, file_size, last_write_time)
+                   < std::tie(other.path, other.file_size, other.last_write_time);
+        }
+    };
+
+    std::mutex m_mutex;
+    std::map<Key, std::weak_ptr<const MemoryMappedFile>> m_files;
+};
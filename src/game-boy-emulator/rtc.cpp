@@ -0,0 +1,238 @@
+#include "rtc.hpp"
+
+#include "savestate.hpp"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace {
+using Days = std::chrono::duration<int64_t, std::ratio<86400>>;
+// The day counter has 9 bits
+constexpr Days DAY_COUNTER_OVERFLOW{512};
+
+constexpr uint8_t SECONDS_MASK = 0b0011'1111;
+constexpr uint8_t MINUTES_MASK = 0b0011'1111;
+constexpr uint8_t HOURS_MASK = 0b0001'1111;
+constexpr uint8_t DAY_HIGH_BIT = 0b0000'0001;
+constexpr uint8_t HALT_BIT = 0b0100'0000;
+constexpr uint8_t DAY_CARRY_BIT = 0b1000'0000;
+
+std::chrono::microseconds wall_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+}
+
+RtcRegisters to_registers(std::chrono::microseconds counter, bool halted, bool day_carry) {
+    const auto days = std::chrono::duration_cast<Days>(counter);
+    const auto hours = std::chrono::duration_cast<std::chrono::hours>(counter - days);
+    const auto minutes = std::chrono::duration_cast<std::chrono::minutes>(counter - days - hours);
+    const auto seconds
+        = std::chrono::duration_cast<std::chrono::seconds>(counter - days - hours - minutes);
+    uint8_t days_high_and_flags = (days.count() >> 8) & DAY_HIGH_BIT;
+    if (halted) {
+        days_high_and_flags |= HALT_BIT;
+    }
+    if (day_carry) {
+        days_high_and_flags |= DAY_CARRY_BIT;
+    }
+    return {.m_seconds = static_cast<uint8_t>(seconds.count()),
+            .m_minutes = static_cast<uint8_t>(minutes.count()),
+            .m_hours = static_cast<uint8_t>(hours.count()),
+            .m_days_low = static_cast<uint8_t>(days.count() & 0xFF),
+            .m_days_high_and_flags = days_high_and_flags};
+}
+
+// Seconds/minutes larger than 59 and hours larger than 23 can be written, but the real clock only
+// wraps them around after counting to the maximum value of their bits. This is not emulated, they
+// carry over to the next register immediately.
+std::chrono::seconds to_counter(const RtcRegisters& registers) {
+    const auto days = ((registers.m_days_high_and_flags & DAY_HIGH_BIT) << 8)
+                      | registers.m_days_low;
+    return Days(days) + std::chrono::hours(registers.m_hours)
+           + std::chrono::minutes(registers.m_minutes) + std::chrono::seconds(registers.m_seconds);
+}
+
+void write_le(std::span<uint8_t> out, uint64_t value) {
+    for (auto& byte : out) {
+        byte = static_cast<uint8_t>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+uint64_t read_le(std::span<const uint8_t> in) {
+    uint64_t value = 0;
+    for (auto byte : in | std::views::reverse) {
+        value = (value << 8) | byte;
+    }
+    return value;
+}
+
+// Registers are stored as 32 bit values, current registers first, then the latched registers.
+void write_registers(std::span<uint8_t> out, const RtcRegisters& registers) {
+    write_le(out.subspan(0, 4), registers.m_seconds);
+    write_le(out.subspan(4, 4), registers.m_minutes);
+    write_le(out.subspan(8, 4), registers.m_hours);
+    write_le(out.subspan(12, 4), registers.m_days_low);
+    write_le(out.subspan(16, 4), registers.m_days_high_and_flags);
+}
+
+RtcRegisters read_registers(std::span<const uint8_t> in) {
+    return {.m_seconds = static_cast<uint8_t>(read_le(in.subspan(0, 4)) & SECONDS_MASK),
+            .m_minutes = static_cast<uint8_t>(read_le(in.subspan(4, 4)) & MINUTES_MASK),
+            .m_hours = static_cast<uint8_t>(read_le(in.subspan(8, 4)) & HOURS_MASK),
+            .m_days_low = static_cast<uint8_t>(read_le(in.subspan(12, 4))),
+            .m_days_high_and_flags = static_cast<uint8_t>(
+                read_le(in.subspan(16, 4)) & (DAY_HIGH_BIT | HALT_BIT | DAY_CARRY_BIT))};
+}
+} // namespace
+
+Rtc::Rtc(Clock emulated_clock) : m_clock(std::move(emulated_clock)), m_logger(spdlog::get("")) {
+    m_base = now();
+}
+
+void Rtc::write_latch(uint8_t value) {
+    if (m_latch_value == 0 && value == 1) {
+        m_latched = get_registers();
+    }
+    m_latch_value = value;
+}
+
+uint8_t Rtc::read(Register reg) const {
+    switch (reg) {
+    case Register::Seconds:
+        return m_latched.m_seconds;
+    case Register::Minutes:
+        return m_latched.m_minutes;
+    case Register::Hours:
+        return m_latched.m_hours;
+    case Register::DaysLow:
+        return m_latched.m_days_low;
+    case Register::DaysHigh:
+        return m_latched.m_days_high_and_flags;
+    }
+    return 0xFF;
+}
+
+void Rtc::write(Register reg, uint8_t value) {
+    const auto counter = get_counter();
+    auto sub_seconds = counter - std::chrono::duration_cast<std::chrono::seconds>(counter);
+    auto registers = to_registers(counter, m_halted, m_day_carry);
+    switch (reg) {
+    case Register::Seconds:
+        registers.m_seconds = value & SECONDS_MASK;
+        // Writing the seconds resets the divider counting the fractions of a second
+        sub_seconds = std::chrono::microseconds(0);
+        break;
+    case Register::Minutes:
+        registers.m_minutes = value & MINUTES_MASK;
+        break;
+    case Register::Hours:
+        registers.m_hours = value & HOURS_MASK;
+        break;
+    case Register::DaysLow:
+        registers.m_days_low = value;
+        break;
+    case Register::DaysHigh:
+        registers.m_days_high_and_flags = value & (DAY_HIGH_BIT | HALT_BIT | DAY_CARRY_BIT);
+        break;
+    }
+    set_registers(registers, sub_seconds);
+}
+
+RtcRegisters Rtc::get_registers() {
+    // Updates the carry, so it has to be called first
+    const auto counter = get_counter();
+    return to_registers(counter, m_halted, m_day_carry);
+}
+
+void Rtc::load(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return;
+    }
+    const std::vector<uint8_t> data{std::istreambuf_iterator<char>(file),
+                                    std::istreambuf_iterator<char>()};
+    if (data.size() < SAVE_SIZE) {
+        m_logger->warn("RTC file {} too small, ignoring it", path.string());
+        return;
+    }
+    const auto content = std::span(data).first<SAVE_SIZE>();
+    const auto registers = read_registers(content.subspan(0, 20));
+    set_registers(registers, std::chrono::microseconds(0));
+    m_latched = read_registers(content.subspan(20, 20));
+    if (!m_clock && !m_halted) {
+        // Catch up with the time which passed since saving
+        const auto saved_at = std::chrono::seconds(read_le(content.subspan(40, 8)));
+        const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now()) - saved_at;
+        m_base -= std::max(elapsed, std::chrono::seconds(0));
+    }
+    m_logger->info("Loaded RTC state from {}", path.string());
+}
+
+void Rtc::save(const std::filesystem::path& path) {
+    std::array<uint8_t, SAVE_SIZE> data{};
+    write_registers(std::span(data).subspan(0, 20), get_registers());
+    write_registers(std::span(data).subspan(20, 20), m_latched);
+    const auto saved_at = std::chrono::duration_cast<std::chrono::seconds>(wall_time());
+    write_le(std::span(data).subspan(40, 8), static_cast<uint64_t>(saved_at.count()));
+    std::ofstream file(path, std::ios::binary);
+    file.write(std::bit_cast<const char*>(data.data()), data.size());
+    if (!file) {
+        m_logger->error("Failed to write RTC file {}", path.string());
+    }
+}
+
+void Rtc::save_state(StateWriter& writer) {
+    // Reading the counter can set the day carry, so it has to be read first.
+    const auto counter = get_counter();
+    writer.write(counter);
+    writer.write(m_halted);
+    writer.write(m_day_carry);
+    writer.write(m_latched);
+    writer.write(m_latch_value);
+}
+
+void Rtc::load_state(StateReader& reader) {
+    const auto counter = reader.read<std::chrono::microseconds>();
+    reader.read(m_halted);
+    reader.read(m_day_carry);
+    reader.read(m_latched);
+    reader.read(m_latch_value);
+    set_counter(counter);
+}
+
+std::chrono::microseconds Rtc::now() const {
+    return m_clock ? m_clock() : wall_time();
+}
+
+std::chrono::microseconds Rtc::get_counter() {
+    auto counter = m_halted ? m_halted_counter : now() - m_base;
+    if (counter >= DAY_COUNTER_OVERFLOW) {
+        m_day_carry = true;
+        counter %= DAY_COUNTER_OVERFLOW;
+        set_counter(counter);
+    }
+    return counter;
+}
+
+void Rtc::set_counter(std::chrono::microseconds counter) {
+    if (m_halted) {
+        m_halted_counter = counter;
+    } else {
+        m_base = now() - counter;
+    }
+}
+
+void Rtc::set_registers(const RtcRegisters& registers, std::chrono::microseconds sub_seconds) {
+    m_halted = (registers.m_days_high_and_flags & HALT_BIT) != 0;
+    m_day_carry = (registers.m_days_high_and_flags & DAY_CARRY_BIT) != 0;
+    set_counter(to_counter(registers) + sub_seconds);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "spdlog/fwd.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+class StateWriter;
+class StateReader;
+
+struct RtcRegisters {
+    uint8_t m_seconds = 0;
+    uint8_t m_minutes = 0;
+    uint8_t m_hours = 0;
+    // Lower 8 bits of day counter
+    uint8_t m_days_low = 0;
+    // Upper 1 bit of day counter, halt and Day counter carry bit
+    uint8_t m_days_high_and_flags = 0;
+};
+
+/*
+ * Real time clock of MBC3 cartridges. Instead of counting every second, the clock stores the point
+ * in time at which its counter was zero. The registers are only computed from the current time when
+ * the game latches them, so a running clock costs nothing.
+ */
+class Rtc {
+public:
+    // Current time in microseconds. Only differences between two values are used.
+    using Clock = std::function<std::chrono::microseconds()>;
+    enum class Register : uint8_t { Seconds, Minutes, Hours, DaysLow, DaysHigh };
+
+    // Follows the time given by emulated_clock, or the wall time if it is empty. With the wall time
+    // the clock also advances while the game is not running.
+    explicit Rtc(Clock emulated_clock = {});
+
+    // Writing 0 and then 1 copies the current time to the registers read by the game.
+    void write_latch(uint8_t value);
+    // Returns the value of the register when it was last latched.
+    [[nodiscard]] uint8_t read(Register reg) const;
+    void write(Register reg, uint8_t value);
+    // Current values of the registers, without latching them
+    [[nodiscard]] RtcRegisters get_registers();
+
+    // The state is saved in the format used by BGB and VBA-M, so saves can be exchanged with them.
+    // A missing file is not an error and keeps the clock at zero.
+    void load(const std::filesystem::path& path);
+    void save(const std::filesystem::path& path);
+
+    // Save states store the counter relative to the clock, loading them continues from the saved
+    // time.
+    void save_state(StateWriter& writer);
+    void load_state(StateReader& reader);
+
+private:
+    static constexpr size_t SAVE_SIZE = 48;
+
+    Clock m_clock;
+    std::shared_ptr<spdlog::logger> m_logger;
+    // Value of the clock at which the counter was zero. Only used while running.
+    std::chrono::microseconds m_base{0};
+    // Value of the counter while halted
+    std::chrono::microseconds m_halted_counter{0};
+    bool m_halted = false;
+    // Set when the day counter overflows, stays set until the game clears it
+    bool m_day_carry = false;
+    RtcRegisters m_latched;
+    // Previous value written to the latch register
+    uint8_t m_latch_value = 0xFF;
+
+    [[nodiscard]] std::chrono::microseconds now() const;
+    // Time since the counter was zero, with overflows of the day counter handled
+    [[nodiscard]] std::chrono::microseconds get_counter();
+    void set_counter(std::chrono::microseconds counter);
+    void set_registers(const RtcRegisters& registers, std::chrono::microseconds sub_seconds);
+};
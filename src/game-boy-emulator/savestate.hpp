@@ -0,0 +1,89 @@
+#pragma once
+
+#include "exceptions.hpp"
+#include "hash.hpp"
+
+#include "fmt/format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Writes the state of the emulator components into a flat byte buffer. Values are copied in native
+ * byte order without any padding or tags, so a state can only be loaded by the same build of the
+ * emulator running the same game.
+ */
+class StateWriter {
+    std::vector<uint8_t> m_data;
+
+public:
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const T& value) {
+        write_span(std::span<const T>{&value, 1});
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void write_span(std::span<const T> values) {
+        const auto bytes = std::as_bytes(values);
+        const auto* begin = reinterpret_cast<const uint8_t*>(bytes.data());
+        m_data.insert(m_data.end(), begin, begin + bytes.size());
+    }
+
+    [[nodiscard]] std::vector<uint8_t> take() {
+        return std::move(m_data);
+    }
+};
+
+/*
+ * Reads values in the order they were written by StateWriter. Throws LoadError when reading past
+ * the end of the state.
+ */
+class StateReader {
+    std::span<const uint8_t> m_data;
+    size_t m_position = 0;
+
+public:
+    explicit StateReader(std::span<const uint8_t> data) : m_data(data) {}
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void read(T& value) {
+        read_span(std::span<T>{&value, 1});
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    [[nodiscard]] T read() {
+        T value{};
+        read(value);
+        return value;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void read_span(std::span<T> values) {
+        const auto size = values.size_bytes();
+        if (m_data.size() - m_position < size) {
+            throw LoadError(fmt::format("Save state truncated, {} bytes missing at offset {}",
+                                        size - (m_data.size() - m_position), m_position));
+        }
+        std::memcpy(values.data(), m_data.data() + m_position, size);
+        m_position += size;
+    }
+
+    [[nodiscard]] bool at_end() const {
+        return m_position == m_data.size();
+    }
+};
+
+// Hash of a save state, for comparing states without keeping them.
+[[nodiscard]] inline uint64_t hash_state(std::span<const uint8_t> state) {
+    return hashing::hash_bytes(state);
+}
@@ -1,16 +1,23 @@
 #include "serial_port.hpp"
 #include "emulator.hpp"
 #include "interrupthandler.hpp"
+#include "bitmanipulation.hpp"
 #include "exceptions.hpp"
+#include "savestate.hpp"
 
 #include "spdlog/spdlog.h"
 #include <fmt/format.h>
 
-SerialPort::SerialPort(Emulator* emulator) : m_emulator(emulator), m_logger(spdlog::get("")) {}
+SerialPort::SerialPort(Emulator* emulator) :
+        m_emulator(emulator), m_logger(emulator->get_logger()) {}
 
 namespace {
 const uint16_t ADDRESS_SERIAL_BUFFER = 0xFF01;
 const uint16_t ADDRESS_SERIAL_CONTROL = 0xFF02;
+const uint8_t CONTROL_TRANSFER_START_BIT = 7;
+const uint8_t CONTROL_INTERNAL_CLOCK_BIT = 0;
+// Bits 1 to 6 are unused
+const uint8_t CONTROL_MASK = 0x81;
 } // namespace
 
 void SerialPort::write_byte(uint16_t address, uint8_t value) {
@@ -20,15 +27,60 @@ void SerialPort::write_byte(uint16_t address, uint8_t value) {
         m_serial_written.push_back(static_cast<char>(value));
     }
     if (address == ADDRESS_SERIAL_CONTROL) {
-        if (value == 0x81) {
-            m_logger->debug("Request serial transfer");
-            m_serial_control = 0x1;
-            m_emulator->get_interrupt_handler()->request_interrupt(
-                InterruptHandler::InterruptType::SerialLink);
+        m_serial_control = static_cast<uint8_t>(value & CONTROL_MASK);
+        if (!is_transferring()) {
+            return;
+        }
+        m_logger->debug("Request serial transfer, control {:02X}", m_serial_control);
+        if (!m_linked) {
+            // Complete without delay, test ROMs print their results through the serial port. With
+            // external clock nobody shifts the bits and the transfer never completes.
+            if (uses_internal_clock()) {
+                bitmanip::unset(m_serial_control, CONTROL_TRANSFER_START_BIT);
+                m_emulator->get_interrupt_handler()->request_interrupt(
+                    InterruptHandler::InterruptType::SerialLink);
+            }
+            return;
+        }
+        if (uses_internal_clock()) {
+            m_transfer_end_cycle = m_emulator->get_state().cycles_m + CYCLES_PER_TRANSFER;
         }
     }
 }
 
+void SerialPort::set_linked(bool linked) {
+    m_linked = linked;
+}
+
+bool SerialPort::is_linked() const {
+    return m_linked;
+}
+
+bool SerialPort::is_transferring() const {
+    return bitmanip::is_bit_set(m_serial_control, CONTROL_TRANSFER_START_BIT);
+}
+
+bool SerialPort::uses_internal_clock() const {
+    return bitmanip::is_bit_set(m_serial_control, CONTROL_INTERNAL_CLOCK_BIT);
+}
+
+bool SerialPort::is_transfer_done() const {
+    return is_transferring() && uses_internal_clock()
+           && m_emulator->get_state().cycles_m >= m_transfer_end_cycle;
+}
+
+uint8_t SerialPort::get_data() const {
+    return m_serial_buffer;
+}
+
+void SerialPort::complete_transfer(uint8_t received) {
+    m_logger->debug("Serial transfer complete, received {:02X}", received);
+    m_serial_buffer = received;
+    bitmanip::unset(m_serial_control, CONTROL_TRANSFER_START_BIT);
+    m_emulator->get_interrupt_handler()->request_interrupt(
+        InterruptHandler::InterruptType::SerialLink);
+}
+
 uint8_t SerialPort::read_byte(uint16_t address) {
     if (address == ADDRESS_SERIAL_BUFFER) {
         m_logger->debug("Serial port read buffer");
@@ -48,3 +100,16 @@ SerialPort::~SerialPort() {
 std::string SerialPort::get_buffer() const {
     return m_serial_written;
 }
+
+// The text written to the serial port so far is output, not state, and is not saved.
+void SerialPort::save_state(StateWriter& writer) const {
+    writer.write(m_serial_buffer);
+    writer.write(m_serial_control);
+    writer.write(m_transfer_end_cycle);
+}
+
+void SerialPort::load_state(StateReader& reader) {
+    reader.read(m_serial_buffer);
+    reader.read(m_serial_control);
+    reader.read(m_transfer_end_cycle);
+}
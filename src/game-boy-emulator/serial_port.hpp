@@ -1,7 +1,12 @@
 #pragma once
 
+#include "constants.h"
 class Emulator;
+class StateWriter;
+class StateReader;
 #include "spdlog/fwd.h"
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 class SerialPort {
@@ -12,8 +17,16 @@ class SerialPort {
     uint8_t m_serial_control = 0;
     // Contains all the bytes written to the serial buffer during the emulators execution.
     std::string m_serial_written;
+    // Set while a link cable connects this port to another emulator
+    bool m_linked = false;
+    // M cycle at which a linked transfer with internal clock has shifted out all bits
+    size_t m_transfer_end_cycle = 0;
 
 public:
+    // The internal clock shifts one bit at 8192 Hz
+    static constexpr size_t CYCLES_PER_BIT = constants::CLOCK_SPEED_M / 8192;
+    static constexpr size_t CYCLES_PER_TRANSFER = 8 * CYCLES_PER_BIT;
+
     explicit SerialPort(Emulator* emulator);
     ~SerialPort();
     SerialPort(const SerialPort&) = default;
@@ -26,4 +39,19 @@ public:
     void write_byte(uint16_t address, uint8_t value);
 
     uint8_t read_byte(uint16_t address);
+
+    // Without a link, transfers with internal clock complete immediately and transfers with
+    // external clock never complete. While linked, the link cable completes transfers.
+    void set_linked(bool linked);
+    [[nodiscard]] bool is_linked() const;
+    [[nodiscard]] bool is_transferring() const;
+    [[nodiscard]] bool uses_internal_clock() const;
+    // True if a transfer with internal clock has shifted out all bits
+    [[nodiscard]] bool is_transfer_done() const;
+    [[nodiscard]] uint8_t get_data() const;
+    // Store the byte received from the other side and request the serial interrupt.
+    void complete_transfer(uint8_t received);
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 };
@@ -0,0 +1,165 @@
+#include "shadowexecution.hpp"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "hash.hpp"
+#include "io.hpp"
+#include "savestate.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+std::unique_ptr<Emulator> create_emulator(std::shared_ptr<const std::vector<uint8_t>> rom,
+                                          const EmulatorOptions& options,
+                                          std::span<const uint8_t> initial_state) {
+    auto emulator = std::make_unique<Emulator>(options);
+    emulator->load_game(std::move(rom));
+    if (!initial_state.empty()) {
+        emulator->load_state(initial_state);
+    }
+    return emulator;
+}
+} // namespace
+
+std::string ShadowExecution::Divergence::describe() const {
+    if (!reproducible) {
+        return fmt::format("States differed at the check after step {}, but not when running again "
+                           "from the previous check. First differing state byte at offset {}.",
+                           step, state_offset);
+    }
+    return fmt::format("States differ after step {}, first differing state byte at offset {}\n"
+                       "  reference: {}\n  candidate: {}",
+                       step, state_offset, reference_cpu_state, candidate_cpu_state);
+}
+
+ShadowExecution::ShadowExecution(std::shared_ptr<const std::vector<uint8_t>> rom, Options options,
+                                 std::span<const uint8_t> initial_state) :
+        m_options(options),
+        m_reference(create_emulator(rom, m_options.reference_options, initial_state)),
+        m_candidate(create_emulator(rom, m_options.candidate_options, initial_state)) {
+    if (m_options.check_interval == 0) {
+        throw LogicError("Shadow execution check interval has to be at least one step");
+    }
+    if (!check()) {
+        m_divergence = bisect();
+    }
+}
+
+ShadowExecution::ShadowExecution(const std::filesystem::path& rom_path, Options options) :
+        ShadowExecution(EmulatorIo().load_rom_file(rom_path), options) {}
+
+ShadowExecution::~ShadowExecution() = default;
+
+std::optional<ShadowExecution::Divergence> ShadowExecution::run(size_t num_steps) {
+    while (num_steps > 0 && !m_divergence) {
+        const auto steps_to_check = m_options.check_interval - (m_steps - m_checked_steps);
+        const auto steps = std::min(steps_to_check, num_steps);
+        step_both(steps);
+        num_steps -= steps;
+        // The states are always checked at the end of a run, so runs of any length can follow.
+        if ((steps == steps_to_check || num_steps == 0) && !check()) {
+            m_divergence = bisect();
+        }
+    }
+    return m_divergence;
+}
+
+size_t ShadowExecution::get_steps() const {
+    return m_steps;
+}
+
+uint64_t ShadowExecution::get_rolling_hash() const {
+    return m_rolling_hash;
+}
+
+Emulator& ShadowExecution::get_reference() {
+    return *m_reference;
+}
+
+Emulator& ShadowExecution::get_candidate() {
+    return *m_candidate;
+}
+
+void ShadowExecution::step_both(size_t num_steps) {
+    for (size_t i = 0; i < num_steps; ++i) {
+        if (!m_reference->step()) {
+            throw LogicError(fmt::format("Reference emulator failed at step {}", m_steps + 1));
+        }
+        if (!m_candidate->step()) {
+            throw LogicError(fmt::format("Candidate emulator failed at step {}", m_steps + 1));
+        }
+        ++m_steps;
+    }
+}
+
+bool ShadowExecution::check() {
+    auto reference_state = m_reference->save_state();
+    auto candidate_state = m_candidate->save_state();
+    const auto reference_hash = hash_state(reference_state);
+    if (reference_hash != hash_state(candidate_state)) {
+        return false;
+    }
+    m_rolling_hash = hashing::combine(m_rolling_hash, reference_hash);
+    if (m_options.reload_candidate_state) {
+        m_candidate->load_state(candidate_state);
+    }
+    m_checked_steps = m_steps;
+    m_checked_reference_state = std::move(reference_state);
+    m_checked_candidate_state = std::move(candidate_state);
+    return true;
+}
+
+void ShadowExecution::restore_checked_states() {
+    m_reference->load_state(m_checked_reference_state);
+    m_candidate->load_state(m_checked_candidate_state);
+    m_steps = m_checked_steps;
+}
+
+bool ShadowExecution::states_match() const {
+    return hash_state(m_reference->save_state()) == hash_state(m_candidate->save_state());
+}
+
+ShadowExecution::Divergence ShadowExecution::bisect() {
+    Divergence divergence;
+    divergence.step = m_steps;
+    auto describe_states = [&]() {
+        const auto reference_state = m_reference->save_state();
+        const auto candidate_state = m_candidate->save_state();
+        const auto first_difference = std::ranges::mismatch(reference_state, candidate_state).in1;
+        divergence.state_offset = static_cast<size_t>(first_difference - reference_state.begin());
+        divergence.reference_cpu_state = m_reference->get_cpu_debug_state();
+        divergence.candidate_cpu_state = m_candidate->get_cpu_debug_state();
+    };
+    describe_states();
+    // The initial states differ, there is nothing to go back to.
+    if (m_checked_reference_state.empty()) {
+        return divergence;
+    }
+    // The states matched after low steps and differed after high steps
+    const auto checked_steps = m_checked_steps;
+    size_t low = checked_steps;
+    size_t high = m_steps;
+    restore_checked_states();
+    step_both(high - checked_steps);
+    if (states_match()) {
+        divergence.reproducible = false;
+        return divergence;
+    }
+    while (high - low > 1) {
+        const auto middle = low + (high - low) / 2;
+        restore_checked_states();
+        step_both(middle - checked_steps);
+        if (states_match()) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    restore_checked_states();
+    step_both(high - checked_steps);
+    divergence.step = high;
+    describe_states();
+    return divergence;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "options.hpp"
+class Emulator;
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * Checks that a candidate emulator, for example one using a new fast path, behaves exactly like a
+ * reference emulator. EmulatorOptions::reference() selects the reference implementations of the
+ * existing fast paths. Both run the same game in lockstep and every check_interval steps the hashes
+ * of their complete states are compared. The state includes the CPU registers, WRAM, VRAM, OAM, I/O
+ * registers, cartridge RAM and the framebuffer. When the hashes differ, both emulators are reset
+ * to the last matching check and the exact step at which they diverge is found by bisection.
+ * Options of the candidate must not change the emulated behaviour, for example frame skipping
+ * leaves the framebuffer untouched.
+ */
+class ShadowExecution {
+public:
+    struct Options {
+        EmulatorOptions reference_options = EmulatorOptions::reference();
+        EmulatorOptions candidate_options = EmulatorOptions::headless();
+        // Number of steps between comparisons of the states
+        size_t check_interval = 1000;
+        // Save and reload the state of the candidate after every check. This verifies that the
+        // state captures everything and that caches are rebuilt correctly from it.
+        bool reload_candidate_state = false;
+    };
+
+    struct Divergence {
+        // Number of steps after which the states differ for the first time
+        size_t step = 0;
+        // False if the states differed at a check, but not when running again from the last
+        // matching check. Then the difference is not part of the state or not deterministic and
+        // step is the step of the check.
+        bool reproducible = true;
+        // Offset of the first differing byte in the save states
+        size_t state_offset = 0;
+        std::string reference_cpu_state{};
+        std::string candidate_cpu_state{};
+
+        [[nodiscard]] std::string describe() const;
+    };
+
+    // An empty initial state starts the game from the beginning.
+    ShadowExecution(std::shared_ptr<const std::vector<uint8_t>> rom, Options options,
+                    std::span<const uint8_t> initial_state = {});
+    ShadowExecution(const std::filesystem::path& rom_path, Options options);
+    ShadowExecution(const ShadowExecution&) = delete;
+    ShadowExecution& operator=(const ShadowExecution&) = delete;
+    ShadowExecution(ShadowExecution&&) = default;
+    ShadowExecution& operator=(ShadowExecution&&) = default;
+    ~ShadowExecution();
+
+    // Step both emulators num_steps times, a step executes one instruction or one cycle while
+    // halted. Returns the first divergence, then both emulators are left at the step of the
+    // divergence and later calls return it again without stepping.
+    // Throws LogicError if an emulator fails.
+    std::optional<ShadowExecution::Divergence> run(size_t num_steps);
+
+    [[nodiscard]] size_t get_steps() const;
+    // Combined hash of the states at all checks, which can be compared between builds.
+    [[nodiscard]] uint64_t get_rolling_hash() const;
+    [[nodiscard]] Emulator& get_reference();
+    [[nodiscard]] Emulator& get_candidate();
+
+private:
+    Options m_options;
+    std::unique_ptr<Emulator> m_reference;
+    std::unique_ptr<Emulator> m_candidate;
+    size_t m_steps = 0;
+    uint64_t m_rolling_hash = 0;
+    // States of the last check at which both emulators matched
+    size_t m_checked_steps = 0;
+    std::vector<uint8_t> m_checked_reference_state;
+    std::vector<uint8_t> m_checked_candidate_state;
+    std::optional<Divergence> m_divergence;
+
+    void step_both(size_t num_steps);
+    // Returns false if the states differ, otherwise they become the last matching check.
+    bool check();
+    void restore_checked_states();
+    [[nodiscard]] bool states_match() const;
+    [[nodiscard]] Divergence bisect();
+};
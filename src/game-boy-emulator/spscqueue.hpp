@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/*
+ * Lock-free bounded queue for one producer thread and one consumer thread. Values are stored in a
+ * ring buffer allocated as part of the queue, so pushing and popping never allocates.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(std::has_single_bit(Capacity), "Capacity has to be a power of two");
+    static constexpr size_t INDEX_MASK = Capacity - 1;
+    // Keep the indices written by different threads on separate cache lines.
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::array<T, Capacity> m_slots{};
+    // Number of values popped so far, written by the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head{0};
+    // Number of values pushed so far, written by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail{0};
+
+public:
+    // Producer: returns false and drops the value if the queue is full.
+    bool push(T value) {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_slots[tail & INDEX_MASK] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: returns std::nullopt if the queue is empty.
+    std::optional<T> pop() {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        std::optional<T> value{std::move(m_slots[head & INDEX_MASK])};
+        m_head.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+};
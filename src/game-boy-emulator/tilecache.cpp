@@ -0,0 +1,70 @@
+#include "tilecache.hpp"
+#include "graphics.hpp"
+#include "bitmanipulation.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+TileCache::TileCache(std::span<const uint8_t, memmap::TileDataSize> tile_data) :
+        m_tile_data(tile_data) {
+    // Nothing was decoded yet
+    m_dirty.set();
+}
+
+void TileCache::invalidate(size_t tile_data_offset) {
+    assert(tile_data_offset < m_tile_data.size() && "Tile data offset out of range");
+    m_dirty.set(tile_data_offset / constants::BYTES_PER_TILE);
+}
+
+void TileCache::invalidate_all() {
+    m_dirty.set();
+}
+
+const TileCache::Tile& TileCache::get_tile(size_t tile_number) {
+    update(tile_number);
+    return m_tiles[tile_number];
+}
+
+const TileCache::Tile& TileCache::get_tile_mirrored(size_t tile_number) {
+    update(tile_number);
+    return m_tiles_mirrored[tile_number];
+}
+
+const TileCache::TileLine& TileCache::get_line(size_t tile_number, size_t y, bool mirrored) {
+    update(tile_number);
+    return mirrored ? m_tiles_mirrored[tile_number][y] : m_tiles[tile_number][y];
+}
+
+TileCache::TileLine
+TileCache::decode_line(std::span<const uint8_t, memmap::TileDataSize> tile_data,
+                       size_t tile_number, size_t y, bool mirrored) {
+    assert(tile_number < NUM_TILES && "Tile number out of range");
+    // 2 bytes represent one 8 pixel wide row in the tile
+    const auto line_begin = (tile_number * constants::BYTES_PER_TILE) + (y * 2);
+    const auto low_byte = tile_data[line_begin];
+    const auto high_byte = tile_data[line_begin + 1];
+    if (mirrored) {
+        return graphics::gb::convert_tile_line(bitmanip::reverse_bits(low_byte),
+                                               bitmanip::reverse_bits(high_byte));
+    }
+    return graphics::gb::convert_tile_line(low_byte, high_byte);
+}
+
+void TileCache::update(size_t tile_number) {
+    assert(tile_number < NUM_TILES && "Tile number out of range");
+    if (!m_dirty.test(tile_number)) {
+        return;
+    }
+    const auto tile_begin = tile_number * constants::BYTES_PER_TILE;
+    for (size_t y = 0; y < constants::PIXELS_PER_TILE; ++y) {
+        // 2 bytes represent one 8 pixel wide row in the tile
+        const auto low_byte = m_tile_data[tile_begin + (y * 2)];
+        const auto high_byte = m_tile_data[tile_begin + (y * 2) + 1];
+        m_tiles[tile_number][y] = graphics::gb::convert_tile_line(low_byte, high_byte);
+        // Mirroring the bit planes mirrors the decoded pixels
+        m_tiles_mirrored[tile_number][y] = graphics::gb::convert_tile_line(
+            bitmanip::reverse_bits(low_byte), bitmanip::reverse_bits(high_byte));
+    }
+    m_dirty.reset(tile_number);
+}
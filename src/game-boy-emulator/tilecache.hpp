@@ -0,0 +1,51 @@
+#pragma once
+
+#include "graphics.hpp"
+#include "memorymap.hpp"
+#include "constants.h"
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/*
+ * Decoded copies of all 384 tiles in VRAM, stored as one color index per pixel. Each tile is also
+ * kept horizontally mirrored for sprites with the x flip flag set.
+ * Writes to the tile data mark the tile as dirty, it is decoded again on the next access.
+ * Pixels are not packed: packed 2 bit pixels are what VRAM already stores, and unpacking them is
+ * the work the cache saves. With one byte per pixel, lines are copied into the line buffers and
+ * palettes are indexed without any bit operations. Both tile sets take 48 KiB.
+ */
+class TileCache {
+public:
+    static constexpr size_t NUM_TILES = memmap::TileDataSize / constants::BYTES_PER_TILE;
+    using TileLine = std::array<graphics::gb::UnmappedColorGb, constants::PIXELS_PER_TILE>;
+    using Tile = std::array<TileLine, constants::PIXELS_PER_TILE>;
+
+    explicit TileCache(std::span<const uint8_t, memmap::TileDataSize> tile_data);
+
+    // Has to be called after a write into the tile data. Offset is relative to 0x8000.
+    void invalidate(size_t tile_data_offset);
+    // Has to be called after the tile data was replaced completely.
+    void invalidate_all();
+
+    // Tiles are numbered as in the tile data, 0..383 (0x8000-0x97FF).
+    const Tile& get_tile(size_t tile_number);
+    const Tile& get_tile_mirrored(size_t tile_number);
+    const TileLine& get_line(size_t tile_number, size_t y, bool mirrored = false);
+
+    // Decode a line of a tile directly from the tile data, without caching.
+    [[nodiscard]] static TileLine
+    decode_line(std::span<const uint8_t, memmap::TileDataSize> tile_data, size_t tile_number,
+                size_t y, bool mirrored = false);
+
+private:
+    std::span<const uint8_t, memmap::TileDataSize> m_tile_data;
+    std::array<Tile, NUM_TILES> m_tiles{};
+    std::array<Tile, NUM_TILES> m_tiles_mirrored{};
+    // Tiles which were written to since they were decoded the last time.
+    std::bitset<NUM_TILES> m_dirty;
+
+    void update(size_t tile_number);
+};
@@ -5,6 +5,8 @@
 #include "exceptions.hpp"
 #include "bitmanipulation.hpp"
 #include "interrupthandler.hpp"
+#include "apu.hpp"
+#include "savestate.hpp"
 
 #include "spdlog/spdlog.h"
 #include <fmt/format.h>
@@ -15,7 +17,7 @@
 #include <limits>
 
 
-Timer::Timer(Emulator* emulator) : m_emulator(emulator), m_logger(spdlog::get("")) {}
+Timer::Timer(Emulator* emulator) : m_emulator(emulator), m_logger(emulator->get_logger()) {}
 
 namespace {
 // The cycle count is in M cycles, meaning it is a quarter of the actual clock rate/the T cycle
@@ -31,7 +33,7 @@ void Timer::cycle_elapsed_callback(size_t cycle_num) {
     m_was_counter_reloaded = false;
 
     if (cycle_num % N_CYCLES_TIMER_COUNTER[3] == 0) {
-        m_divider_register += 1;
+        set_divider(m_divider_register + 1);
     }
     if (!bitmanip::is_bit_set(m_timer_control, 2)) {
         return;
@@ -71,7 +73,7 @@ void Timer::write_byte(uint16_t address, uint8_t value) {
     if (address == ADDRESS_DIVIDER_REGISTER) {
         // Any value resets the divider to 0.
         m_logger->debug("Reset timer DIV");
-        m_divider_register = 0;
+        set_divider(0);
     } else if (address == ADDRESS_TIMER_CONTROL) {
         m_logger->debug("Set timer control {:03b}", value);
         m_timer_control = value;
@@ -98,6 +100,15 @@ void Timer::write_byte(uint16_t address, uint8_t value) {
     }
 }
 
+void Timer::set_divider(uint8_t value) {
+    // DIV-APU event, this happens every 32 DIV increments (512 Hz) or when resetting DIV while
+    // bit 4 is set.
+    if (bitmanip::is_bit_set(m_divider_register, 4) && !bitmanip::is_bit_set(value, 4)) {
+        m_emulator->get_apu()->div_apu_callback();
+    }
+    m_divider_register = value;
+}
+
 uint8_t Timer::read_byte(uint16_t address) const {
     switch (address) {
     case ADDRESS_DIVIDER_REGISTER:
@@ -112,3 +123,21 @@ uint8_t Timer::read_byte(uint16_t address) const {
         throw LogicError(fmt::format("Timer invalid read from {:04X}", address));
     }
 }
+
+void Timer::save_state(StateWriter& writer) const {
+    writer.write(m_divider_register);
+    writer.write(m_timer_counter);
+    writer.write(m_timer_modulo);
+    writer.write(m_timer_control);
+    writer.write(m_overflow_flag);
+    writer.write(m_was_counter_reloaded);
+}
+
+void Timer::load_state(StateReader& reader) {
+    reader.read(m_divider_register);
+    reader.read(m_timer_counter);
+    reader.read(m_timer_modulo);
+    reader.read(m_timer_control);
+    reader.read(m_overflow_flag);
+    reader.read(m_was_counter_reloaded);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 class Emulator;
+class StateWriter;
+class StateReader;
 #include "spdlog/fwd.h"
 #include <memory>
 #include <cstdint>
@@ -20,6 +22,9 @@ class Timer {
     bool m_overflow_flag = false;
     bool m_was_counter_reloaded = false;
 
+    // Update DIV and notify the APU about falling edges of bit 4, which clock the frame sequencer.
+    void set_divider(uint8_t value);
+
 public:
     explicit Timer(Emulator* emulator);
 
@@ -28,4 +33,7 @@ public:
 
     void write_byte(uint16_t address, uint8_t value);
     [[nodiscard]] uint8_t read_byte(uint16_t address) const;
+
+    void save_state(StateWriter& writer) const;
+    void load_state(StateReader& reader);
 };
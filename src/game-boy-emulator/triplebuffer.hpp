@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Lock-free triple buffer for passing values from one writer thread to one reader thread. The
+ * writer fills the back buffer and publishes it, the reader always gets the newest published
+ * buffer. Neither side ever waits for the other, values which are not picked up by the reader are
+ * overwritten by the next publish.
+ */
+template <typename T>
+class TripleBuffer {
+    // Set in m_middle while it contains a value which the reader didn't pick up yet
+    static constexpr uint8_t NEW_DATA_FLAG = 0b100;
+    static constexpr uint8_t INDEX_MASK = 0b011;
+
+    std::array<T, 3> m_buffers{};
+    // Index of the buffer exchanged between writer and reader, together with NEW_DATA_FLAG
+    std::atomic<uint8_t> m_middle{1};
+    // Only accessed by the writer
+    uint8_t m_back = 0;
+    // Only accessed by the reader
+    uint8_t m_front = 2;
+
+public:
+    // Writer: the buffer to fill before calling publish. It contains an older value and has to be
+    // overwritten completely.
+    T& back() {
+        return m_buffers[m_back];
+    }
+
+    // Writer: make the back buffer available to the reader.
+    void publish() {
+        const auto previous = m_middle.exchange(m_back | NEW_DATA_FLAG, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+    }
+
+    // Reader: switch the front buffer to the newest published value. Returns false and keeps the
+    // current front buffer if nothing was published since the last call.
+    bool update() {
+        if ((m_middle.load(std::memory_order_relaxed) & NEW_DATA_FLAG) == 0) {
+            return false;
+        }
+        const auto previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Reader: the value returned by the last update, or a default constructed value before that.
+    const T& front() const {
+        return m_buffers[m_front];
+    }
+};
@@ -1,6 +1,115 @@
 #include "wavechannel.hpp"
+#include "audiochannel.hpp"
+#include "bitmanipulation.hpp"
+#include "savestate.hpp"
 #include <cstdint>
+#include <cstddef>
+#include <span>
+
+namespace {
+// Length timer of the wave channel is 8 bits wide instead of 6 bits for the other channels.
+constexpr unsigned WAVE_LENGTH_TIMER_MAX = 256;
+constexpr uint8_t NUM_WAVE_SAMPLES = 32;
+} // namespace
+
+WaveChannel::WaveChannel(std::span<const uint8_t, 16> wave_ram) : m_wave_ram(wave_ram) {}
+
+void WaveChannel::advance_waveform(size_t steps) {
+    m_position = static_cast<uint8_t>((m_position + steps) % NUM_WAVE_SAMPLES);
+    // Only the sample at the final position is audible, so wave RAM is read once per catch up
+    // instead of once per position change.
+    m_sample_buffer = m_wave_ram[m_position / 2];
+}
 
 uint8_t WaveChannel::get_sample() {
-    return 0;
+    auto output_level = get_output_level();
+    if (output_level == 0) {
+        // Muted
+        return 0;
+    }
+    auto sample = (m_position % 2 == 0) ? bitmanip::get_high_nibble(m_sample_buffer)
+                                        : bitmanip::get_low_nibble(m_sample_buffer);
+    // Output level 1 is 100% volume, 2 is 50% and 3 is 25%.
+    return sample >> (output_level - 1);
+}
+
+void WaveChannel::trigger() {
+    if (!is_dac_enabled()) {
+        set_enabled(false);
+        return;
+    }
+    m_position = 0;
+    restart_period();
+    if (m_length_timer == WAVE_LENGTH_TIMER_MAX) {
+        m_length_timer = 0;
+    }
+}
+
+void WaveChannel::do_sound_length() {
+    if (!is_length_enabled() || m_length_timer == WAVE_LENGTH_TIMER_MAX) {
+        return;
+    }
+    m_length_timer++;
+    if (m_length_timer == WAVE_LENGTH_TIMER_MAX) {
+        set_enabled(false);
+    }
+}
+
+void WaveChannel::set_nrx0(uint8_t value) {
+    AudioChannel::set_nrx0(value);
+    if (!is_dac_enabled()) {
+        // Turning the DAC off also disables the channel.
+        set_enabled(false);
+    }
+}
+
+void WaveChannel::set_nrx1(uint8_t value) {
+    AudioChannel::set_nrx1(value);
+    m_length_timer = value;
+}
+
+void WaveChannel::set_nrx4(uint8_t value) {
+    AudioChannel::set_nrx4(value);
+    if (bitmanip::is_bit_set(value, 7)) {
+        set_enabled(true);
+        trigger();
+    }
+}
+
+bool WaveChannel::is_dac_enabled() const {
+    return bitmanip::is_bit_set(read_nrx0(), 7);
+}
+
+uint8_t WaveChannel::get_output_level() const {
+    return (read_nrx2() & 0b01100000) >> 5;
+}
+
+uint16_t WaveChannel::get_wavelength() const {
+    auto high = read_nrx4() & 0b111;
+    return bitmanip::word_from_bytes(high, read_nrx3());
+}
+
+size_t WaveChannel::get_period() const {
+    // The wave channel advances its position at 2 MHz / (2048 - wavelength), meaning every
+    // 2 * (2048 - wavelength) T cycles.
+    return 2 * (2048 - static_cast<size_t>(get_wavelength()));
+}
+
+bool WaveChannel::is_length_enabled() const {
+    return bitmanip::is_bit_set(read_nrx4(), 6);
+}
+
+// Wave RAM is owned and saved by the APU.
+void WaveChannel::save_state(StateWriter& writer) const {
+    AudioChannel::save_state(writer);
+    writer.write(m_position);
+    writer.write(m_sample_buffer);
+    writer.write(m_length_timer);
+}
+
+void WaveChannel::load_state(StateReader& reader) {
+    AudioChannel::load_state(reader);
+    reader.read(m_position);
+    reader.read(m_sample_buffer);
+    reader.read(m_length_timer);
 }
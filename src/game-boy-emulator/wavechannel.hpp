@@ -1,8 +1,50 @@
 #pragma once
 
 #include "audiochannel.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
 
+/*
+ * Channel playing back the 32 4-bit samples stored in wave pattern RAM (0xFF30-0xFF3F).
+ */
 class WaveChannel : public AudioChannel {
+    // View of the wave pattern RAM owned by the APU.
+    std::span<const uint8_t, 16> m_wave_ram;
+
+    // Index into the 32 4-bit samples of wave RAM
+    uint8_t m_position = 0;
+    // Last sample read from wave RAM, upper nibble is played first.
+    uint8_t m_sample_buffer = 0;
+
+    // Counts up at 256 Hz, the channel is turned off when it reaches 256.
+    unsigned m_length_timer = 0;
+
+    // Bit 7 of NR30
+    [[nodiscard]] bool is_dac_enabled() const;
+    // Bits 5..6 of NR32
+    [[nodiscard]] uint8_t get_output_level() const;
+    // Bits 0..2 of NR34 and NR33
+    [[nodiscard]] uint16_t get_wavelength() const;
+    // Number of T cycles between two position changes
+    [[nodiscard]] size_t get_period() const override;
+    void advance_waveform(size_t steps) override;
+    // Bit 6 of NR34
+    [[nodiscard]] bool is_length_enabled() const;
+
+    void trigger();
+
 public:
+    explicit WaveChannel(std::span<const uint8_t, 16> wave_ram);
+
     uint8_t get_sample() override;
+
+    void do_sound_length();
+
+    void set_nrx0(uint8_t value) override;
+    void set_nrx1(uint8_t value) override;
+    void set_nrx4(uint8_t value) override;
+
+    void save_state(StateWriter& writer) const override;
+    void load_state(StateReader& reader) override;
 };
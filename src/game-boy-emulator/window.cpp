@@ -1,7 +1,10 @@
 #include "window.hpp"
 #include "emulator.hpp"
+#include "emulatorthread.hpp"
 #include "ppu.hpp"
+#include "debugviews.hpp"
 #include "joypad.hpp"
+#include "bitmanipulation.hpp"
 
 #include "fmt/format.h"
 #include "magic_enum.hpp"
@@ -21,10 +24,20 @@
 namespace {
     constexpr int FPS_HISTORY_SIZE = 5 * 60;
     constexpr int NUM_SAMPLES_FOR_FPS_AVERAGE = std::min(60, FPS_HISTORY_SIZE);
+    // While the emulator produces no frames, the UI only redraws on events. Some frames are still
+    // drawn after an event, which ImGui needs to finish reacting to it. The timeout makes sure
+    // changes of the emulator state are shown.
+    constexpr int IDLE_FRAMES_AFTER_EVENT = 3;
+    constexpr int IDLE_EVENT_TIMEOUT_MS = 100;
 }
 
-Window::Window(Emulator& emulator) :
-        m_emulator(emulator), m_logger(spdlog::get("")), m_fps_history(FPS_HISTORY_SIZE, 0) {
+Window::Window(Emulator& emulator, EmulatorThread& emulator_thread) :
+        m_emulator_thread(emulator_thread),
+        m_debug_views(emulator.get_ppu()->get_debug_views()),
+        m_options(emulator.get_options()),
+        m_sent_options(m_options),
+        m_logger(spdlog::get("")),
+        m_fps_history(FPS_HISTORY_SIZE, 0) {
     // Setup SDL
     // (Some versions of SDL before <2.0.10 appears to have performance/stalling issues on a
     // minority of Windows systems, depending on whether SDL_INIT_GAMECONTROLLER is enabled or
@@ -94,6 +107,7 @@ constexpr SDL_KeyCode KEY_HOLD_FAST_FORWARD = SDLK_SPACE;
 constexpr SDL_KeyCode KEY_TOGGLE_FAST_FORWARD = SDLK_f;
 constexpr SDL_KeyCode KEY_FAST_FORWARD_INCREASE = SDLK_q;
 constexpr SDL_KeyCode KEY_FAST_FORWARD_DECREASE = SDLK_e;
+constexpr SDL_KeyCode KEY_PAUSE = SDLK_p;
 
 void toggle(bool& b) {
     b = !b;
@@ -109,9 +123,13 @@ void Window::draw_frame() {
 
     draw_menubar();
 
-    auto& options = m_emulator.get_options();
-    const auto& state = m_emulator.get_state();
-    if (state.rom_file_path.has_value()) {
+    const auto& options = m_options;
+    // Debug views are only rendered while their window is drawn and not collapsed, which the draw
+    // functions report.
+    m_debug_views.set_visible(DebugViews::View::Background, false);
+    m_debug_views.set_visible(DebugViews::View::Window, false);
+    m_debug_views.set_visible(DebugViews::View::TileData, false);
+    if (m_emulator_thread.get_frame().rom_loaded) {
 
         if (options.draw_debug_background) {
             draw_background();
@@ -143,58 +161,52 @@ void Window::draw_frame() {
     SDL_RenderPresent(m_sdl_renderer);
 }
 
-void Window::handle_user_keyboard_input(const SDL_Event& event,
-                                        const std::shared_ptr<Joypad>& joypad) {
+void Window::handle_user_keyboard_input(const SDL_Event& event) {
     auto& io = ImGui::GetIO();
     if (!io.WantCaptureKeyboard) {
         // Ignore repeated down events since they don't alter joypad state
         if (event.type == SDL_KEYDOWN && event.key.repeat == 0) {
             switch (event.key.keysym.sym) {
             case KEY_UP:
-                joypad->press_key(Joypad::Keys::Up);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Up)] = true;
+                press_key(Joypad::Keys::Up);
                 break;
             case KEY_LEFT:
-                joypad->press_key(Joypad::Keys::Left);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Left)] = true;
+                press_key(Joypad::Keys::Left);
                 break;
             case KEY_DOWN:
-                joypad->press_key(Joypad::Keys::Down);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Down)] = true;
+                press_key(Joypad::Keys::Down);
                 break;
             case KEY_RIGHT:
-                joypad->press_key(Joypad::Keys::Right);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Right)] = true;
+                press_key(Joypad::Keys::Right);
                 break;
             case KEY_A:
-                joypad->press_key(Joypad::Keys::A);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::A)] = true;
+                press_key(Joypad::Keys::A);
                 break;
             case KEY_B:
-                joypad->press_key(Joypad::Keys::B);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::B)] = true;
+                press_key(Joypad::Keys::B);
                 break;
             case KEY_START:
-                joypad->press_key(Joypad::Keys::Start);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Start)] = true;
+                press_key(Joypad::Keys::Start);
                 break;
             case KEY_SELECT:
-                joypad->press_key(Joypad::Keys::Select);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Select)] = true;
+                press_key(Joypad::Keys::Select);
                 break;
             case KEY_HOLD_FAST_FORWARD:
             case KEY_TOGGLE_FAST_FORWARD:
-                toggle(m_emulator.get_options().fast_forward);
+                toggle(m_options.fast_forward);
                 break;
             case KEY_FAST_FORWARD_INCREASE:
-                m_emulator.get_options().game_speed++;
-                m_emulator.get_options().fast_forward = true;
+                m_options.game_speed++;
+                m_options.fast_forward = true;
                 break;
             case KEY_FAST_FORWARD_DECREASE:
-                if (m_emulator.get_options().game_speed > 1) {
-                    m_emulator.get_options().game_speed--;
+                if (m_options.game_speed > 1) {
+                    m_options.game_speed--;
                 }
-                m_emulator.get_options().fast_forward = m_emulator.get_options().game_speed > 1;
+                m_options.fast_forward = m_options.game_speed > 1;
+                break;
+            case KEY_PAUSE:
+                toggle(m_options.paused);
                 break;
             default:
                 // Other keys not handled by emulator.
@@ -204,39 +216,31 @@ void Window::handle_user_keyboard_input(const SDL_Event& event,
         if (event.type == SDL_KEYUP) {
             switch (event.key.keysym.sym) {
             case KEY_UP:
-                joypad->release_key(Joypad::Keys::Up);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Up)] = false;
+                release_key(Joypad::Keys::Up);
                 break;
             case KEY_LEFT:
-                joypad->release_key(Joypad::Keys::Left);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Left)] = false;
+                release_key(Joypad::Keys::Left);
                 break;
             case KEY_DOWN:
-                joypad->release_key(Joypad::Keys::Down);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Down)] = false;
+                release_key(Joypad::Keys::Down);
                 break;
             case KEY_RIGHT:
-                joypad->release_key(Joypad::Keys::Right);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Right)] = false;
+                release_key(Joypad::Keys::Right);
                 break;
             case KEY_A:
-                joypad->release_key(Joypad::Keys::A);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::A)] = false;
+                release_key(Joypad::Keys::A);
                 break;
             case KEY_B:
-                joypad->release_key(Joypad::Keys::B);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::B)] = false;
+                release_key(Joypad::Keys::B);
                 break;
             case KEY_START:
-                joypad->release_key(Joypad::Keys::Start);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Start)] = false;
+                release_key(Joypad::Keys::Start);
                 break;
             case KEY_SELECT:
-                joypad->release_key(Joypad::Keys::Select);
-                m_pressed_keys[static_cast<int>(Joypad::Keys::Select)] = false;
+                release_key(Joypad::Keys::Select);
                 break;
             case KEY_HOLD_FAST_FORWARD:
-                toggle(m_emulator.get_options().fast_forward);
+                toggle(m_options.fast_forward);
                 break;
             default:
                 // Other keys not handled by emulator.
@@ -251,39 +255,52 @@ bool Window::is_done() const {
 }
 
 void Window::draw_background() {
-    const auto& background = m_emulator.get_ppu()->get_background();
-    m_background_image.upload_to_texture(background);
-    auto& options = m_emulator.get_options();
-    ImGui::Begin("Background", &options.draw_debug_background, ImGuiWindowFlags_NoResize);
-    auto* my_tex_id = static_cast<void*>(m_background_image.get_texture());
-    ImGui::Image(my_tex_id, ImVec2(static_cast<float>(background.width()),
-                                   static_cast<float>(background.height())));
+    const bool visible
+        = ImGui::Begin("Background", &m_options.draw_debug_background, ImGuiWindowFlags_NoResize);
+    m_debug_views.set_visible(DebugViews::View::Background, visible);
+    if (visible) {
+        const auto lock = m_debug_views.lock();
+        const auto* views = m_debug_views.get_views();
+        if (views != nullptr && is_view_outdated(DebugViews::View::Background)) {
+            m_background_image.upload_to_texture(views->background);
+        }
+        auto* my_tex_id = static_cast<void*>(m_background_image.get_texture());
+        ImGui::Image(my_tex_id, ImVec2(static_cast<float>(m_background_image.width()),
+                                       static_cast<float>(m_background_image.height())));
+    }
     ImGui::End();
 }
 
 void Window::draw_sprites() {
-    const auto& sprites = m_emulator.get_ppu()->get_sprites();
-    m_sprites_image.upload_to_texture(sprites);
-    auto& options = m_emulator.get_options();
-    ImGui::Begin("Sprites", &options.draw_debug_sprites, ImGuiWindowFlags_NoResize);
+    // Drawn by the PPU starting with the first frame after enabling the view
+    if (m_new_frame && m_emulator_thread.get_frame().has_sprites) {
+        m_sprites_image.upload_to_texture(m_emulator_thread.get_frame().sprites);
+    }
+    ImGui::Begin("Sprites", &m_options.draw_debug_sprites, ImGuiWindowFlags_NoResize);
     auto* my_tex_id = static_cast<void*>(m_sprites_image.get_texture());
-    ImGui::Image(my_tex_id,
-                 ImVec2(static_cast<float>(sprites.width()), static_cast<float>(sprites.height())));
+    ImGui::Image(my_tex_id, ImVec2(static_cast<float>(m_sprites_image.width()),
+                                   static_cast<float>(m_sprites_image.height())));
     ImGui::End();
 }
 
 void Window::draw_window() {
-    const auto& window = m_emulator.get_ppu()->get_window();
-    auto& options = m_emulator.get_options();
-    ImGui::Begin("Window", &options.draw_debug_window, ImGuiWindowFlags_NoResize);
-    m_window_image.upload_to_texture(window);
-    auto* my_tex_id = static_cast<void*>(m_window_image.get_texture());
-    ImGui::Image(my_tex_id,
-                 ImVec2(static_cast<float>(window.width()), static_cast<float>(window.height())));
+    const bool visible
+        = ImGui::Begin("Window", &m_options.draw_debug_window, ImGuiWindowFlags_NoResize);
+    m_debug_views.set_visible(DebugViews::View::Window, visible);
+    if (visible) {
+        const auto lock = m_debug_views.lock();
+        const auto* views = m_debug_views.get_views();
+        if (views != nullptr && is_view_outdated(DebugViews::View::Window)) {
+            m_window_image.upload_to_texture(views->window);
+        }
+        auto* my_tex_id = static_cast<void*>(m_window_image.get_texture());
+        ImGui::Image(my_tex_id, ImVec2(static_cast<float>(m_window_image.width()),
+                                       static_cast<float>(m_window_image.height())));
+    }
     ImGui::End();
 }
 
-void Window::vblank_callback() {
+void Window::update() {
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui
     // wants to use your inputs.
@@ -292,8 +309,14 @@ void Window::vblank_callback() {
     // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main
     // application. Generally you may always pass all inputs to dear imgui, and hide them from
     // your application based on those two flags.
+    const bool idle = !m_emulator_thread.get_frame().rom_loaded || m_options.paused;
+    if (idle && m_frames_since_event >= IDLE_FRAMES_AFTER_EVENT) {
+        SDL_WaitEventTimeout(nullptr, IDLE_EVENT_TIMEOUT_MS);
+    }
+    ++m_frames_since_event;
     SDL_Event event;
     while (SDL_PollEvent(&event) == 1) {
+        m_frames_since_event = 0;
         ImGui_ImplSDL2_ProcessEvent(&event);
         if (event.type == SDL_QUIT) {
             m_done = true;
@@ -302,25 +325,57 @@ void Window::vblank_callback() {
             && event.window.windowID == SDL_GetWindowID(m_sdl_window)) {
             m_done = true;
         }
-        handle_user_keyboard_input(event, m_emulator.get_joypad());
+        handle_user_keyboard_input(event);
     }
 
-    const auto& state = m_emulator.get_state();
-    const auto& options = m_emulator.get_options();
-    const auto& game = m_emulator.get_ppu()->get_game();
-    if (options.fast_forward) {
-        if (state.frame_count % static_cast<size_t>(options.game_speed) == 0) {
-            m_game_image.upload_to_texture(game);
-            draw_frame();
+    // Only upload frames which were not shown yet. The emulator keeps running while the UI waits
+    // for vsync, frames finished in the meantime are dropped.
+    m_new_frame = m_emulator_thread.update_frame();
+    if (m_new_frame) {
+        m_game_image.upload_to_texture(m_emulator_thread.get_frame().game);
+    }
+    draw_frame();
+    send_options_if_changed();
+}
+
+bool Window::is_view_outdated(DebugViews::View view) {
+    auto& uploaded_generation = m_uploaded_view_generations[static_cast<size_t>(view)];
+    if (uploaded_generation == m_debug_views.get_generation()) {
+        return false;
+    }
+    uploaded_generation = m_debug_views.get_generation();
+    return true;
+}
+
+void Window::press_key(Joypad::Keys key) {
+    m_pressed_keys[static_cast<size_t>(key)] = true;
+    send_pressed_keys();
+}
+
+void Window::release_key(Joypad::Keys key) {
+    m_pressed_keys[static_cast<size_t>(key)] = false;
+    send_pressed_keys();
+}
+
+void Window::send_pressed_keys() {
+    uint8_t keys = 0;
+    for (uint8_t i = 0; i < m_pressed_keys.size(); ++i) {
+        if (m_pressed_keys[i]) {
+            bitmanip::set(keys, i);
         }
-    } else {
-        m_game_image.upload_to_texture(game);
-        draw_frame();
+    }
+    m_emulator_thread.set_pressed_keys(keys);
+}
+
+void Window::send_options_if_changed() {
+    if (m_options != m_sent_options && m_emulator_thread.send(command::SetOptions{m_options})) {
+        m_sent_options = m_options;
     }
 }
 
 void Window::draw_game() {
-    ImGui::Begin(m_emulator.get_state().game_title.c_str(), nullptr, ImGuiWindowFlags_NoResize);
+    ImGui::Begin(m_emulator_thread.get_frame().game_title.c_str(), nullptr,
+                 ImGuiWindowFlags_NoResize);
     auto* my_tex_id = static_cast<void*>(m_game_image.get_texture());
     ImGui::Image(my_tex_id, ImVec2(static_cast<float>(m_game_image.width() * 3),
                                    static_cast<float>(m_game_image.height() * 3)));
@@ -328,8 +383,8 @@ void Window::draw_game() {
 }
 
 void Window::draw_info() {
-    const auto& state = m_emulator.get_state();
-    auto& options = m_emulator.get_options();
+    const auto& frame = m_emulator_thread.get_frame();
+    auto& options = m_options;
     ImGui::Begin("Info", &options.draw_info_window, ImGuiWindowFlags_AlwaysAutoResize);
     const auto current_ticks = SDL_GetTicks64();
     const auto ms_since_last_frame = current_ticks - m_previous_ticks;
@@ -350,25 +405,42 @@ void Window::draw_info() {
         ImGui::Text("%s", fmt::format("{}: {}", name, key_state).c_str());
     }
     if (current_ticks >= m_last_ips_update_ticks + 1000) {
-        m_instructions_per_second = static_cast<double>(state.instructions_executed - m_last_instructions_executed);
-        m_last_instructions_executed = state.instructions_executed;
+        m_instructions_per_second = static_cast<double>(frame.instructions_executed - m_last_instructions_executed);
+        m_last_instructions_executed = frame.instructions_executed;
+        m_emulated_frames_per_second = static_cast<double>(frame.frame_count - m_last_frame_count);
+        m_last_frame_count = frame.frame_count;
         m_last_ips_update_ticks = current_ticks;
     }
     ImGui::Text("Instructions/sec: %.2f k", m_instructions_per_second / 1'000.0);
-    ImGui::Text("%s", fmt::format("{} instructions elapsed", state.instructions_executed).c_str());
-    ImGui::Text("Speed %d", options.game_speed);
+    ImGui::Text("%s", fmt::format("{} instructions elapsed", frame.instructions_executed).c_str());
+    // The FPS graph above shows the presented frames, which are less than the emulated frames when
+    // frames are skipped.
+    ImGui::Text("Emulated FPS: %.1f, presented FPS: %.1f", m_emulated_frames_per_second, avg_fps);
+    ImGui::Text("Speed %d, frame skip %d", options.game_speed, options.get_frame_skip());
+    ImGui::Text("Memory per instance: %.1f KB",
+                static_cast<double>(frame.memory_usage) / 1024.0);
     ImGui::End();
     // Store for next iteration
     m_previous_ticks = current_ticks;
 }
 
 void Window::draw_vram() {
-    auto buffers = m_emulator.get_ppu()->get_tiledata();
-    m_tiledata_block0.upload_to_texture(*buffers[0]);
-    m_tiledata_block1.upload_to_texture(*buffers[1]);
-    m_tiledata_block2.upload_to_texture(*buffers[2]);
-    auto& options = m_emulator.get_options();
-    ImGui::Begin("Tile block 0,1,2", &options.draw_debug_tiles, ImGuiWindowFlags_NoResize);
+    const bool visible
+        = ImGui::Begin("Tile block 0,1,2", &m_options.draw_debug_tiles, ImGuiWindowFlags_NoResize);
+    m_debug_views.set_visible(DebugViews::View::TileData, visible);
+    if (!visible) {
+        ImGui::End();
+        return;
+    }
+    {
+        const auto lock = m_debug_views.lock();
+        const auto* views = m_debug_views.get_views();
+        if (views != nullptr && is_view_outdated(DebugViews::View::TileData)) {
+            m_tiledata_block0.upload_to_texture(views->tile_data[0]);
+            m_tiledata_block1.upload_to_texture(views->tile_data[1]);
+            m_tiledata_block2.upload_to_texture(views->tile_data[2]);
+        }
+    }
     auto* my_tex_id = static_cast<void*>(m_tiledata_block0.get_texture());
     const auto scale = 2;
     ImGui::Image(my_tex_id, ImVec2(static_cast<float>(m_tiledata_block0.width() * scale),
@@ -391,7 +463,7 @@ void Window::draw_menubar_file() {
         if (result == NFD_OKAY) {
             spdlog::info("Loading game {}", *out_path.get());
             std::filesystem::path const p{out_path.get()};
-            m_emulator.get_state().new_rom_file_path = p;
+            m_emulator_thread.send(command::LoadGame{p});
         } else if (result == NFD_ERROR) {
             spdlog::error("Error opening file picker: {}", NFD_GetError());
         }
@@ -424,6 +496,8 @@ void draw_menubar_settings_ppu(EmulatorOptions& options) {
 }
 
 void draw_menubar_settings_speed(EmulatorOptions& options) {
+    ImGui::MenuItem("Pause", "P", &options.paused);
+    ImGui::Separator();
     if (ImGui::RadioButton("Speed 1", &options.game_speed, 1)) {
         options.fast_forward = false;
         options.game_speed = 1;
@@ -441,6 +515,17 @@ void draw_menubar_settings_speed(EmulatorOptions& options) {
         options.fast_forward = true;
         ImGui::CloseCurrentPopup();
     }
+    ImGui::Separator();
+    if (ImGui::RadioButton("Frame skip auto", &options.frame_skip,
+                           EmulatorOptions::FRAME_SKIP_AUTO)) {
+        ImGui::CloseCurrentPopup();
+    }
+    for (int frame_skip = 0; frame_skip <= 3; ++frame_skip) {
+        if (ImGui::RadioButton(fmt::format("Frame skip {}", frame_skip).c_str(),
+                               &options.frame_skip, frame_skip)) {
+            ImGui::CloseCurrentPopup();
+        }
+    }
     ImGui::EndMenu();
 }
 
@@ -481,7 +566,7 @@ void draw_menubar_settings_sound(EmulatorOptions& options, float volume) {
 } // namespace
 
 void Window::draw_menubar_settings() {
-    auto& options = m_emulator.get_options();
+    auto& options = m_options;
     if (ImGui::BeginMenu("PPU debug")) {
         draw_menubar_settings_ppu(options);
     }
@@ -489,7 +574,7 @@ void Window::draw_menubar_settings() {
         draw_menubar_settings_speed(options);
     }
     if (ImGui::BeginMenu("Sound")) {
-        const float volume = m_emulator.get_options().volume;
+        const float volume = m_options.volume;
         draw_menubar_settings_sound(options, volume);
     }
 
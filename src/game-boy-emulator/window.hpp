@@ -2,20 +2,31 @@
 
 #include "image.hpp"
 #include "constants.h"
+#include "debugviews.hpp"
+#include "joypad.hpp"
+#include "options.hpp"
 class SDL_Window;
 struct  SDL_Renderer;
 struct  SDL_Texture;
 union SDL_Event;
 class Emulator;
-struct EmulatorState;
-class Joypad;
+class EmulatorThread;
 #include "spdlog/fwd.h"
 #include "boost/circular_buffer.hpp"
+#include <array>
 #include <cstdint>
 
 
+/*
+ * Frontend running on the main thread. It only communicates with the emulator through the
+ * EmulatorThread and the thread safe debug views.
+ */
 class Window {
-    Emulator& m_emulator;
+    EmulatorThread& m_emulator_thread;
+    DebugViews& m_debug_views;
+    // Options as edited by the UI, sent to the emulator thread when they change
+    EmulatorOptions m_options;
+    EmulatorOptions m_sent_options;
     std::shared_ptr<spdlog::logger> m_logger;
     SDL_Window* m_sdl_window = nullptr;
     SDL_Renderer* m_sdl_renderer = nullptr;
@@ -33,6 +44,11 @@ class Window {
           constants::SPRITE_VIEWER_HEIGHT * constants::PIXELS_PER_TILE>
         m_tiledata_block2;
     bool m_done = false;
+    // Set if the emulator finished a frame since the last update
+    bool m_new_frame = false;
+    int m_frames_since_event = 0;
+    // Generation of the debug views at the last upload of each view
+    std::array<uint64_t, 3> m_uploaded_view_generations{};
 
     //TODO Refactor this out into an info widget containg history and providing the statistics data while keeping
     // display formatting in Window.
@@ -42,8 +58,16 @@ class Window {
     uint64_t m_last_ips_update_ticks = 0;
     uint64_t m_last_instructions_executed = 0;
     double   m_instructions_per_second = 0.0;
+    uint64_t m_last_frame_count = 0;
+    double   m_emulated_frames_per_second = 0.0;
 
-    void handle_user_keyboard_input(const SDL_Event& event, const std::shared_ptr<Joypad>& joypad);
+    void handle_user_keyboard_input(const SDL_Event& event);
+    void press_key(Joypad::Keys key);
+    void release_key(Joypad::Keys key);
+    void send_pressed_keys();
+    void send_options_if_changed();
+    // True if the debug views changed since the view was uploaded last. Requires the views lock.
+    bool is_view_outdated(DebugViews::View view);
 
     void draw_menubar_file();
     void draw_menubar_settings();
@@ -58,14 +82,15 @@ class Window {
     void draw_frame();
 
 public:
-    explicit Window(Emulator& emulator);
+    Window(Emulator& emulator, EmulatorThread& emulator_thread);
     Window(const Window&) = delete;
     Window& operator=(const Window&) = delete;
     Window(Window&&) = delete;
     Window& operator=(Window&&) = delete;
     ~Window();
 
-    void vblank_callback();
+    // Handle events and draw the UI with the newest frame of the emulator thread
+    void update();
 
     [[nodiscard]] bool is_done() const;
 };
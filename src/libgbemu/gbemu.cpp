@@ -0,0 +1,194 @@
+#include "gbemu.h"
+
+#include "constants.h"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "graphics.hpp"
+#include "joypad.hpp"
+#include "options.hpp"
+#include "ppu.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+
+static_assert(sizeof(gbemu_sample) == sizeof(SampleFrame)
+                  && alignof(gbemu_sample) == alignof(SampleFrame),
+              "gbemu_sample has to match SampleFrame");
+static_assert(sizeof(graphics::gb::ColorGb) == sizeof(uint8_t));
+static_assert(GBEMU_SCREEN_WIDTH == constants::SCREEN_RES_WIDTH
+              && GBEMU_SCREEN_HEIGHT == constants::SCREEN_RES_HEIGHT);
+static_assert(GBEMU_AUDIO_SAMPLE_RATE == constants::CLOCK_SPEED_M);
+
+namespace {
+// The key bits are passed to Joypad::set_pressed_keys unchanged.
+constexpr int key_bit(Joypad::Keys key) {
+    return 1 << static_cast<int>(key);
+}
+} // namespace
+static_assert(GBEMU_KEY_RIGHT == key_bit(Joypad::Keys::Right));
+static_assert(GBEMU_KEY_LEFT == key_bit(Joypad::Keys::Left));
+static_assert(GBEMU_KEY_UP == key_bit(Joypad::Keys::Up));
+static_assert(GBEMU_KEY_DOWN == key_bit(Joypad::Keys::Down));
+static_assert(GBEMU_KEY_A == key_bit(Joypad::Keys::A));
+static_assert(GBEMU_KEY_B == key_bit(Joypad::Keys::B));
+static_assert(GBEMU_KEY_SELECT == key_bit(Joypad::Keys::Select));
+static_assert(GBEMU_KEY_START == key_bit(Joypad::Keys::Start));
+
+struct gbemu {
+    std::unique_ptr<Emulator> emulator;
+    uint8_t keys = 0;
+    bool audio_enabled = false;
+    std::vector<uint8_t> saved_state;
+    std::string last_error;
+};
+
+namespace {
+// Run f and translate exceptions into an error code, which is the only way errors can cross the C
+// interface.
+template <typename F>
+int call(gbemu* emu, F&& f) {
+    if (emu == nullptr) {
+        return GBEMU_ERROR;
+    }
+    emu->last_error.clear();
+    try {
+        f();
+        return GBEMU_OK;
+    } catch (const std::exception& e) {
+        emu->last_error = e.what();
+    } catch (...) {
+        emu->last_error = "Unknown error";
+    }
+    return GBEMU_ERROR;
+}
+
+Emulator& get_emulator(gbemu* emu) {
+    if (!emu->emulator) {
+        throw LogicError("No ROM loaded");
+    }
+    return *emu->emulator;
+}
+} // namespace
+
+extern "C" {
+
+gbemu* gbemu_create() {
+    return new (std::nothrow) gbemu{};
+}
+
+void gbemu_destroy(gbemu* emu) {
+    delete emu;
+}
+
+int gbemu_load_rom(gbemu* emu, const uint8_t* data, size_t size) {
+    return call(emu, [&] {
+        if (data == nullptr) {
+            throw LoadError("No ROM data");
+        }
+        // Start from a new instance, so nothing of a previous game remains.
+        emu->emulator.reset();
+        auto options = EmulatorOptions::headless();
+        options.sound_enabled = emu->audio_enabled;
+        auto emulator = std::make_unique<Emulator>(options);
+        emulator->set_audio_buffer_enabled(true);
+        emulator->load_game(std::make_shared<const std::vector<uint8_t>>(data, data + size));
+        emulator->get_joypad()->set_pressed_keys(emu->keys);
+        emu->emulator = std::move(emulator);
+    });
+}
+
+int gbemu_run_frames(gbemu* emu, size_t num_frames) {
+    return call(emu, [&] {
+        auto& emulator = get_emulator(emu);
+        emulator.clear_audio_buffer();
+        if (!emulator.run_frames(num_frames)) {
+            throw LogicError("Emulation stopped because of an error, see the log for details");
+        }
+    });
+}
+
+size_t gbemu_get_frame_count(const gbemu* emu) {
+    if (emu == nullptr || !emu->emulator) {
+        return 0;
+    }
+    return emu->emulator->get_state().frame_count;
+}
+
+int gbemu_set_joypad(gbemu* emu, uint8_t keys) {
+    return call(emu, [&] {
+        emu->keys = keys;
+        if (emu->emulator) {
+            emu->emulator->get_joypad()->set_pressed_keys(keys);
+        }
+    });
+}
+
+const uint8_t* gbemu_get_framebuffer(const gbemu* emu) {
+    if (emu == nullptr || !emu->emulator) {
+        return nullptr;
+    }
+    const auto pixels = emu->emulator->get_ppu()->get_game().pixels();
+    return reinterpret_cast<const uint8_t*>(pixels.data());
+}
+
+int gbemu_set_audio_enabled(gbemu* emu, int enabled) {
+    return call(emu, [&] {
+        emu->audio_enabled = enabled != 0;
+        if (emu->emulator) {
+            emu->emulator->get_options().sound_enabled = emu->audio_enabled;
+        }
+    });
+}
+
+const gbemu_sample* gbemu_get_audio(const gbemu* emu, size_t* num_samples) {
+    if (emu == nullptr || !emu->emulator) {
+        if (num_samples != nullptr) {
+            *num_samples = 0;
+        }
+        return nullptr;
+    }
+    const auto samples = emu->emulator->get_audio_buffer();
+    if (num_samples != nullptr) {
+        *num_samples = samples.size();
+    }
+    return reinterpret_cast<const gbemu_sample*>(samples.data());
+}
+
+const uint8_t* gbemu_save_state(gbemu* emu, size_t* size) {
+    const auto result = call(emu, [&] {
+        emu->saved_state = get_emulator(emu).save_state();
+    });
+    if (result != GBEMU_OK) {
+        return nullptr;
+    }
+    if (size != nullptr) {
+        *size = emu->saved_state.size();
+    }
+    return emu->saved_state.data();
+}
+
+int gbemu_load_state(gbemu* emu, const uint8_t* data, size_t size) {
+    return call(emu, [&] {
+        if (data == nullptr) {
+            throw LoadError("No state data");
+        }
+        auto& emulator = get_emulator(emu);
+        emulator.load_state(std::span<const uint8_t>(data, size));
+        emulator.get_joypad()->set_pressed_keys(emu->keys);
+    });
+}
+
+const char* gbemu_get_last_error(const gbemu* emu) {
+    if (emu == nullptr) {
+        return "No instance";
+    }
+    return emu->last_error.c_str();
+}
+
+} // extern "C"
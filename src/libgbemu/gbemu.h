@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ * C interface of the emulator core, built as libgbemu.so. It is meant for driving the emulator from
+ * other languages, such as training harnesses which step many games without a frontend.
+ *
+ * Functions returning int return GBEMU_OK on success and GBEMU_ERROR otherwise, in which case
+ * gbemu_get_last_error describes the error. Pointers returned by the library point into the
+ * emulator and are never copied, they stay valid until the noted function is called again. An
+ * instance may only be used by one thread at a time, different instances are independent.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define GBEMU_API __attribute__((visibility("default")))
+#else
+#define GBEMU_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GBEMU_OK 0
+#define GBEMU_ERROR (-1)
+
+#define GBEMU_SCREEN_WIDTH 160
+#define GBEMU_SCREEN_HEIGHT 144
+// Number of audio samples per second, one sample is produced every M cycle.
+#define GBEMU_AUDIO_SAMPLE_RATE 1048576
+
+// Bits of the joypad state, a set bit means the key is held down.
+enum gbemu_key {
+    GBEMU_KEY_RIGHT = 1 << 0,
+    GBEMU_KEY_LEFT = 1 << 1,
+    GBEMU_KEY_UP = 1 << 2,
+    GBEMU_KEY_DOWN = 1 << 3,
+    GBEMU_KEY_A = 1 << 4,
+    GBEMU_KEY_B = 1 << 5,
+    GBEMU_KEY_SELECT = 1 << 6,
+    GBEMU_KEY_START = 1 << 7,
+};
+
+typedef struct gbemu_sample {
+    float left;
+    float right;
+} gbemu_sample;
+
+typedef struct gbemu gbemu;
+
+// Returns NULL if the instance could not be allocated.
+GBEMU_API gbemu* gbemu_create(void);
+GBEMU_API void gbemu_destroy(gbemu* emu);
+
+// Start the game from a copy of the ROM, resetting the emulator. Cartridge RAM is kept in memory
+// and the real time clock follows the emulated time, so runs are deterministic.
+GBEMU_API int gbemu_load_rom(gbemu* emu, const uint8_t* data, size_t size);
+
+// Emulate until num_frames more frames were finished. Clears the audio buffer first.
+GBEMU_API int gbemu_run_frames(gbemu* emu, size_t num_frames);
+// Number of frames emulated since the game was loaded
+GBEMU_API size_t gbemu_get_frame_count(const gbemu* emu);
+
+// Replace the held keys by a combination of gbemu_key bits.
+GBEMU_API int gbemu_set_joypad(gbemu* emu, uint8_t keys);
+
+// GBEMU_SCREEN_WIDTH * GBEMU_SCREEN_HEIGHT pixels in row-major order, each a shade from 0 (white)
+// to 3 (black). Valid until gbemu_load_rom, the content changes with gbemu_run_frames.
+GBEMU_API const uint8_t* gbemu_get_framebuffer(const gbemu* emu);
+
+// Audio is not generated by default since it is expensive.
+GBEMU_API int gbemu_set_audio_enabled(gbemu* emu, int enabled);
+// Samples produced by the last gbemu_run_frames at GBEMU_AUDIO_SAMPLE_RATE. Valid until the next
+// call to gbemu_run_frames.
+GBEMU_API const gbemu_sample* gbemu_get_audio(const gbemu* emu, size_t* num_samples);
+
+// Snapshot of the emulator state. Valid until the next call to gbemu_save_state. Returns NULL on
+// error.
+GBEMU_API const uint8_t* gbemu_save_state(gbemu* emu, size_t* size);
+// Restore a state saved by the same version of the library for the same game. The held keys are
+// not part of the state and stay as they were set. The emulator is unchanged if this fails.
+GBEMU_API int gbemu_load_state(gbemu* emu, const uint8_t* data, size_t size);
+
+// Description of the last error of this instance, empty if there was none.
+GBEMU_API const char* gbemu_get_last_error(const gbemu* emu);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,6 @@
 #include "emulator.hpp"
+#include "emulatorthread.hpp"
+#include "shadowexecution.hpp"
 #include "window.hpp"
 #include "ppu.hpp"
 #include "apu.hpp"
@@ -7,10 +9,12 @@
 #include "spdlog/spdlog.h"
 #include "argparse/argparse.hpp"
 
+#include <charconv>
 #include <exception>
 #include <filesystem>
 #include <optional>
 #include <cstdlib>
+#include <string>
 #include <spdlog/common.h>
 
 
@@ -18,6 +22,11 @@ int main(int argc, char** argv) { // NOLINT(bugprone-exception-escape)
     argparse::ArgumentParser program("game boy emulator");
     program.add_argument("--game").help("Path to game ROM file to run.");
     program.add_argument("--boot").default_value("").help("Path to boot ROM file.");
+    program.add_argument("--check-determinism")
+        .metavar("STEPS")
+        .help("Run the game for the given number of steps without a window, with all fast paths "
+              "in lockstep with their reference implementations, reloading the state at every "
+              "check, and report the first divergence.");
 
     spdlog::set_level(spdlog::level::info);
 
@@ -38,6 +47,36 @@ int main(int argc, char** argv) { // NOLINT(bugprone-exception-escape)
         game_rom_path = std::filesystem::absolute(program.get("game"));
     }
 
+    if (program.is_used("check-determinism")) {
+        const auto steps_argument = program.get("check-determinism");
+        const auto* steps_end = steps_argument.data() + steps_argument.size();
+        size_t num_steps = 0;
+        const auto [parsed_end, error]
+            = std::from_chars(steps_argument.data(), steps_end, num_steps);
+        if (error != std::errc() || parsed_end != steps_end) {
+            spdlog::error("Invalid number of steps '{}' for --check-determinism", steps_argument);
+            spdlog::error(program.help().str());
+            return EXIT_FAILURE;
+        }
+        if (!game_rom_path.has_value()) {
+            spdlog::error("Checking determinism requires a game rom.");
+            return EXIT_FAILURE;
+        }
+        // The reference emulator uses the reference implementations of all fast paths, the
+        // candidate the fast paths used when playing.
+        ShadowExecution shadow{game_rom_path.value(),
+                               {.reference_options = EmulatorOptions::reference(),
+                                .reload_candidate_state = true}};
+        const auto divergence = shadow.run(num_steps);
+        if (divergence.has_value()) {
+            spdlog::error(divergence->describe());
+            return EXIT_FAILURE;
+        }
+        spdlog::info("No divergence in {} steps, state hash {:016X}", shadow.get_steps(),
+                     shadow.get_rolling_hash());
+        return EXIT_SUCCESS;
+    }
+
     Emulator emulator{{}};
     if (boot_rom_path.has_value() and game_rom_path.has_value()) {
         emulator.load_boot_game(boot_rom_path.value(), game_rom_path.value());
@@ -49,36 +88,24 @@ int main(int argc, char** argv) { // NOLINT(bugprone-exception-escape)
         std::exit(1);
     }
 
-    Window window(emulator);
-    emulator.set_draw_function([&]() { window.vblank_callback(); });
+    EmulatorThread emulator_thread(emulator);
+    Window window(emulator, emulator_thread);
 
     Audio audio(emulator);
     if (audio.is_working()) {
         emulator.set_audio_function([&](SampleFrame sample) { audio.callback(sample); });
+        emulator_thread.set_game_changed_function([&]() { audio.clear_queued_samples(); });
     }
 
-    // Main loop
+    // Emulation runs on its own thread, the main loop only handles the UI.
+    emulator_thread.start();
     while (!window.is_done()) {
-        if (emulator.get_state().rom_file_path.has_value()) {
-            auto sucess = emulator.step();
-            if (!sucess) {
-                return EXIT_FAILURE;
-            }
-        } else {
-            // Normally the vblank interrupt would trigger this callback. But since we are in a
-            // state where no game is loaded and the emulator is not running, we have to call it
-            // manually for the UI to render
-            window.vblank_callback();
-        }
-        const auto& state = emulator.get_state();
-        if (state.new_rom_file_path.has_value()) {
-            audio.clear_queued_samples();
-            auto path = state.new_rom_file_path.value();
-            emulator.get_state().new_rom_file_path = std::nullopt;
-            emulator.reset_state();
-            emulator.load_game(path);
+        if (emulator_thread.has_failed()) {
+            return EXIT_FAILURE;
         }
+        window.update();
     }
+    emulator_thread.stop();
 
     return EXIT_SUCCESS;
 }
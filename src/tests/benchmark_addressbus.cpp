@@ -0,0 +1,51 @@
+#include "catch2/catch.hpp"
+
+#include "addressbus.hpp"
+#include "emulator.hpp"
+#include "memorymap.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+struct Region {
+    std::string name;
+    uint16_t begin;
+    uint16_t end;
+};
+} // namespace
+
+TEST_CASE("Address bus reads", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    Emulator emulator{EmulatorOptions::headless()};
+    emulator.load_game("roms/dmg-acid2.gb");
+    auto bus = emulator.get_bus();
+    // Only mapped addresses, reading unmapped I/O registers would log errors
+    const std::vector<Region> regions{
+        {"ROM bank 0", memmap::CartridgeRomFixedBankBegin, memmap::CartridgeRomFixedBankEnd},
+        {"Switchable ROM bank", memmap::CartridgeRomBankSwitchableBegin,
+         memmap::CartridgeRomBankSwitchableEnd},
+        {"VRAM", memmap::VRamBegin, memmap::VRamEnd},
+        {"WRAM", memmap::InternalRamBegin, memmap::InternalRamEnd},
+        {"Echo RAM", memmap::EchoRamBegin, memmap::EchoRamEnd},
+        {"OAM", memmap::OamRamBegin, memmap::OamRamEnd},
+        {"PPU registers", memmap::PpuIoRegistersBegin, memmap::PpuIoRegistersEnd},
+        {"APU registers", memmap::ApuBegin, memmap::ApuEnd},
+        {"Wave pattern", memmap::WavePatternBegin, memmap::WavePatternEnd},
+        {"HRAM", memmap::HighRamBegin, memmap::HighRamEnd},
+    };
+
+    for (const auto& region : regions) {
+        BENCHMARK(std::string(region.name)) {
+            // Combine the results so the reads are not optimized away
+            unsigned checksum = 0;
+            for (unsigned address = region.begin; address <= region.end; ++address) {
+                checksum += bus->read_byte(static_cast<uint16_t>(address));
+            }
+            return checksum;
+        };
+    }
+}
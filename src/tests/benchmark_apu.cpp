@@ -0,0 +1,108 @@
+#include "catch2/catch.hpp"
+
+#include "apu.hpp"
+#include "constants.h"
+#include "emulator.hpp"
+#include "resampler.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+// Duration of one frame in M cycles (154 scanlines), the APU produces one sample per cycle.
+constexpr size_t CYCLES_PER_FRAME = 154 * 114;
+constexpr size_t OUTPUT_SAMPLE_RATE = 44100;
+
+// Turn on the APU and trigger all four channels without length counter, so they keep playing.
+void enable_all_channels(Apu& apu) {
+    // NR52, NR51, NR50: APU on, all channels on both sides, full volume
+    apu.write_byte(0xFF26, 0x80);
+    apu.write_byte(0xFF25, 0xFF);
+    apu.write_byte(0xFF24, 0x77);
+    // Pulse channels: 50 % duty, full volume and trigger
+    for (uint16_t base : {0xFF10, 0xFF15}) {
+        apu.write_byte(static_cast<uint16_t>(base + 1), 0x80);
+        apu.write_byte(static_cast<uint16_t>(base + 2), 0xF0);
+        apu.write_byte(static_cast<uint16_t>(base + 3), 0x00);
+        apu.write_byte(static_cast<uint16_t>(base + 4), 0x87);
+    }
+    // Wave channel: varying wave pattern, DAC on, full volume and trigger
+    for (uint16_t address = 0xFF30; address <= 0xFF3F; ++address) {
+        apu.write_byte(address, static_cast<uint8_t>(address * 37));
+    }
+    apu.write_byte(0xFF1A, 0x80);
+    apu.write_byte(0xFF1C, 0x20);
+    apu.write_byte(0xFF1D, 0x00);
+    apu.write_byte(0xFF1E, 0x87);
+    // Noise channel: full volume, fastest clock and trigger
+    apu.write_byte(0xFF21, 0xF0);
+    apu.write_byte(0xFF22, 0x00);
+    apu.write_byte(0xFF23, 0x80);
+}
+} // namespace
+
+TEST_CASE("APU sample generation", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    auto options = EmulatorOptions::headless();
+    options.sound_enabled = true;
+    Emulator emulator{options};
+    emulator.load_game("roms/dmg-acid2.gb");
+    auto apu = emulator.get_apu();
+    enable_all_channels(*apu);
+    // Samples are generated for the cycles elapsed since the last ones, so time has to advance as
+    // it does while running.
+    size_t cycle = 0;
+
+    BENCHMARK("Frame of samples") {
+        for (size_t i = 0; i < CYCLES_PER_FRAME; ++i) {
+            apu->cycle_elapsed_callback(++cycle);
+        }
+        float checksum = 0;
+        for (const auto& sample : apu->get_samples()) {
+            checksum += sample.left + sample.right;
+        }
+        apu->clear_samples();
+        return checksum;
+    };
+}
+
+TEST_CASE("Emulated frame with sound", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    const auto sound_enabled = GENERATE(true, false);
+    auto options = EmulatorOptions::headless();
+    options.sound_enabled = sound_enabled;
+    Emulator emulator{options};
+    emulator.set_audio_buffer_enabled(true);
+    // dmg-acid2 doesn't use the APU, so the channels keep playing while it runs.
+    emulator.load_game("roms/dmg-acid2.gb");
+    enable_all_channels(*emulator.get_apu());
+
+    BENCHMARK(sound_enabled ? "Sound enabled" : "Sound disabled") {
+        emulator.clear_audio_buffer();
+        REQUIRE(emulator.run_frames(1));
+        return emulator.get_audio_buffer().size();
+    };
+}
+
+TEST_CASE("Audio resampling", "[benchmark]") {
+    // A frame of stereo samples at the emulated clock rate, converted to the output rate like the
+    // audio output does.
+    std::vector<SampleFrame> input(CYCLES_PER_FRAME);
+    for (size_t i = 0; i < input.size(); ++i) {
+        const auto value = static_cast<float>(i % 64) / 32.0f - 1.0f;
+        input[i] = {value, -value};
+    }
+    Resampler<SampleFrame> resampler{AUDIO_F32SYS, AUDIO_F32SYS, constants::CLOCK_SPEED_M,
+                                     OUTPUT_SAMPLE_RATE, 2, 2};
+    std::vector<SampleFrame> output(CYCLES_PER_FRAME);
+
+    BENCHMARK("Frame of samples") {
+        resampler.submit_sample_data(input);
+        const auto available = std::min(resampler.available_samples(), output.size());
+        return resampler.get_resampled_data(std::span(output).first(available));
+    };
+}
@@ -0,0 +1,90 @@
+#include "catch2/catch.hpp"
+
+#include "cpu.hpp"
+#include "emulator.hpp"
+#include "options.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// Number of instructions executed per benchmark run
+constexpr size_t NUM_INSTRUCTIONS = 10'000;
+constexpr uint16_t SETUP_ADDRESS = 0x0150;
+constexpr uint16_t LOOP_ADDRESS = 0x0160;
+constexpr uint16_t SUBROUTINE_ADDRESS = 0x1000;
+// Number of copies of the instructions in the loop, so the final jump back is only a small part
+// of the executed instructions.
+constexpr size_t NUM_LOOP_COPIES = 64;
+
+struct OpcodeClass {
+    std::string name;
+    std::vector<uint8_t> instructions;
+};
+
+/*
+ * Build a 32 KB ROM without MBC which jumps to a setup and then executes the instructions in an
+ * endless loop. The setup points HL to WRAM and the stack pointer to the end of WRAM, so the
+ * memory instructions and calls stay in RAM.
+ */
+std::shared_ptr<const std::vector<uint8_t>> create_rom(const std::vector<uint8_t>& instructions) {
+    std::vector<uint8_t> rom(32 * 1024, 0);
+    auto write = [&rom](size_t address, const std::vector<uint8_t>& bytes) {
+        std::ranges::copy(bytes, rom.begin() + static_cast<std::ptrdiff_t>(address));
+        return address + bytes.size();
+    };
+    // Entry point: NOP, JP SETUP_ADDRESS
+    write(0x100, {0x00, 0xC3, SETUP_ADDRESS & 0xFF, SETUP_ADDRESS >> 8});
+    // LD HL,0xC000; LD SP,0xDFFE; JP LOOP_ADDRESS
+    write(SETUP_ADDRESS, {0x21, 0x00, 0xC0, 0x31, 0xFE, 0xDF, 0xC3, LOOP_ADDRESS & 0xFF,
+                          LOOP_ADDRESS >> 8});
+    auto address = static_cast<size_t>(LOOP_ADDRESS);
+    for (size_t i = 0; i < NUM_LOOP_COPIES; ++i) {
+        address = write(address, instructions);
+    }
+    // JP LOOP_ADDRESS
+    write(address, {0xC3, LOOP_ADDRESS & 0xFF, LOOP_ADDRESS >> 8});
+    // RET
+    write(SUBROUTINE_ADDRESS, {0xC9});
+    return std::make_shared<const std::vector<uint8_t>>(std::move(rom));
+}
+} // namespace
+
+TEST_CASE("CPU instruction throughput", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    // Each run executes NUM_INSTRUCTIONS steps, including the timer, PPU and APU updates of every
+    // elapsed cycle, as the emulator does while running a game.
+    const std::vector<OpcodeClass> opcode_classes{
+        {"NOP", {0x00}},
+        // LD B,C; LD D,B; LD E,D
+        {"8 bit register loads", {0x41, 0x50, 0x5A}},
+        // ADD A,B; XOR A,C; CP A,D; INC E
+        {"8 bit ALU", {0x80, 0xA9, 0xBA, 0x1C}},
+        // INC BC; ADD HL,DE; INC DE
+        {"16 bit arithmetic", {0x03, 0x19, 0x13}},
+        // LD A,(HL); LD (HL),B; LDH A,(0x80); LDH (0x80),A
+        {"Memory loads and stores", {0x7E, 0x70, 0xF0, 0x80, 0xE0, 0x80}},
+        // BIT 7,H; RLC B; SWAP C; SET 3,D
+        {"CB prefixed", {0xCB, 0x7C, 0xCB, 0x00, 0xCB, 0x31, 0xCB, 0xDA}},
+        // JR +0
+        {"Relative jumps", {0x18, 0x00}},
+        // CALL SUBROUTINE_ADDRESS, which returns immediately
+        {"Calls and returns", {0xCD, SUBROUTINE_ADDRESS & 0xFF, SUBROUTINE_ADDRESS >> 8}},
+    };
+
+    for (const auto& opcode_class : opcode_classes) {
+        Emulator emulator{EmulatorOptions::headless()};
+        emulator.load_game(create_rom(opcode_class.instructions));
+        auto cpu = emulator.get_cpu();
+        BENCHMARK(std::string(opcode_class.name)) {
+            for (size_t i = 0; i < NUM_INSTRUCTIONS; ++i) {
+                cpu->step();
+            }
+        };
+    }
+}
@@ -0,0 +1,58 @@
+#include "catch2/catch.hpp"
+
+#include "addressbus.hpp"
+#include "emulator.hpp"
+#include "emulatorlanes.hpp"
+#include "emulatorpool.hpp"
+#include "io.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+constexpr size_t NUM_LANES = 64;
+
+// Different keys for every lane and frame, like inputs chosen by a fuzzer.
+void choose_keys(std::vector<uint8_t>& keys, size_t frame) {
+    for (size_t lane = 0; lane < keys.size(); ++lane) {
+        keys[lane] = static_cast<uint8_t>((frame * 37 + lane * 11) % 256);
+    }
+}
+} // namespace
+
+// Both run on a single thread, so the time shows the work per frame of all lanes.
+TEST_CASE("Emulator lanes compared with an emulator pool", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    // 01-special doesn't read the joypad. Selecting the direction keys lets it observe them
+    // through the joypad interrupt.
+    const bool observed = GENERATE(false, true);
+    Emulator start{EmulatorOptions::headless()};
+    start.load_game(rom);
+    if (observed) {
+        start.get_bus()->write_byte(0xFF00, 0x20);
+    }
+    const auto initial_state = start.save_state();
+
+    std::vector<uint8_t> keys(NUM_LANES);
+    std::vector<uint8_t> observations(NUM_LANES * EmulatorPool::FRAME_SIZE);
+    SECTION(observed ? "Direction keys observed" : "Keys ignored") {
+        EmulatorLanes lanes{rom, initial_state, NUM_LANES};
+        EmulatorPool pool{rom, NUM_LANES, {.num_threads = 1, .pin_threads = false}};
+        for (size_t i = 0; i < NUM_LANES; ++i) {
+            pool.get_emulator(i).load_state(initial_state);
+        }
+        size_t frame = 0;
+        BENCHMARK("EmulatorLanes") {
+            choose_keys(keys, frame++);
+            return lanes.step_frame(keys);
+        };
+        BENCHMARK("EmulatorPool") {
+            choose_keys(keys, frame++);
+            return pool.step_frame(keys, observations);
+        };
+    }
+}
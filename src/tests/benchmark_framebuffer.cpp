@@ -0,0 +1,61 @@
+#include "catch2/catch.hpp"
+
+#include "constants.h"
+#include "framebuffer.hpp"
+#include "graphics.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+// Same type as the game framebuffer of the PPU
+using GameFramebuffer = Framebuffer<graphics::gb::ColorGb, constants::SCREEN_RES_WIDTH,
+                                    constants::SCREEN_RES_HEIGHT>;
+
+GameFramebuffer create_framebuffer() {
+    GameFramebuffer framebuffer;
+    for (size_t i = 0; i < framebuffer.size(); ++i) {
+        framebuffer.set_pixel(i, static_cast<graphics::gb::ColorGb>((i * 7 + i / 160) % 4));
+    }
+    return framebuffer;
+}
+} // namespace
+
+TEST_CASE("Framebuffer operations", "[benchmark]") {
+    const auto framebuffer = create_framebuffer();
+    auto other = framebuffer;
+
+    BENCHMARK("Hash") {
+        return framebuffer.hash();
+    };
+
+    BENCHMARK("Compare equal") {
+        return framebuffer == other;
+    };
+
+    std::vector<uint8_t> copy(framebuffer.size() * sizeof(graphics::gb::ColorGb));
+    BENCHMARK("Copy into buffer") {
+        framebuffer.copy_into(copy.data());
+        return copy[0];
+    };
+
+    BENCHMARK("Reset") {
+        other.reset();
+        return other.get_pixel(0);
+    };
+
+    BENCHMARK("Set every pixel") {
+        for (size_t y = 0; y < other.height(); ++y) {
+            for (size_t x = 0; x < other.width(); ++x) {
+                other.set_pixel(x, y, graphics::gb::ColorGb::Black);
+            }
+        }
+        return other.get_pixel(0);
+    };
+
+    std::vector<graphics::gb::ColorScreen> screen(framebuffer.size());
+    BENCHMARK("Map to screen colors") {
+        graphics::gb::map_to_screen_colors(framebuffer.pixels(), screen);
+        return screen[0];
+    };
+}
@@ -0,0 +1,53 @@
+#include "catch2/catch.hpp"
+
+#include "graphics.hpp"
+#include "memorymap.hpp"
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+namespace {
+// Random tile data and random offsets of tile lines in it, generated once with a fixed seed so
+// the runs are comparable.
+struct TileDecodeInput {
+    std::array<uint8_t, memmap::TileDataSize> tile_data{};
+    std::array<uint16_t, memmap::TileDataSize / 2> random_line_offsets{};
+
+    TileDecodeInput() {
+        std::mt19937 generator{42};
+        std::uniform_int_distribution<unsigned> byte_distribution{0, 255};
+        for (auto& byte : tile_data) {
+            byte = static_cast<uint8_t>(byte_distribution(generator));
+        }
+        std::uniform_int_distribution<unsigned> line_distribution{0, tile_data.size() / 2 - 1};
+        for (auto& offset : random_line_offsets) {
+            offset = static_cast<uint16_t>(line_distribution(generator) * 2);
+        }
+    }
+};
+} // namespace
+
+TEST_CASE("Tile line decoding", "[benchmark]") {
+    static const TileDecodeInput input;
+
+    BENCHMARK("Sequential tile lines") {
+        // Combine the results so the decoding is not optimized away
+        unsigned checksum = 0;
+        for (size_t i = 0; i < input.tile_data.size(); i += 2) {
+            auto line = graphics::gb::convert_tile_line(input.tile_data[i], input.tile_data[i + 1]);
+            checksum += static_cast<unsigned>(line[i % 8]);
+        }
+        return checksum;
+    };
+
+    BENCHMARK("Random tile lines") {
+        unsigned checksum = 0;
+        for (auto offset : input.random_line_offsets) {
+            auto line = graphics::gb::convert_tile_line(input.tile_data[offset],
+                                                        input.tile_data[offset + 1]);
+            checksum += static_cast<unsigned>(line[offset % 8]);
+        }
+        return checksum;
+    };
+}
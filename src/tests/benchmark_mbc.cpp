@@ -0,0 +1,46 @@
+#include "catch2/catch.hpp"
+
+#include "emulator.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <filesystem>
+#include <string>
+
+namespace {
+// Run a mooneye test ROM until it signals the end of the test
+void run_test_rom(const std::string& rom_name, bool use_mapped_banks) {
+    Emulator emulator{{.stub_ly_value = 0xFF, .use_mapped_banks = use_mapped_banks}};
+    auto test_ended = false;
+    emulator.set_debug_function([&test_ended] { test_ended = true; });
+    emulator.load_game(std::filesystem::absolute("roms/mts/mbc1/" + rom_name));
+    // Checked once after the loop, asserting on every step would be part of the measurement.
+    auto success = true;
+    while (success && !test_ended) {
+        success = emulator.step();
+    }
+    REQUIRE(success);
+}
+} // namespace
+
+TEST_CASE("MBC1 bank switching", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    const auto use_mapped_banks = GENERATE(true, false);
+    const std::string suffix = use_mapped_banks ? " (mapped banks)" : " (MBC reads)";
+    // These test ROMs switch banks continuously to check which bank is mapped
+    BENCHMARK("bits_bank1" + suffix) {
+        run_test_rom("bits_bank1.gb", use_mapped_banks);
+    };
+    BENCHMARK("bits_bank2" + suffix) {
+        run_test_rom("bits_bank2.gb", use_mapped_banks);
+    };
+    BENCHMARK("bits_mode" + suffix) {
+        run_test_rom("bits_mode.gb", use_mapped_banks);
+    };
+    BENCHMARK("rom_16Mb" + suffix) {
+        run_test_rom("rom_16Mb.gb", use_mapped_banks);
+    };
+    BENCHMARK("ram_256kb" + suffix) {
+        run_test_rom("ram_256kb.gb", use_mapped_banks);
+    };
+}
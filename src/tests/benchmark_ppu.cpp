@@ -0,0 +1,100 @@
+#include "catch2/catch.hpp"
+
+#include "emulator.hpp"
+#include "ppu.hpp"
+#include "constants.h"
+
+#include "spdlog/spdlog.h"
+
+#include <array>
+#include <cstdint>
+
+namespace {
+// Duration of one frame in M cycles (154 scanlines)
+constexpr size_t CYCLES_PER_FRAME = 154 * 114;
+
+// Fill VRAM with varying tiles and tile indices so every tile of a line is different.
+void fill_vram(Ppu& ppu) {
+    for (unsigned address = 0x8000; address < 0x9800; ++address) {
+        ppu.write_byte(static_cast<uint16_t>(address), static_cast<uint8_t>(address * 37 + 11));
+    }
+    for (unsigned address = 0x9800; address < 0xA000; ++address) {
+        ppu.write_byte(static_cast<uint16_t>(address), static_cast<uint8_t>(address * 7));
+    }
+}
+
+// Place num_sprites 8x16 sprites in bands of 10, the maximum number of sprites per line. The
+// sprites of a band overlap horizontally and bands do not overlap, remaining sprites are hidden.
+void place_sprites(Ppu& ppu, size_t num_sprites) {
+    constexpr size_t MAX_SPRITES_PER_LINE = 10;
+    for (size_t i = 0; i < 40; ++i) {
+        const auto band = i / MAX_SPRITES_PER_LINE;
+        const auto y = i < num_sprites ? 32 + band * 32 : 0;
+        const auto x = 8 + (i % MAX_SPRITES_PER_LINE) * 12 + band * 3;
+        // Alternate palettes and put every fourth sprite behind the background
+        const auto flags = (i % 2) << 4 | (i % 4 == 3 ? 0x80 : 0);
+        const std::array<size_t, 4> entry{y, x, i * 2, flags};
+        for (size_t byte = 0; byte < entry.size(); ++byte) {
+            ppu.write_byte(static_cast<uint16_t>(0xFE00 + i * 4 + byte),
+                           static_cast<uint8_t>(entry[byte]));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("PPU rendering", "[benchmark]") {
+    spdlog::set_level(spdlog::level::err);
+    Emulator emulator{{}};
+    emulator.load_game("roms/dmg-acid2.gb");
+    auto ppu = emulator.get_ppu();
+    fill_vram(*ppu);
+    // Fine scroll, so the line is not aligned to the tile grid
+    ppu->write_byte(0xFF42, 3);
+    ppu->write_byte(0xFF43, 5);
+    ppu->write_byte(0xFF4A, 40);
+    ppu->write_byte(0xFF4B, 60);
+
+    SECTION("Timing only") {
+        // LCD on, but background/window and sprites off. This is the baseline cost of the PPU
+        // state machine, the difference to the other sections is the rendering cost.
+        ppu->write_byte(0xFF40, 0b1000'0000);
+        BENCHMARK("Frame (144 scanlines)") {
+            for (size_t i = 0; i < CYCLES_PER_FRAME; ++i) {
+                ppu->cycle_elapsed_callback(i);
+            }
+        };
+    }
+
+    SECTION("Background") {
+        // LCD and background on
+        ppu->write_byte(0xFF40, 0b1001'0001);
+        BENCHMARK("Frame (144 scanlines)") {
+            for (size_t i = 0; i < CYCLES_PER_FRAME; ++i) {
+                ppu->cycle_elapsed_callback(i);
+            }
+        };
+    }
+
+    SECTION("Background and window") {
+        // LCD, background and window on
+        ppu->write_byte(0xFF40, 0b1011'0001);
+        BENCHMARK("Frame (144 scanlines)") {
+            for (size_t i = 0; i < CYCLES_PER_FRAME; ++i) {
+                ppu->cycle_elapsed_callback(i);
+            }
+        };
+    }
+
+    for (const size_t num_sprites : {10u, 40u}) {
+        DYNAMIC_SECTION("Background and " << num_sprites << " sprites") {
+            place_sprites(*ppu, num_sprites);
+            // LCD, background and 8x16 sprites on
+            ppu->write_byte(0xFF40, 0b1000'0111);
+            BENCHMARK("Frame (144 scanlines)") {
+                for (size_t i = 0; i < CYCLES_PER_FRAME; ++i) {
+                    ppu->cycle_elapsed_callback(i);
+                }
+            };
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
+#include <catch2/catch.hpp>
+
+#include "fmt/format.h"
+
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::string escape_json(std::string_view text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// JSON has no NaN or infinity, those are written as null.
+std::string format_json_number(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    return fmt::format("{}", value);
+}
+
+/*
+ * Writes the results of all benchmarks as one JSON document when the run ends, so results of
+ * different versions can be compared by tools. Select it with "-r json", times are in nanoseconds.
+ */
+class JsonReporter : public Catch::StreamingReporterBase<JsonReporter> {
+    struct Result {
+        std::string test_case;
+        std::string section;
+        std::string name;
+        Catch::BenchmarkStats<> stats;
+    };
+    std::vector<Result> m_results;
+
+public:
+    using StreamingReporterBase::StreamingReporterBase;
+
+    static std::string getDescription() {
+        return "Reports benchmark results as JSON";
+    }
+
+    void assertionStarting(const Catch::AssertionInfo& /*unused*/) override {}
+
+    bool assertionEnded(const Catch::AssertionStats& /*unused*/) override {
+        return true;
+    }
+
+    void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+        // The first section is the test case itself
+        std::string section;
+        for (size_t i = 1; i < m_sectionStack.size(); ++i) {
+            section += (i > 1 ? "/" : "") + m_sectionStack[i].name;
+        }
+        m_results.push_back({currentTestCaseInfo->name, section, stats.info.name, stats});
+    }
+
+    void testRunEnded(const Catch::TestRunStats& stats) override {
+        stream << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            const auto& result = m_results[i];
+            const auto& mean = result.stats.mean;
+            stream << (i == 0 ? "\n" : ",\n")
+                   << fmt::format(
+                          "    {{\"test_case\": \"{}\", \"section\": \"{}\", \"name\": \"{}\", "
+                          "\"mean_ns\": {}, \"mean_lower_bound_ns\": {}, "
+                          "\"mean_upper_bound_ns\": {}, \"standard_deviation_ns\": {}, "
+                          "\"samples\": {}, \"iterations\": {}}}",
+                          escape_json(result.test_case), escape_json(result.section),
+                          escape_json(result.name), format_json_number(mean.point.count()),
+                          format_json_number(mean.lower_bound.count()),
+                          format_json_number(mean.upper_bound.count()),
+                          format_json_number(result.stats.standardDeviation.point.count()),
+                          result.stats.info.samples, result.stats.info.iterations);
+        }
+        stream << "\n  ],\n"
+               << fmt::format("  \"passed\": {}\n}}\n", stats.totals.testCases.allPassed());
+        StreamingReporterBase::testRunEnded(stats);
+    }
+};
+} // namespace
+
+CATCH_REGISTER_REPORTER("json", JsonReporter)
@@ -0,0 +1,128 @@
+#include "catch2/catch.hpp"
+
+#include "addressbus.hpp"
+#include "apu.hpp"
+#include "emulator.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace {
+constexpr uint16_t DIV = 0xFF04;
+constexpr uint16_t NR21 = 0xFF16;
+constexpr uint16_t NR22 = 0xFF17;
+constexpr uint16_t NR24 = 0xFF19;
+constexpr uint16_t NR52 = 0xFF26;
+
+bool is_channel2_enabled(const Emulator& emulator) {
+    return (emulator.get_bus()->read_byte(NR52) & 0b10) != 0;
+}
+
+// Trigger all four channels without length counter on both outputs. The pulse and wave channels
+// use the given wavelength, the noise channel a fast clock.
+void play_all_channels(AddressBus& bus, uint16_t wavelength) {
+    bus.write_byte(NR52, 0x80);
+    bus.write_byte(0xFF25, 0xFF);
+    bus.write_byte(0xFF24, 0x77);
+    const auto low = static_cast<uint8_t>(wavelength & 0xFF);
+    const auto high = static_cast<uint8_t>(0x80 | (wavelength >> 8));
+    for (const uint16_t base : {0xFF10, 0xFF15}) {
+        bus.write_byte(static_cast<uint16_t>(base + 1), 0x80);
+        bus.write_byte(static_cast<uint16_t>(base + 2), 0xF3);
+        bus.write_byte(static_cast<uint16_t>(base + 3), low);
+        bus.write_byte(static_cast<uint16_t>(base + 4), high);
+    }
+    for (uint16_t address = 0xFF30; address <= 0xFF3F; ++address) {
+        bus.write_byte(address, static_cast<uint8_t>(address * 37));
+    }
+    bus.write_byte(0xFF1A, 0x80);
+    bus.write_byte(0xFF1C, 0x20);
+    bus.write_byte(0xFF1D, low);
+    bus.write_byte(0xFF1E, high);
+    bus.write_byte(0xFF21, 0xF1);
+    bus.write_byte(0xFF22, 0x21);
+    bus.write_byte(0xFF23, 0x80);
+}
+
+// Step until bit 4 of DIV is set. Coming from DIV 0, no falling edge happens on the way.
+void run_until_div_bit4_set(Emulator& emulator) {
+    while ((emulator.get_bus()->read_byte(DIV) & 0x10) == 0) {
+        REQUIRE(emulator.step());
+    }
+}
+} // namespace
+
+TEST_CASE("Writing DIV while bit 4 is set clocks the frame sequencer") {
+    spdlog::set_level(spdlog::level::err);
+    // dmg-acid2 does not use the APU itself
+    Emulator emulator{EmulatorOptions::headless()};
+    emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    auto bus = emulator.get_bus();
+    bus->write_byte(NR52, 0x80);
+    // Channel 2 with length enabled is turned off by the next length clock
+    auto trigger_channel2 = [&bus]() {
+        bus->write_byte(NR22, 0xF0);
+        bus->write_byte(NR21, 63);
+        bus->write_byte(NR24, 0xC0);
+    };
+    // Only DIV writes cause falling edges of bit 4, the regular increments only make it rise.
+    auto write_div_on_falling_edge = [&]() {
+        run_until_div_bit4_set(emulator);
+        bus->write_byte(DIV, 0);
+    };
+    bus->write_byte(DIV, 0);
+
+    // The length is clocked on every other step. After the step which turned the channel off, the
+    // next step doesn't clock the length and the one after it does.
+    trigger_channel2();
+    write_div_on_falling_edge();
+    if (is_channel2_enabled(emulator)) {
+        write_div_on_falling_edge();
+    }
+    REQUIRE_FALSE(is_channel2_enabled(emulator));
+
+    trigger_channel2();
+    write_div_on_falling_edge();
+    CHECK(is_channel2_enabled(emulator));
+    // Bit 4 of DIV stays clear, so these writes don't clock the frame sequencer.
+    for (int i = 0; i < 100; ++i) {
+        bus->write_byte(DIV, 0);
+    }
+    CHECK(is_channel2_enabled(emulator));
+    write_div_on_falling_edge();
+    CHECK_FALSE(is_channel2_enabled(emulator));
+}
+
+TEST_CASE("Samples generated in batches match sampling every cycle") {
+    spdlog::set_level(spdlog::level::err);
+    auto run = [](bool lazy_audio_channels) {
+        auto options = EmulatorOptions::reference();
+        options.sound_enabled = true;
+        options.lazy_audio_channels = lazy_audio_channels;
+        Emulator emulator{options};
+        emulator.set_audio_buffer_enabled(true);
+        // dmg-acid2 does not use the APU itself
+        emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+        std::vector<SampleFrame> samples;
+        // Envelopes and sweeps change the output between the writes
+        for (const uint16_t wavelength : {0, 1500, 2000, 2047}) {
+            play_all_channels(*emulator.get_bus(), wavelength);
+            REQUIRE(emulator.run_frames(3));
+            const auto buffer = emulator.get_audio_buffer();
+            samples.insert(samples.end(), buffer.begin(), buffer.end());
+            emulator.clear_audio_buffer();
+        }
+        return samples;
+    };
+    const auto expected = run(false);
+    const auto samples = run(true);
+    REQUIRE(samples.size() == expected.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        INFO("Sample " << i);
+        REQUIRE(samples[i].left == expected[i].left);
+        REQUIRE(samples[i].right == expected[i].right);
+    }
+}
@@ -0,0 +1,101 @@
+#include "batteryram.hpp"
+#include "mbc5.hpp"
+#include "test_helpers.hpp"
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+constexpr size_t RAM_SIZE = 8 * 1024;
+
+std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+} // namespace
+
+TEST_CASE("Battery RAM writes submitted pages to the file", "[batteryram]") {
+    const TemporaryFile file("game.gb.ram");
+    const auto& path = file.get_path();
+    const bool atomic_save = GENERATE(false, true);
+    {
+        const BatteryRam::Options options{.flush_interval = std::chrono::milliseconds(0),
+                                          .atomic_save = atomic_save};
+        BatteryRam ram(path, RAM_SIZE, options);
+        CHECK(std::ranges::all_of(ram.get_data(), [](auto b) { return b == 0; }));
+        CHECK_FALSE(std::filesystem::exists(path));
+
+        ram.get_data()[0x10] = 1;
+        ram.get_data()[0x1FFF] = 2;
+        // Pages 0 and 31
+        const std::vector<uint64_t> dirty_pages{0b1 | (uint64_t{1} << 31)};
+        ram.submit(dirty_pages);
+        ram.wait_until_written();
+        auto content = read_file(path);
+        REQUIRE(content.size() == RAM_SIZE);
+        CHECK(content[0x10] == 1);
+        CHECK(content[0x1FFF] == 2);
+
+        // Only the submitted pages end up in the file
+        ram.get_data()[0x100] = 3;
+        ram.get_data()[0x200] = 4;
+        ram.submit(std::vector<uint64_t>{0b100});
+        ram.wait_until_written();
+        content = read_file(path);
+        CHECK(content[0x100] == 0);
+        CHECK(content[0x200] == 4);
+    }
+    BatteryRam reloaded(path, RAM_SIZE, {});
+    CHECK(reloaded.get_data()[0x10] == 1);
+    CHECK(reloaded.get_data()[0x200] == 4);
+    CHECK(reloaded.get_data()[0x1FFF] == 2);
+    CHECK_FALSE(std::filesystem::exists(std::filesystem::path(path) += ".tmp"));
+}
+
+TEST_CASE("Battery RAM writes pending pages on destruction", "[batteryram]") {
+    const TemporaryFile file("game.gb.ram");
+    const auto& path = file.get_path();
+    {
+        BatteryRam ram(path, RAM_SIZE, {});
+        ram.get_data()[0x300] = 5;
+        ram.submit(std::vector<uint64_t>{0b1000});
+    }
+    CHECK(read_file(path)[0x300] == 5);
+}
+
+TEST_CASE("Battery RAM flush interval", "[batteryram]") {
+    const TemporaryFile file("game.gb.ram");
+    const auto& path = file.get_path();
+    BatteryRam ram(path, RAM_SIZE, {.flush_interval = std::chrono::hours(1)});
+    CHECK_FALSE(ram.is_flush_due());
+    BatteryRam unlimited(path, RAM_SIZE, {.flush_interval = std::chrono::milliseconds(0)});
+    CHECK(unlimited.is_flush_due());
+}
+
+TEST_CASE("MBC tracks written RAM pages", "[batteryram]") {
+    std::vector<uint8_t> rom(32 * 1024, 0);
+    // 8 KB of RAM
+    rom[0x149] = 2;
+    std::vector<uint8_t> ram(RAM_SIZE, 0);
+    Mbc5 mbc(rom, ram);
+    CHECK_FALSE(mbc.is_ram_dirty());
+
+    // Enable RAM
+    mbc.write_byte(0x0000, 0x0A);
+    mbc.write_byte(0xA000, 1);
+    mbc.write_byte(0xA000 + (3 * Mbc::RAM_PAGE_SIZE) + 1, 2);
+    CHECK(mbc.is_ram_dirty());
+    CHECK(ram[0] == 1);
+    REQUIRE(mbc.get_dirty_ram_pages().size() == 1);
+    CHECK(mbc.get_dirty_ram_pages()[0] == 0b1001);
+
+    mbc.clear_dirty_ram_pages();
+    CHECK_FALSE(mbc.is_ram_dirty());
+    CHECK(mbc.get_dirty_ram_pages()[0] == 0);
+}
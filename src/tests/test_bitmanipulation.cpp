@@ -185,4 +185,15 @@ TEST_CASE("Bit masking") {
     CHECK(bitmanip::mask(0xAC, 8) == 0xAC);
 
     CHECK(bitmanip::mask(0xAC, 4) == 0xC);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Reverse bits") {
+    CHECK(bitmanip::reverse_bits(0b00000000) == 0b00000000);
+    CHECK(bitmanip::reverse_bits(0b11000001) == 0b10000011);
+    CHECK(bitmanip::reverse_bits(0b00010000) == 0b00001000);
+    CHECK(bitmanip::reverse_bits(0b11111111) == 0b11111111);
+    for (unsigned x = 0; x < 256; ++x) {
+        const auto value = static_cast<uint8_t>(x);
+        CHECK(bitmanip::reverse_bits(bitmanip::reverse_bits(value)) == value);
+    }
+}
@@ -1,9 +1,8 @@
 #include "catch2/catch.hpp"
 
+#include "cputrace.hpp"
 #include "emulator.hpp"
 
-#include "test_helpers.hpp"
-
 #include "spdlog/spdlog.h"
 
 #include <filesystem>
@@ -11,8 +10,8 @@
 
 TEST_CASE("Compare boot sequence") {
     spdlog::set_level(spdlog::level::err);
-    auto expected_output = read_log_file("recorded-logs/BootromLog.txt");
-    REQUIRE_FALSE(expected_output.empty());
+    CpuTraceComparator comparator{"recorded-logs/BootromLog.txt"};
+    REQUIRE_FALSE(comparator.is_reference_finished());
     auto boot_rom_path = std::filesystem::absolute("roms/dmg_boot.gb");
     auto game_rom_path = std::filesystem::absolute("roms/stub-game.gb");
     // clang-format off
@@ -41,10 +40,10 @@ TEST_CASE("Compare boot sequence") {
     // clang-format on
     Emulator emulator{{.stub_ly_value = 0x90}};
     emulator.load_boot_game(boot_rom_path, game_rom_path);
-    for (auto i = 0; const auto& expected_line : expected_output) {
-        auto actual_output = emulator.get_debug_state();
-        ++i;
-        REQUIRE(actual_output == expected_line);
+    while (!comparator.is_reference_finished()) {
+        const bool matches = comparator.compare(emulator.get_debug_state());
+        INFO(comparator.get_report());
+        REQUIRE(matches);
         REQUIRE(emulator.step());
     }
 }
\ No newline at end of file
@@ -2,13 +2,22 @@
 #include <catch2/catch.hpp>
 
 #include "io.hpp"
+#include "exceptions.hpp"
+#include "memorymappedfile.hpp"
+#include "romcache.hpp"
+#include "mbc5.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
 
 
 TEST_CASE("Test reading empty game title from cartridge", "[cartridge]") {
     EmulatorIo io;
     auto rom_path = std::filesystem::absolute("roms/stub-game.gb");
     auto rom = io.load_rom_file(rom_path);
-    auto title = cartridge::get_title(rom.value());
+    auto title = cartridge::get_title(*rom);
     REQUIRE(title.size() == 0);
 }
 
@@ -16,7 +25,7 @@ TEST_CASE("Test reading valid game title from cartridge", "[cartridge]") {
     EmulatorIo io;
     auto rom_path = std::filesystem::absolute("roms/stub-game-normal-title.gb");
     auto rom = io.load_rom_file(rom_path);
-    auto title = cartridge::get_title(rom.value());
+    auto title = cartridge::get_title(*rom);
     REQUIRE(title == "My Game Title2!");
 }
 
@@ -24,6 +33,57 @@ TEST_CASE("Test title being truncated to 16 characters", "[cartridge]") {
     EmulatorIo io;
     auto rom_path = std::filesystem::absolute("roms/stub-game-long-title.gb");
     auto rom = io.load_rom_file(rom_path);
-    auto title = cartridge::get_title(rom.value());
+    auto title = cartridge::get_title(*rom);
     REQUIRE(title == "My Game Title2!i");
 }
+
+TEST_CASE("ROM files are mapped once and shared", "[cartridge]") {
+    auto rom_path = std::filesystem::absolute("roms/stub-game-normal-title.gb");
+    auto& cache = RomCache::instance();
+    auto rom = cache.open(rom_path);
+    // Different paths to the same file use the same mapping
+    auto same_rom = cache.open(std::filesystem::path("roms/../roms/stub-game-normal-title.gb"));
+    CHECK(rom == same_rom);
+    CHECK(rom->get_data().data() == same_rom->get_data().data());
+
+    EmulatorIo io;
+    auto rom_bytes = io.load_rom_file(rom_path);
+        CHECK(std::ranges::equal(rom->get_data(), *rom_bytes));
+
+    SECTION("ROMs are unmapped after the last user is gone") {
+        const auto num_mapped = cache.size();
+        rom.reset();
+        same_rom.reset();
+        CHECK(cache.size() == num_mapped - 1);
+    }
+}
+
+TEST_CASE("Mapping a missing ROM file fails", "[cartridge]") {
+    CHECK_THROWS_AS(RomCache::instance().open("roms/does-not-exist.gb"), LoadError);
+}
+
+TEST_CASE("MBC banks are remapped by register writes", "[cartridge]") {
+    // 128 KB ROM with 8 banks and 32 KB RAM with 4 banks
+    std::vector<uint8_t> rom(128 * 1024, 0);
+    rom[0x148] = 2;
+    rom[0x149] = 3;
+    std::vector<uint8_t> ram(32 * 1024, 0);
+    Mbc5 mbc(rom, ram);
+    const auto& banks = mbc.get_mapped_banks();
+    CHECK(banks.rom_fixed == rom.data());
+    CHECK(banks.rom_switchable == rom.data() + 0x4000);
+    CHECK(banks.ram == nullptr);
+
+    mbc.write_byte(0x2000, 5);
+    CHECK(banks.rom_switchable == rom.data() + (5 * 0x4000));
+    // Bank numbers are masked to the size of the ROM
+    mbc.write_byte(0x2000, 13);
+    CHECK(banks.rom_switchable == rom.data() + (5 * 0x4000));
+
+    mbc.write_byte(0x4000, 2);
+    CHECK(banks.ram == nullptr);
+    mbc.write_byte(0x0000, 0x0A);
+    CHECK(banks.ram == ram.data() + (2 * 0x2000));
+    mbc.write_byte(0x0000, 0x00);
+    CHECK(banks.ram == nullptr);
+}
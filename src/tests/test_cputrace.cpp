@@ -0,0 +1,162 @@
+#include "catch2/catch.hpp"
+
+#include "cputrace.hpp"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "test_helpers.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+const std::filesystem::path& write_log(const TemporaryFile& log, const std::string& content) {
+    std::ofstream file{log.get_path(), std::ios::binary | std::ios::trunc};
+    file << content;
+    return log.get_path();
+}
+
+const CpuDebugState FIRST_STATE{.a = 0x01,
+                                .f = 0xB0,
+                                .b = 0x00,
+                                .c = 0x13,
+                                .d = 0x00,
+                                .e = 0xD8,
+                                .h = 0x01,
+                                .l = 0x4D,
+                                .sp = 0xFFFE,
+                                .pc = 0x0100,
+                                .mem_pc = {0x00, 0xC3, 0x13, 0x02}};
+const CpuDebugState SECOND_STATE{.a = 0xAB,
+                                 .f = 0xCD,
+                                 .b = 0xEF,
+                                 .c = 0x98,
+                                 .d = 0x76,
+                                 .e = 0x54,
+                                 .h = 0x32,
+                                 .l = 0x10,
+                                 .sp = 0xDFF0,
+                                 .pc = 0xC9A7,
+                                 .mem_pc = {0xFA, 0x5E, 0x0F, 0x9B}};
+} // namespace
+
+TEST_CASE("CPU log reader parses both log formats") {
+    CpuLogReader::Format format{};
+    std::string content;
+    SECTION("Debug state format with Windows line endings") {
+        format = CpuLogReader::Format::DebugState;
+        content = "A: 01 F: B0 B: 00 C: 13 D: 00 E: D8 H: 01 L: 4D SP: FFFE PC: 0100 "
+                  "(00 C3 13 02)\r\n"
+                  "A: ab F: CD B: eF C: 98 D: 76 E: 54 H: 32 L: 10 SP: DFF0 PC: c9a7 "
+                  "(FA 5E 0F 9B)";
+    }
+    SECTION("Gameboy Doctor format") {
+        format = CpuLogReader::Format::GameboyDoctor;
+        content = "A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02\n"
+                  "A:AB F:CD B:EF C:98 D:76 E:54 H:32 L:10 SP:DFF0 PC:C9A7 PCMEM:FA,5E,0F,9B\n";
+    }
+    const TemporaryFile log("cpu.log");
+    CpuLogReader reader{write_log(log, content)};
+    CHECK(reader.get_format() == format);
+    CpuDebugState state{};
+    REQUIRE(reader.next(state));
+    CHECK(state == FIRST_STATE);
+    CHECK(reader.get_line() == CpuLogReader::format_line(FIRST_STATE, format));
+    REQUIRE(reader.next(state));
+    CHECK(state == SECOND_STATE);
+    CHECK(reader.get_line_number() == 2);
+    CHECK(reader.at_end());
+    CHECK_FALSE(reader.next(state));
+}
+
+TEST_CASE("CPU log reader rejects invalid lines") {
+    CpuDebugState state{};
+    const TemporaryFile log("cpu.log");
+    SECTION("Invalid hex digit") {
+        CpuLogReader reader{write_log(log, "A: 01 F: B0 B: 00 C: 13 D: 00 E: D8 H: 01 L: 4D "
+                                           "SP: FFFE PC: 01G0 (00 C3 13 02)\n")};
+        CHECK_THROWS_AS(reader.next(state), LoadError);
+    }
+    SECTION("Truncated line") {
+        CpuLogReader reader{
+            write_log(log, "A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100\n")};
+        CHECK_THROWS_AS(reader.next(state), LoadError);
+    }
+    SECTION("Empty log") {
+        CpuLogReader reader{write_log(log, "")};
+        CHECK(reader.at_end());
+        CHECK_FALSE(reader.next(state));
+    }
+    CHECK_THROWS_AS(CpuLogReader("does-not-exist.log"), LoadError);
+}
+
+TEST_CASE("CPU trace comparator reports the first divergence with context") {
+    std::string content;
+    for (int i = 0; i < 4; ++i) {
+        content += CpuLogReader::format_line(FIRST_STATE, CpuLogReader::Format::GameboyDoctor);
+        content += '\n';
+    }
+    const TemporaryFile log("cpu.log");
+    CpuTraceComparator comparator{write_log(log, content), 2};
+    REQUIRE(comparator.compare(FIRST_STATE));
+    REQUIRE(comparator.compare(FIRST_STATE));
+    REQUIRE(comparator.compare(FIRST_STATE));
+    auto diverging_state = FIRST_STATE;
+    diverging_state.pc = 0x0101;
+    diverging_state.mem_pc[1] = 0;
+    CHECK_FALSE(comparator.compare(diverging_state));
+    CHECK(comparator.has_diverged());
+    CHECK(comparator.get_num_matched() == 3);
+    const auto& report = comparator.get_report();
+    INFO(report);
+    CHECK(report.starts_with("Divergence at instruction 3 (reference line 4) in PC memory at PC"));
+    CHECK(report.find("         2  A:01") != std::string::npos);
+    CHECK(report.find("         3  A:01") != std::string::npos);
+    CHECK(report.find("         1  A:01") == std::string::npos);
+    CHECK(report.find("actual  A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0101")
+          != std::string::npos);
+    // Only the first divergence is reported
+    CHECK_FALSE(comparator.compare(FIRST_STATE));
+}
+
+TEST_CASE("Binary CPU trace is compared with a reference log") {
+    spdlog::set_level(spdlog::level::err);
+    const TemporaryFile trace("cpu.trace");
+    const TemporaryFile log("cpu.log");
+    auto options = EmulatorOptions::headless();
+    options.cpu_trace_path = trace.get_path();
+    std::vector<CpuDebugState> states;
+    {
+        // The trace is complete once the emulator is destroyed
+        Emulator traced{options};
+        traced.load_game(std::filesystem::absolute("roms/01-special.gb"));
+        Emulator reference{EmulatorOptions::headless()};
+        reference.load_game(std::filesystem::absolute("roms/01-special.gb"));
+        for (int i = 0; i < 1000; ++i) {
+            states.push_back(reference.get_debug_state());
+            REQUIRE(reference.step());
+            REQUIRE(traced.step());
+        }
+    }
+    const auto format_log = [&states] {
+        std::string content;
+        for (const auto& state : states) {
+            content += CpuLogReader::format_line(state, CpuLogReader::Format::DebugState) + '\n';
+        }
+        return content;
+    };
+    const auto matching = compare_cpu_trace(trace.get_path(), write_log(log, format_log()));
+    CHECK(matching.matches);
+    CHECK(matching.num_matched == 1000);
+    CHECK(matching.report.empty());
+
+    // Change the A register in line 501
+    states[500].a ^= 1;
+    const auto diverging = compare_cpu_trace(trace.get_path(), write_log(log, format_log()));
+    CHECK_FALSE(diverging.matches);
+    CHECK(diverging.num_matched == 500);
+    CHECK(diverging.report.starts_with("Divergence at instruction 500 (reference line 501) in A"));
+}
@@ -0,0 +1,84 @@
+#include "debugviews.hpp"
+#include "ppu_registers.hpp"
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace {
+// Rendering happens on the worker thread, wait for it to finish.
+void wait_until(const std::function<bool()>& is_rendered) {
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!is_rendered() && std::chrono::steady_clock::now() < timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+} // namespace
+
+TEST_CASE("Debug views are only updated while visible") {
+    DebugViews debug_views;
+    CHECK_FALSE(debug_views.is_update_due(10.0));
+
+    debug_views.set_visible(DebugViews::View::TileData, true);
+    CHECK(debug_views.is_update_due(10.0));
+
+    DebugViews::Snapshot snapshot{{}, {}, PpuRegisters{-1}};
+    debug_views.update(snapshot);
+    // The refresh rate limits the updates
+    CHECK_FALSE(debug_views.is_update_due(1.0));
+}
+
+TEST_CASE("Debug views are rendered from the snapshot") {
+    DebugViews debug_views;
+    debug_views.set_visible(DebugViews::View::TileData, true);
+    DebugViews::Snapshot snapshot{{}, {}, PpuRegisters{-1}};
+    // First line of tile 0 with color 3
+    snapshot.tile_data[0] = 0xFF;
+    snapshot.tile_data[1] = 0xFF;
+    debug_views.update(snapshot);
+
+    auto is_rendered = [&debug_views] {
+        const auto lock = debug_views.lock();
+        const auto* views = debug_views.get_views();
+        return views != nullptr
+               && views->tile_data[0].get_pixel(0, 0) == graphics::gb::ColorGb::Black;
+    };
+    wait_until(is_rendered);
+    {
+        const auto lock = debug_views.lock();
+        const auto* views = debug_views.get_views();
+        REQUIRE(views != nullptr);
+        CHECK(views->tile_data[0].get_pixel(0, 0) == graphics::gb::ColorGb::Black);
+        CHECK(views->tile_data[0].get_pixel(0, 1) == graphics::gb::ColorGb::White);
+        // Every rendered snapshot makes a new generation of views available
+        CHECK(debug_views.get_generation() == 1);
+    }
+
+    SECTION("Framebuffers are released when no view is visible") {
+        CHECK(debug_views.get_allocated_memory() > 0);
+        debug_views.release_if_hidden();
+        CHECK(debug_views.get_allocated_memory() > 0);
+        debug_views.set_visible(DebugViews::View::TileData, false);
+        debug_views.release_if_hidden();
+        CHECK(debug_views.get_allocated_memory() == 0);
+        const auto lock = debug_views.lock();
+        CHECK(debug_views.get_views() == nullptr);
+    }
+
+    SECTION("Tiles changed by a later snapshot are decoded again") {
+        // Only the second line of tile 0 changes to color 1
+        snapshot.tile_data[2] = 0xFF;
+        debug_views.update(snapshot);
+        wait_until([&debug_views] {
+            const auto lock = debug_views.lock();
+            return debug_views.get_generation() == 2;
+        });
+        const auto lock = debug_views.lock();
+        REQUIRE(debug_views.get_generation() == 2);
+        const auto* views = debug_views.get_views();
+        CHECK(views->tile_data[0].get_pixel(0, 0) == graphics::gb::ColorGb::Black);
+        CHECK(views->tile_data[0].get_pixel(0, 1) == graphics::gb::ColorGb::LightGray);
+        CHECK(views->tile_data[0].get_pixel(0, 2) == graphics::gb::ColorGb::White);
+    }
+}
@@ -0,0 +1,106 @@
+#include "catch2/catch.hpp"
+
+#include "emulator.hpp"
+#include "emulatorlanes.hpp"
+#include "exceptions.hpp"
+#include "io.hpp"
+#include "joypad.hpp"
+#include "ppu.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+void run_frame(Emulator& emulator, uint8_t keys) {
+    emulator.get_joypad()->set_pressed_keys(keys);
+    REQUIRE(emulator.run_frames());
+}
+} // namespace
+
+TEST_CASE("Emulator lanes with the same keys share one emulator") {
+    spdlog::set_level(spdlog::level::err);
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    EmulatorLanes lanes{rom, {}, 8};
+    REQUIRE(lanes.size() == 8);
+    const std::vector<uint8_t> keys(lanes.size(), 0b0000'0100);
+    for (int frame = 0; frame < 10; ++frame) {
+        REQUIRE(lanes.step_frame(keys));
+        CHECK(lanes.get_num_groups() == 1);
+    }
+    CHECK_THROWS_AS(lanes.step_frame(std::vector<uint8_t>(3)), LogicError);
+}
+
+TEST_CASE("Emulator lanes run like independent emulators") {
+    spdlog::set_level(spdlog::level::err);
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    Emulator start{EmulatorOptions::headless()};
+    start.load_game(rom);
+    for (int frame = 0; frame < 20; ++frame) {
+        run_frame(start, 0);
+    }
+    // 01-special does not read the joypad. Select the direction keys, so pressing one of them
+    // requests an interrupt and the game observes them, while the action keys are ignored.
+    start.get_bus()->write_byte(0xFF00, 0x20);
+    const auto initial_state = start.save_state();
+
+    constexpr size_t NUM_LANES = 6;
+    EmulatorLanes lanes{rom, initial_state, NUM_LANES};
+    std::vector<std::unique_ptr<Emulator>> references;
+    for (size_t lane = 0; lane < NUM_LANES; ++lane) {
+        references.push_back(std::make_unique<Emulator>(EmulatorOptions::headless()));
+        references.back()->load_game(rom);
+        references.back()->load_state(initial_state);
+    }
+
+    constexpr uint8_t RIGHT = 0b0000'0001;
+    constexpr uint8_t LEFT = 0b0000'0010;
+    constexpr uint8_t A = 0b0001'0000;
+    constexpr uint8_t B = 0b0010'0000;
+    const std::vector<std::vector<uint8_t>> inputs{
+        // Action keys are not observed
+        {0, A, B, A | B, 0, A},
+        // Pressing a direction key requests the interrupt, which differs from not pressing one.
+        // Which key requested it is not observed.
+        {0, 0, RIGHT, RIGHT, LEFT, LEFT | A},
+        // Holding the keys doesn't request the interrupt again
+        {0, 0, RIGHT, RIGHT, LEFT, LEFT},
+        // The interrupt flag stays set, but releasing keys or changing action keys is not observed
+        {A, 0, 0, B, LEFT, 0},
+        {0, 0, 0, 0, 0, 0},
+    };
+    const std::vector<size_t> expected_groups{1, 2, 2, 2, 2};
+    for (size_t frame = 0; frame < inputs.size(); ++frame) {
+        REQUIRE(lanes.step_frame(inputs[frame]));
+        for (size_t lane = 0; lane < NUM_LANES; ++lane) {
+            run_frame(*references[lane], inputs[frame][lane]);
+            CHECK_FALSE(lanes.has_failed(lane));
+            REQUIRE(lanes.save_state(lane) == references[lane]->save_state());
+            REQUIRE(lanes.get_screen(lane) == references[lane]->get_ppu()->get_game());
+        }
+        CHECK(lanes.get_num_groups() == expected_groups[frame]);
+    }
+}
+
+TEST_CASE("Emulator lanes don't split for keys the game ignores") {
+    spdlog::set_level(spdlog::level::err);
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    constexpr size_t NUM_LANES = 16;
+    EmulatorLanes lanes{rom, {}, NUM_LANES};
+    Emulator reference{EmulatorOptions::headless()};
+    reference.load_game(rom);
+    std::vector<uint8_t> keys(NUM_LANES);
+    for (size_t frame = 0; frame < 10; ++frame) {
+        for (size_t lane = 0; lane < NUM_LANES; ++lane) {
+            keys[lane] = static_cast<uint8_t>((frame * 37 + lane * 11) % 256);
+        }
+        REQUIRE(lanes.step_frame(keys));
+        run_frame(reference, keys.back());
+        // No key type is selected, the game can't observe any key
+        CHECK(lanes.get_num_groups() == 1);
+    }
+    CHECK(lanes.save_state(NUM_LANES - 1) == reference.save_state());
+    CHECK(lanes.get_screen(0) == reference.get_ppu()->get_game());
+}
@@ -0,0 +1,73 @@
+#include "catch2/catch.hpp"
+
+#include "emulator.hpp"
+#include "emulatorpool.hpp"
+#include "exceptions.hpp"
+#include "joypad.hpp"
+#include "ppu.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+TEST_CASE("Emulator pool steps all instances like a single emulator") {
+    spdlog::set_level(spdlog::level::err);
+    constexpr size_t NUM_INSTANCES = 7;
+    const auto rom_path = std::filesystem::absolute("roms/01-special.gb");
+    EmulatorPool pool{rom_path, NUM_INSTANCES, {.num_threads = 3, .pin_threads = false}};
+    REQUIRE(pool.size() == NUM_INSTANCES);
+    CHECK(pool.get_num_threads() == 3);
+
+    Emulator reference{EmulatorOptions::headless()};
+    reference.load_game(rom_path);
+
+    std::vector<uint8_t> keys(NUM_INSTANCES, 0);
+    std::vector<uint8_t> observations(NUM_INSTANCES * EmulatorPool::FRAME_SIZE);
+    std::vector<uint8_t> expected(EmulatorPool::FRAME_SIZE);
+    for (size_t frame = 0; frame < 60; ++frame) {
+        REQUIRE(pool.step_frame(keys, observations));
+        REQUIRE(reference.run_frames());
+        reference.get_ppu()->get_game().copy_into(expected.data());
+        for (size_t i = 0; i < NUM_INSTANCES; ++i) {
+            const auto observation = std::span(observations).subspan(
+                i * EmulatorPool::FRAME_SIZE, EmulatorPool::FRAME_SIZE);
+            REQUIRE(std::ranges::equal(observation, expected));
+        }
+    }
+    for (size_t i = 0; i < NUM_INSTANCES; ++i) {
+        CHECK(pool.get_emulator(i).get_state().frame_count == 60);
+        CHECK_FALSE(pool.has_failed(i));
+    }
+}
+
+TEST_CASE("Emulator pool applies the keys of every instance") {
+    spdlog::set_level(spdlog::level::err);
+    EmulatorPool pool{std::filesystem::absolute("roms/01-special.gb"), 4, {.pin_threads = false}};
+    std::vector<uint8_t> keys{0b0000'0001, 0, 0b1000'0000, 0b1111'1111};
+    std::vector<uint8_t> observations(pool.size() * EmulatorPool::FRAME_SIZE);
+    REQUIRE(pool.step_frame(keys, observations));
+    for (size_t i = 0; i < pool.size(); ++i) {
+        const auto& joypad = *pool.get_emulator(i).get_joypad();
+        CHECK(joypad.is_pressed(Joypad::Keys::Right) == ((keys[i] & 0b0000'0001) != 0));
+        CHECK(joypad.is_pressed(Joypad::Keys::Start) == ((keys[i] & 0b1000'0000) != 0));
+    }
+}
+
+TEST_CASE("Emulator pool checks the size of the batches") {
+    spdlog::set_level(spdlog::level::err);
+    EmulatorPool pool{std::filesystem::absolute("roms/01-special.gb"), 2, {.pin_threads = false}};
+    std::vector<uint8_t> keys(2);
+    std::vector<uint8_t> observations(EmulatorPool::FRAME_SIZE);
+    CHECK_THROWS_AS(pool.step_frame(keys, observations), LogicError);
+}
+
+TEST_CASE("Emulator pool reports errors from creating instances") {
+    spdlog::set_level(spdlog::level::err);
+    auto invalid_rom = std::make_shared<const std::vector<uint8_t>>(0x100);
+    CHECK_THROWS_AS(EmulatorPool(invalid_rom, 3, {.pin_threads = false}), LogicError);
+}
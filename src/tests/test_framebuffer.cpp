@@ -69,4 +69,27 @@ TEST_CASE("Wrapped pixel access") {
         fb.set_pixel_wraparound(-9, 1, 99);
         CHECK(fb.get_pixel(3, 1) == 99);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Content hash") {
+    // 15 bytes, so the hash covers full words and a remainder
+    Framebuffer<uint8_t, 5, 3> fb{};
+    Framebuffer<uint8_t, 5, 3> other{};
+    CHECK(fb.hash() == other.hash());
+
+    SECTION("Changed pixel in the first word") {
+        other.set_pixel(1, 0, 1);
+        CHECK(fb.hash() != other.hash());
+    }
+
+    SECTION("Changed pixel in the remainder") {
+        other.set_pixel(4, 2, 1);
+        CHECK(fb.hash() != other.hash());
+    }
+
+    SECTION("Same content after change") {
+        other.set_pixel(2, 1, 3);
+        fb.set_pixel(2, 1, 3);
+        CHECK(fb.hash() == other.hash());
+    }
+}
@@ -0,0 +1,58 @@
+#include "framepacer.hpp"
+#include <catch2/catch.hpp>
+
+#include <chrono>
+
+
+TEST_CASE("Frame pacer accumulates deadlines without rounding errors") {
+    FramePacer pacer;
+    const auto start = pacer.get_next_frame_time();
+    // 16 frames take 16 * 70224 / 4194304 s = 267883300.78 ns
+    for (int i = 0; i < 16; ++i) {
+        pacer.advance_deadline(1);
+    }
+    CHECK(pacer.get_next_frame_time() - start == std::chrono::nanoseconds(267'883'300));
+}
+
+TEST_CASE("Frame pacer deadlines don't drift over many frames") {
+    FramePacer pacer;
+    const auto start = pacer.get_next_frame_time();
+    const int speed = GENERATE(1, 4);
+    for (int i = 0; i < 100'000; ++i) {
+        pacer.advance_deadline(speed);
+    }
+    // The exact duration of 100000 frames rounded down to whole nanoseconds
+    const auto expected = speed == 1 ? std::chrono::nanoseconds(1'674'270'629'882)
+                                     : std::chrono::nanoseconds(418'567'657'470);
+    CHECK(pacer.get_next_frame_time() - start == expected);
+}
+
+TEST_CASE("Frame pacer drops the remainder when the speed changes") {
+    FramePacer pacer;
+    const auto start = pacer.get_next_frame_time();
+    // One frame at speed 1 is 16742706.29 ns, at speed 3 it is 5580902.09 ns.
+    pacer.advance_deadline(1);
+    CHECK(pacer.get_next_frame_time() - start == std::chrono::nanoseconds(16'742'706));
+    for (int i = 0; i < 3; ++i) {
+        pacer.advance_deadline(3);
+    }
+    CHECK(pacer.get_next_frame_time() - start
+          == std::chrono::nanoseconds(16'742'706 + 16'742'706));
+    // Speeds below 1 are treated as 1
+    pacer.advance_deadline(0);
+    CHECK(pacer.get_next_frame_time() - start
+          == std::chrono::nanoseconds(16'742'706 + 16'742'706 + 16'742'706));
+}
+
+TEST_CASE("Frame pacer waits until the deadline") {
+    FramePacer pacer;
+    constexpr int NUM_FRAMES = 3;
+    pacer.reset();
+    const auto start = FramePacer::Clock::now();
+    for (int i = 0; i < NUM_FRAMES; ++i) {
+        pacer.wait_for_next_frame(1);
+    }
+    // Only a lower bound, falling behind restarts pacing later and never earlier.
+    const auto elapsed = FramePacer::Clock::now() - start;
+    CHECK(elapsed >= std::chrono::nanoseconds(NUM_FRAMES * 16'742'706));
+}
@@ -0,0 +1,129 @@
+#include "catch2/catch.hpp"
+
+#include "gbemu.h"
+#include "io.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+using Instance = std::unique_ptr<gbemu, decltype(&gbemu_destroy)>;
+
+Instance create_instance() {
+    Instance emu{gbemu_create(), &gbemu_destroy};
+    REQUIRE(emu != nullptr);
+    return emu;
+}
+
+Instance create_instance_with_rom() {
+    auto emu = create_instance();
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    REQUIRE(gbemu_load_rom(emu.get(), rom->data(), rom->size()) == GBEMU_OK);
+    return emu;
+}
+
+std::vector<uint8_t> copy_framebuffer(const gbemu* emu) {
+    const auto* pixels = gbemu_get_framebuffer(emu);
+    REQUIRE(pixels != nullptr);
+    return {pixels, pixels + GBEMU_SCREEN_WIDTH * GBEMU_SCREEN_HEIGHT};
+}
+
+std::vector<uint8_t> copy_state(gbemu* emu) {
+    size_t size = 0;
+    const auto* state = gbemu_save_state(emu, &size);
+    REQUIRE(state != nullptr);
+    return {state, state + size};
+}
+} // namespace
+
+TEST_CASE("C API reports errors without a ROM") {
+    spdlog::set_level(spdlog::level::err);
+    auto emu = create_instance();
+    CHECK(gbemu_get_framebuffer(emu.get()) == nullptr);
+    CHECK(gbemu_run_frames(emu.get(), 1) == GBEMU_ERROR);
+    CHECK(std::string(gbemu_get_last_error(emu.get())) == "No ROM loaded");
+    const std::vector<uint8_t> too_small(0x100);
+    CHECK(gbemu_load_rom(emu.get(), too_small.data(), too_small.size()) == GBEMU_ERROR);
+    CHECK_FALSE(std::string(gbemu_get_last_error(emu.get())).empty());
+}
+
+TEST_CASE("C API runs frames of a ROM loaded from memory") {
+    spdlog::set_level(spdlog::level::err);
+    auto emu = create_instance_with_rom();
+    REQUIRE(gbemu_run_frames(emu.get(), 10) == GBEMU_OK);
+    CHECK(gbemu_get_frame_count(emu.get()) == 10);
+    CHECK(std::string(gbemu_get_last_error(emu.get())).empty());
+
+    size_t num_samples = 1;
+    gbemu_get_audio(emu.get(), &num_samples);
+    CHECK(num_samples == 0);
+
+    SECTION("Audio samples of the last run are buffered") {
+        REQUIRE(gbemu_set_audio_enabled(emu.get(), 1) == GBEMU_OK);
+        REQUIRE(gbemu_run_frames(emu.get(), 2) == GBEMU_OK);
+        const auto* samples = gbemu_get_audio(emu.get(), &num_samples);
+        CHECK(samples != nullptr);
+        // One sample per M cycle, runs end on the first instruction boundary after VBlank.
+        constexpr size_t CYCLES_PER_FRAME = 17556;
+        CHECK(num_samples >= 2 * CYCLES_PER_FRAME - 6);
+        CHECK(num_samples <= 2 * CYCLES_PER_FRAME + 6);
+    }
+
+    SECTION("The framebuffer pointer stays valid") {
+        const auto* pixels = gbemu_get_framebuffer(emu.get());
+        REQUIRE(gbemu_run_frames(emu.get(), 1) == GBEMU_OK);
+        CHECK(gbemu_get_framebuffer(emu.get()) == pixels);
+    }
+}
+
+TEST_CASE("C API save states restore the emulation exactly") {
+    spdlog::set_level(spdlog::level::err);
+    auto emu = create_instance_with_rom();
+    REQUIRE(gbemu_set_audio_enabled(emu.get(), 1) == GBEMU_OK);
+    REQUIRE(gbemu_run_frames(emu.get(), 30) == GBEMU_OK);
+    const auto state = copy_state(emu.get());
+
+    REQUIRE(gbemu_run_frames(emu.get(), 90) == GBEMU_OK);
+    const auto expected_frame = copy_framebuffer(emu.get());
+    size_t num_samples = 0;
+    const auto* samples = gbemu_get_audio(emu.get(), &num_samples);
+    const std::vector<gbemu_sample> expected_audio(samples, samples + num_samples);
+
+    REQUIRE(gbemu_load_state(emu.get(), state.data(), state.size()) == GBEMU_OK);
+    CHECK(gbemu_get_frame_count(emu.get()) == 30);
+    CHECK(copy_state(emu.get()) == state);
+    REQUIRE(gbemu_run_frames(emu.get(), 90) == GBEMU_OK);
+    CHECK(copy_framebuffer(emu.get()) == expected_frame);
+    samples = gbemu_get_audio(emu.get(), &num_samples);
+    REQUIRE(num_samples == expected_audio.size());
+    CHECK(std::memcmp(samples, expected_audio.data(), num_samples * sizeof(gbemu_sample)) == 0);
+}
+
+TEST_CASE("C API rejects invalid save states") {
+    spdlog::set_level(spdlog::level::err);
+    auto emu = create_instance_with_rom();
+    REQUIRE(gbemu_run_frames(emu.get(), 5) == GBEMU_OK);
+    const auto state = copy_state(emu.get());
+
+    SECTION("Truncated state") {
+        CHECK(gbemu_load_state(emu.get(), state.data(), state.size() - 1) == GBEMU_ERROR);
+    }
+    SECTION("State with trailing data") {
+        auto longer_state = state;
+        longer_state.push_back(0);
+        CHECK(gbemu_load_state(emu.get(), longer_state.data(), longer_state.size())
+              == GBEMU_ERROR);
+    }
+    SECTION("Not a state") {
+        const std::vector<uint8_t> garbage(state.size(), 0xAB);
+        CHECK(gbemu_load_state(emu.get(), garbage.data(), garbage.size()) == GBEMU_ERROR);
+    }
+    CHECK_FALSE(std::string(gbemu_get_last_error(emu.get())).empty());
+    // A failed load leaves the emulator unchanged
+    CHECK(copy_state(emu.get()) == state);
+}
@@ -24,6 +24,21 @@ TEST_CASE("Tile conversion2") {
     CHECK(result == expected_result);
 }
 
+TEST_CASE("Tile conversion of all byte combinations") {
+    for (unsigned byte1 = 0; byte1 < 256; ++byte1) {
+        for (unsigned byte2 = 0; byte2 < 256; ++byte2) {
+            auto result = graphics::gb::convert_tile_line(static_cast<uint8_t>(byte1),
+                                                          static_cast<uint8_t>(byte2));
+            for (unsigned pixel = 0; pixel < 8; ++pixel) {
+                // The leftmost pixel is stored in the most significant bit
+                auto bit = 7 - pixel;
+                auto expected = (((byte2 >> bit) & 1U) << 1) | ((byte1 >> bit) & 1U);
+                REQUIRE(static_cast<unsigned>(result[pixel]) == expected);
+            }
+        }
+    }
+}
+
 TEST_CASE("Tile conversion complete") {
     std::array<uint8_t, 16> tile{0x7C, 0x7C, 0x00, 0xC6, 0xC6, 0x00, 0x00, 0xFE,
                                  0xC6, 0xC6, 0x00, 0xC6, 0xC6, 0x00, 0x00, 0x00};
@@ -219,3 +234,36 @@ TEST_CASE("Using mirrored TileIndex to access Framebuffer") {
         CHECK(fb.get_pixel(tim.pixel_index(1, 1)) == 1);
     }
 }
+
+TEST_CASE("Mapping game boy colors to screen colors") {
+    using namespace graphics::gb;
+    // Odd size to also cover the remainder which does not fill a complete SIMD register.
+    auto size = GENERATE(0, 1, 15, 16, 17, 160 * 144 + 3);
+    std::vector<ColorGb> in(static_cast<size_t>(size));
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = static_cast<ColorGb>(i % 6);
+    }
+    std::vector<ColorScreen> out(in.size());
+    map_to_screen_colors(in, out);
+    for (size_t i = 0; i < in.size(); ++i) {
+        INFO(fmt::format("Pixel {}", i));
+        CHECK(out[i] == to_screen_color(in[i]));
+    }
+}
+
+TEST_CASE("Mapping game boy colors with a custom palette") {
+    using namespace graphics::gb;
+    ScreenPalette palette{};
+    for (size_t i = 0; i < palette.size(); ++i) {
+        palette[i] = static_cast<ColorScreen>(0x01020304U * (i + 1));
+    }
+    std::vector<ColorGb> in{ColorGb::Black, ColorGb::White, ColorGb::DarkGray, ColorGb::LightGray};
+    in.resize(32, ColorGb::DarkGray);
+    std::vector<ColorScreen> out(in.size());
+    map_to_screen_colors(in, out, palette);
+    CHECK(out[0] == palette[3]);
+    CHECK(out[1] == palette[0]);
+    CHECK(out[2] == palette[2]);
+    CHECK(out[3] == palette[1]);
+    CHECK(out[31] == palette[2]);
+}
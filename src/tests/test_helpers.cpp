@@ -1 +1,23 @@
-#include "test_helpers.hpp"
\ No newline at end of file
+#include "test_helpers.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <system_error>
+
+#include <unistd.h>
+
+TemporaryFile::TemporaryFile(std::string_view name) {
+    static std::atomic<unsigned> counter = 0;
+    m_path = std::filesystem::temp_directory_path()
+             / fmt::format("game-boy-emulator-test-{}-{}-{}", getpid(), counter++, name);
+    std::filesystem::remove(m_path);
+}
+
+TemporaryFile::~TemporaryFile() {
+    std::error_code ec;
+    std::filesystem::remove(m_path, ec);
+}
+
+const std::filesystem::path& TemporaryFile::get_path() const {
+    return m_path;
+}
@@ -2,7 +2,9 @@
 
 #include "fmt/format.h"
 #include "catch2/catch.hpp"
+#include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 
@@ -42,30 +44,18 @@ inline std::vector<std::string> read_rom_log_file(const std::string& filename) {
     return lines;
 }
 
-#include "cpu.hpp"
+// Path of a file in the temporary directory which is removed on destruction. The name contains
+// the process id and a counter, so tests running concurrently don't overwrite each others files.
+class TemporaryFile {
+    std::filesystem::path m_path;
 
-inline std::vector<CpuDebugState> read_log_file(const std::string& filename) {
-    // Example: A: C2 F: 10 B: 01 C: 10 D: C0 E: 03 H: 40 L: 03 SP: FFFE PC: 0206 (2A 12 1C 20)
-    std::ifstream file{filename};
-    std::string line;
-    std::vector<CpuDebugState> lines;
-    while (std::getline(file, line)) {
-        CpuDebugState cds;
-        cds.a = std::strtol(line.c_str() + 3, nullptr, 16);
-        cds.f = std::strtol(line.c_str() + 9, nullptr, 16);
-        cds.b = std::strtol(line.c_str() + 15, nullptr, 16);
-        cds.c = std::strtol(line.c_str() + 21, nullptr, 16);
-        cds.d = std::strtol(line.c_str() + 27, nullptr, 16);
-        cds.e = std::strtol(line.c_str() + 33, nullptr, 16);
-        cds.h = std::strtol(line.c_str() + 39, nullptr, 16);
-        cds.l = std::strtol(line.c_str() + 45, nullptr, 16);
-        cds.sp = std::strtol(line.c_str() + 52, nullptr, 16);
-        cds.pc = std::strtol(line.c_str() + 61, nullptr, 16);
-        cds.mem_pc[0] = std::strtol(line.c_str() + 67, nullptr, 16);
-        cds.mem_pc[1] = std::strtol(line.c_str() + 70, nullptr, 16);
-        cds.mem_pc[2] = std::strtol(line.c_str() + 73, nullptr, 16);
-        cds.mem_pc[3] = std::strtol(line.c_str() + 76, nullptr, 16);
-        lines.push_back(cds);
-    }
-    return lines;
-}
\ No newline at end of file
+public:
+    explicit TemporaryFile(std::string_view name);
+    ~TemporaryFile();
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+    TemporaryFile(TemporaryFile&&) = delete;
+    TemporaryFile& operator=(TemporaryFile&&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& get_path() const;
+};
@@ -0,0 +1,150 @@
+#include "catch2/catch.hpp"
+
+#include "addressbus.hpp"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "linkcable.hpp"
+#include "ppu.hpp"
+#include "serial_port.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+namespace {
+constexpr uint16_t SERIAL_BUFFER = 0xFF01;
+constexpr uint16_t SERIAL_CONTROL = 0xFF02;
+constexpr uint16_t INTERRUPT_FLAG = 0xFF0F;
+constexpr uint8_t SERIAL_INTERRUPT = 0b0000'1000;
+
+// dmg-acid2 does not use the serial port itself
+std::unique_ptr<Emulator> create_emulator() {
+    auto emulator = std::make_unique<Emulator>(EmulatorOptions::headless());
+    emulator->load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    return emulator;
+}
+
+void start_transfer(Emulator& emulator, uint8_t data, uint8_t control) {
+    auto bus = emulator.get_bus();
+    bus->write_byte(SERIAL_BUFFER, data);
+    bus->write_byte(INTERRUPT_FLAG, 0);
+    bus->write_byte(SERIAL_CONTROL, control);
+}
+
+bool has_serial_interrupt(const Emulator& emulator) {
+    return (emulator.get_bus()->read_byte(INTERRUPT_FLAG) & SERIAL_INTERRUPT) != 0;
+}
+} // namespace
+
+TEST_CASE("Link cable exchanges bytes after the transfer time") {
+    spdlog::set_level(spdlog::level::err);
+    auto master_emulator = create_emulator();
+    auto& master = *master_emulator;
+    auto slave_emulator = create_emulator();
+    auto& slave = *slave_emulator;
+    LinkCable cable{master, slave};
+    start_transfer(slave, 0x42, 0x80);
+    start_transfer(master, 0x17, 0x81);
+
+    REQUIRE(cable.run_cycles(SerialPort::CYCLES_PER_TRANSFER / 2));
+    CHECK(master.get_serial_port()->is_transferring());
+    CHECK(slave.get_serial_port()->is_transferring());
+    CHECK_FALSE(has_serial_interrupt(master));
+
+    REQUIRE(cable.run_cycles(SerialPort::CYCLES_PER_TRANSFER / 2
+                             + LinkCable::DEFAULT_WINDOW_CYCLES));
+    CHECK(master.get_bus()->read_byte(SERIAL_BUFFER) == 0x42);
+    CHECK(slave.get_bus()->read_byte(SERIAL_BUFFER) == 0x17);
+    CHECK_FALSE(master.get_serial_port()->is_transferring());
+    CHECK_FALSE(slave.get_serial_port()->is_transferring());
+    CHECK(has_serial_interrupt(master));
+    CHECK(has_serial_interrupt(slave));
+}
+
+TEST_CASE("Link cable transfers without a waiting partner") {
+    spdlog::set_level(spdlog::level::err);
+    auto first_emulator = create_emulator();
+    auto& first = *first_emulator;
+    auto second_emulator = create_emulator();
+    auto& second = *second_emulator;
+    LinkCable cable{first, second};
+
+    SECTION("Internal clock receives 0xFF") {
+        start_transfer(first, 0x17, 0x81);
+        REQUIRE(cable.run_frames(1));
+        CHECK(first.get_bus()->read_byte(SERIAL_BUFFER) == 0xFF);
+        CHECK(has_serial_interrupt(first));
+        CHECK_FALSE(has_serial_interrupt(second));
+    }
+    SECTION("External clock waits for the partner") {
+        start_transfer(first, 0x17, 0x80);
+        REQUIRE(cable.run_frames(2));
+        CHECK(first.get_serial_port()->is_transferring());
+        CHECK(first.get_bus()->read_byte(SERIAL_BUFFER) == 0x17);
+        CHECK_FALSE(has_serial_interrupt(first));
+    }
+}
+
+TEST_CASE("Linked emulators run the requested number of cycles") {
+    spdlog::set_level(spdlog::level::err);
+    auto first_emulator = create_emulator();
+    auto& first = *first_emulator;
+    auto second_emulator = create_emulator();
+    auto& second = *second_emulator;
+    const auto start_cycles = first.get_state().cycles_m;
+    {
+        LinkCable cable{first, second, 1000};
+        REQUIRE(cable.run_frames(10));
+    }
+    CHECK(first.get_state().cycles_m >= start_cycles + 10 * constants::CYCLES_PER_FRAME_T / 4);
+    CHECK(first.get_state().frame_count == second.get_state().frame_count);
+    CHECK(first.get_ppu()->get_game() == second.get_ppu()->get_game());
+    CHECK_THROWS_AS(LinkCable(first, first), LogicError);
+
+    // Without the cable, transfers with internal clock complete immediately again.
+    start_transfer(first, 0x17, 0x81);
+    CHECK_FALSE(first.get_serial_port()->is_transferring());
+    CHECK(has_serial_interrupt(first));
+}
+
+TEST_CASE("Loading a game disconnects the link cable") {
+    spdlog::set_level(spdlog::level::err);
+    auto first_emulator = create_emulator();
+    auto& first = *first_emulator;
+    auto second_emulator = create_emulator();
+    auto& second = *second_emulator;
+    LinkCable cable{first, second};
+    start_transfer(first, 0x17, 0x81);
+    CHECK(first.get_serial_port()->is_transferring());
+
+    first.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    start_transfer(first, 0x17, 0x81);
+    CHECK_FALSE(first.get_serial_port()->is_transferring());
+    CHECK(has_serial_interrupt(first));
+    // The second emulator is still linked
+    start_transfer(second, 0x42, 0x81);
+    CHECK(second.get_serial_port()->is_transferring());
+    // Runs still step both emulators
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(cable.run_frames(1));
+    }
+    CHECK(first.get_state().frame_count == second.get_state().frame_count);
+}
+
+TEST_CASE("Resetting the state keeps the link cable connected") {
+    spdlog::set_level(spdlog::level::err);
+    auto first_emulator = create_emulator();
+    auto& first = *first_emulator;
+    auto second_emulator = create_emulator();
+    auto& second = *second_emulator;
+    LinkCable cable{first, second};
+
+    first.reset_state();
+    CHECK(first.get_serial_port()->is_linked());
+    // Transfers with internal clock wait for the cable instead of completing immediately
+    start_transfer(first, 0x17, 0x81);
+    CHECK(first.get_serial_port()->is_transferring());
+    CHECK_FALSE(has_serial_interrupt(first));
+}
@@ -0,0 +1,13 @@
+#include "noisechannel.hpp"
+#include <catch2/catch.hpp>
+
+
+TEST_CASE("Advancing the LFSR matches stepping it repeatedly") {
+    auto short_mode = GENERATE(false, true);
+    auto steps = GENERATE(0, 1, 7, 8, 9, 127, 128, 1000, 32767, 32768, 100000);
+    uint16_t expected = lfsr::INITIAL_STATE;
+    for (int i = 0; i < steps; ++i) {
+        expected = lfsr::step(expected, short_mode);
+    }
+    CHECK(lfsr::advance(lfsr::INITIAL_STATE, short_mode, steps) == expected);
+}
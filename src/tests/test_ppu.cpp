@@ -0,0 +1,355 @@
+#include "catch2/catch.hpp"
+
+#include "constants.h"
+#include "emulator.hpp"
+#include "ppu.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace {
+constexpr uint16_t LCDC = 0xFF40;
+constexpr uint16_t STAT = 0xFF41;
+constexpr uint16_t LY = 0xFF44;
+constexpr uint16_t BGP = 0xFF47;
+constexpr uint16_t OBP0 = 0xFF48;
+constexpr uint16_t OBP1 = 0xFF49;
+constexpr uint16_t OAM_BEGIN = 0xFE00;
+constexpr size_t NUM_OBJECTS = 40;
+constexpr size_t WIDTH = constants::SCREEN_RES_WIDTH;
+
+// PPU modes in STAT
+constexpr uint8_t HBLANK = 0;
+constexpr uint8_t VBLANK = 1;
+constexpr uint8_t OAM_SCAN = 2;
+
+// Flags of an object
+constexpr uint8_t BG_OVER_OBJ = 0x80;
+constexpr uint8_t Y_FLIP = 0x40;
+constexpr uint8_t X_FLIP = 0x20;
+constexpr uint8_t PALETTE_1 = 0x10;
+
+struct Object {
+    uint8_t y = 0;
+    uint8_t x = 0;
+    uint8_t tile = 0;
+    uint8_t flags = 0;
+};
+
+using Line = std::array<uint8_t, WIDTH>;
+
+void set_object(Ppu& ppu, size_t index, const Object& object) {
+    const auto address = static_cast<uint16_t>(OAM_BEGIN + index * 4);
+    ppu.write_byte(address, object.y);
+    ppu.write_byte(address + 1, object.x);
+    ppu.write_byte(address + 2, object.tile);
+    ppu.write_byte(address + 3, object.flags);
+}
+
+Object get_object(Ppu& ppu, size_t index) {
+    const auto address = static_cast<uint16_t>(OAM_BEGIN + index * 4);
+    return {ppu.read_byte(address), ppu.read_byte(address + 1), ppu.read_byte(address + 2),
+            ppu.read_byte(address + 3)};
+}
+
+// Color 0..3 of a pixel of a tile in the 0x8000 tile data area
+uint8_t get_tile_pixel(Ppu& ppu, unsigned tile, unsigned row, unsigned x) {
+    const auto address = static_cast<uint16_t>(0x8000 + tile * 16 + row * 2);
+    const auto bit = 7 - x;
+    return static_cast<uint8_t>(((ppu.read_byte(address) >> bit) & 1)
+                                | (((ppu.read_byte(address + 1) >> bit) & 1) << 1));
+}
+
+uint8_t apply_palette(uint8_t palette, uint8_t color) {
+    return (palette >> (color * 2)) & 0b11;
+}
+
+// Expected shades of a line, found by scanning all of OAM like the PPU did before it kept track of
+// the objects on every line. The background is tile 0 repeated without scrolling.
+Line get_expected_line(Ppu& ppu, unsigned ly) {
+    const auto height = (ppu.read_byte(LCDC) & 0b100) != 0 ? 16U : 8U;
+    std::array<uint8_t, WIDTH> background{};
+    Line line{};
+    for (unsigned x = 0; x < WIDTH; ++x) {
+        background[x] = get_tile_pixel(ppu, 0, ly % 8, x % 8);
+        line[x] = apply_palette(ppu.read_byte(BGP), background[x]);
+    }
+
+    // The first 10 objects in OAM covering the line, objects at x 0 don't count.
+    std::vector<Object> objects;
+    for (size_t i = 0; i < NUM_OBJECTS && objects.size() < 10; ++i) {
+        const auto object = get_object(ppu, i);
+        if (object.x != 0 && ly + 16 >= object.y && ly + 16 < object.y + height) {
+            objects.push_back(object);
+        }
+    }
+    // Smaller x has the higher priority, the first one in OAM for the same x.
+    std::ranges::stable_sort(objects, {}, &Object::x);
+
+    std::bitset<WIDTH> taken;
+    for (const auto& object : objects) {
+        auto row = ly + 16 - object.y;
+        if ((object.flags & Y_FLIP) != 0) {
+            row = height - 1 - row;
+        }
+        const auto tile = (height == 16 ? object.tile & 0xFE : object.tile) + row / 8;
+        for (unsigned pixel = 0; pixel < 8; ++pixel) {
+            const auto x = static_cast<int>(object.x + pixel) - 8;
+            if (x < 0 || x >= static_cast<int>(WIDTH)) {
+                continue;
+            }
+            const auto tile_x = (object.flags & X_FLIP) != 0 ? 7 - pixel : pixel;
+            const auto color = get_tile_pixel(ppu, tile, row % 8, tile_x);
+            if (color == 0 || taken.test(x)) {
+                continue;
+            }
+            taken.set(x);
+            if ((object.flags & BG_OVER_OBJ) != 0 && background[x] != 0) {
+                continue;
+            }
+            const auto palette = (object.flags & PALETTE_1) != 0 ? OBP1 : OBP0;
+            line[x] = apply_palette(ppu.read_byte(palette), color);
+        }
+    }
+    return line;
+}
+
+void step_until(Ppu& ppu, unsigned ly, uint8_t mode) {
+    while (ppu.read_byte(LY) != ly || (ppu.read_byte(STAT) & 0b11) != mode) {
+        ppu.cycle_elapsed_callback(0);
+    }
+}
+
+using Frame = std::array<Line, constants::SCREEN_RES_HEIGHT>;
+
+// Draw a frame and compare every line with a scan of OAM at the time it was drawn. OAM can be
+// changed in on_line, which is called during the HBlank of every line. Lines are drawn at the end
+// of their HBlank. Returns the drawn frame.
+template <typename F>
+Frame check_frame(Emulator& emulator, F&& on_line) {
+    auto& ppu = *emulator.get_ppu();
+    // The framebuffer is cleared after it was passed to the draw function
+    Frame drawn{};
+    emulator.set_draw_function([&drawn, &ppu] {
+        const auto pixels = ppu.get_game().pixels();
+        for (size_t y = 0; y < drawn.size(); ++y) {
+            std::ranges::transform(
+                pixels.subspan(y * WIDTH, WIDTH), drawn[y].begin(),
+                [](graphics::gb::ColorGb color) { return static_cast<uint8_t>(color); });
+        }
+    });
+    Frame expected{};
+    step_until(ppu, 153, VBLANK);
+    step_until(ppu, 0, OAM_SCAN);
+    for (unsigned ly = 0; ly < constants::SCREEN_RES_HEIGHT; ++ly) {
+        step_until(ppu, ly, HBLANK);
+        on_line(ly);
+        expected[ly] = get_expected_line(ppu, ly);
+    }
+    step_until(ppu, constants::SCREEN_RES_HEIGHT, VBLANK);
+    emulator.set_draw_function({});
+    for (unsigned ly = 0; ly < constants::SCREEN_RES_HEIGHT; ++ly) {
+        INFO("Line " << ly);
+        REQUIRE(drawn[ly] == expected[ly]);
+    }
+    return drawn;
+}
+
+Frame check_frame(Emulator& emulator) {
+    return check_frame(emulator, [](unsigned) {});
+}
+
+// Background tile 0 has color 0 in half of its pixels, objects use the other tiles. Objects are
+// hidden in OAM and the background palette is the identity. The LCD stays off, so VRAM and OAM can
+// be written in any mode until turn_on_lcd is called.
+void setup_ppu(Ppu& ppu) {
+    // The initial register values request an OAM DMA transfer, which would overwrite OAM.
+    step_until(ppu, 0, OAM_SCAN);
+    step_until(ppu, 1, OAM_SCAN);
+    ppu.write_byte(LCDC, 0);
+    for (unsigned row = 0; row < 8; ++row) {
+        ppu.write_byte(static_cast<uint16_t>(0x8000 + row * 2), 0x0F);
+        ppu.write_byte(static_cast<uint16_t>(0x8001 + row * 2), 0x33);
+    }
+    for (unsigned address = 0x8010; address < 0x9000; ++address) {
+        ppu.write_byte(static_cast<uint16_t>(address), static_cast<uint8_t>(address * 37 + 11));
+    }
+    for (unsigned address = 0x9800; address < 0x9C00; ++address) {
+        ppu.write_byte(static_cast<uint16_t>(address), 0);
+    }
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        set_object(ppu, i, {});
+    }
+    ppu.write_byte(BGP, 0xE4);
+    ppu.write_byte(OBP0, 0xD2);
+    ppu.write_byte(OBP1, 0x2D);
+}
+
+void turn_on_lcd(Ppu& ppu, bool tall_objects) {
+    // LCD, objects and background on, tile data at 0x8000
+    ppu.write_byte(LCDC, static_cast<uint8_t>(0b1001'0011 | (tall_objects ? 0b100 : 0)));
+}
+
+// Objects spread over the screen with all flags, including some at x 0 or offscreen.
+void place_scattered_objects(Ppu& ppu) {
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        set_object(ppu, i,
+                   {static_cast<uint8_t>((i * 37) % 176), static_cast<uint8_t>((i * 53) % 176),
+                    static_cast<uint8_t>(1 + i), static_cast<uint8_t>(((i * 5) % 16) << 4)});
+    }
+}
+} // namespace
+
+TEST_CASE("PPU draws the objects of each line like a scan of OAM") {
+    spdlog::set_level(spdlog::level::err);
+    const auto options = GENERATE(EmulatorOptions::headless(), EmulatorOptions::reference());
+    const auto tall_objects = GENERATE(false, true);
+    Emulator emulator{options};
+    emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    auto& ppu = *emulator.get_ppu();
+    setup_ppu(ppu);
+    place_scattered_objects(ppu);
+    turn_on_lcd(ppu, tall_objects);
+    check_frame(emulator);
+}
+
+TEST_CASE("PPU draws at most 10 objects per line") {
+    spdlog::set_level(spdlog::level::err);
+    Emulator emulator{EmulatorOptions::headless()};
+    emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    auto& ppu = *emulator.get_ppu();
+    setup_ppu(ppu);
+    // Tile 1 is opaque with color 3
+    for (uint16_t address = 0x8010; address < 0x8020; ++address) {
+        ppu.write_byte(address, 0xFF);
+    }
+    constexpr uint8_t LINE = 40;
+    // Objects at x 0 are not drawn and don't count towards the limit
+    set_object(ppu, 0, {LINE + 16, 0, 1, 0});
+    // 12 objects side by side without gaps, the last two are dropped
+    for (size_t i = 1; i <= 12; ++i) {
+        set_object(ppu, i, {LINE + 16, static_cast<uint8_t>(8 + (i - 1) * 8), 1, 0});
+    }
+    turn_on_lcd(ppu, false);
+    const auto line = check_frame(emulator)[LINE];
+    const auto object_shade = apply_palette(0xD2, 3);
+    for (size_t x = 0; x < 10 * 8; ++x) {
+        CHECK(line[x] == object_shade);
+    }
+    for (size_t x = 10 * 8; x < 12 * 8; ++x) {
+        CHECK(line[x] == get_tile_pixel(ppu, 0, LINE % 8, x % 8));
+    }
+}
+
+TEST_CASE("PPU draws objects written to OAM during the frame") {
+    spdlog::set_level(spdlog::level::err);
+    const auto options = GENERATE(EmulatorOptions::headless(), EmulatorOptions::reference());
+    Emulator emulator{options};
+    emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    auto& ppu = *emulator.get_ppu();
+    setup_ppu(ppu);
+    place_scattered_objects(ppu);
+
+    turn_on_lcd(ppu, true);
+    check_frame(emulator, [&ppu](unsigned ly) {
+        if (ly == 30) {
+            // Change everything but the y position of objects covering the next lines
+            for (size_t i = 0; i < NUM_OBJECTS; i += 3) {
+                auto object = get_object(ppu, i);
+                object.x = static_cast<uint8_t>(object.x + 5);
+                object.tile = static_cast<uint8_t>(object.tile + 7);
+                object.flags ^= BG_OVER_OBJ | X_FLIP | PALETTE_1;
+                set_object(ppu, i, object);
+            }
+        } else if (ly == 60) {
+            // Hide some objects
+            for (size_t i = 1; i < NUM_OBJECTS; i += 4) {
+                set_object(ppu, i, {});
+            }
+        } else if (ly == 90) {
+            // Fill all of OAM with objects on the next lines, more than fit on a line
+            for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+                set_object(ppu, i,
+                           {static_cast<uint8_t>(ly + 16 + i % 24), static_cast<uint8_t>(i * 4),
+                            static_cast<uint8_t>(i * 3), static_cast<uint8_t>((i % 16) << 4)});
+            }
+        }
+    });
+}
+
+TEST_CASE("PPU draws objects moved to other lines during the frame") {
+    spdlog::set_level(spdlog::level::err);
+    const auto options = GENERATE(EmulatorOptions::headless(), EmulatorOptions::reference());
+    const auto tall_objects = GENERATE(false, true);
+    Emulator emulator{options};
+    emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    auto& ppu = *emulator.get_ppu();
+    setup_ppu(ppu);
+    place_scattered_objects(ppu);
+
+    turn_on_lcd(ppu, tall_objects);
+    check_frame(emulator, [&ppu](unsigned ly) {
+        if (ly % 3 != 0) {
+            return;
+        }
+        // Move some objects so they start in the middle of the next lines, behind the current
+        // line or off the screen. Objects stay or come back within 10 lines of each other, so the
+        // limit of objects per line is reached as well.
+        for (size_t i = ly % 4; i < NUM_OBJECTS; i += 2) {
+            auto object = get_object(ppu, i);
+            switch ((ly + i) % 5) {
+            case 0:
+                object.y = 0;
+                break;
+            case 1:
+                object.y = static_cast<uint8_t>(ly + 10);
+                break;
+            case 4:
+                object.y = 170;
+                break;
+            default:
+                object.y = static_cast<uint8_t>(ly + 16 + (i % 10));
+                break;
+            }
+            set_object(ppu, i, object);
+        }
+    });
+}
+
+TEST_CASE("PPU draws the background over objects with priority") {
+    spdlog::set_level(spdlog::level::err);
+    const auto options = GENERATE(EmulatorOptions::headless(), EmulatorOptions::reference());
+    Emulator emulator{options};
+    emulator.load_game(std::filesystem::absolute("roms/dmg-acid2.gb"));
+    auto& ppu = *emulator.get_ppu();
+    setup_ppu(ppu);
+    // Tile 1 is opaque with color 3
+    for (uint16_t address = 0x8010; address < 0x8020; ++address) {
+        ppu.write_byte(address, 0xFF);
+    }
+    constexpr uint8_t LINE = 20;
+    // The background is hidden behind the first object at its pixels with color 0 only. The
+    // second object overlaps it and has the lower priority, it isn't shown where the first one is
+    // opaque, not even where the first one is behind the background.
+    set_object(ppu, 0, {LINE + 16, 20, 1, BG_OVER_OBJ});
+    set_object(ppu, 1, {LINE + 16, 24, 1, 0});
+    // The same when the object with the smaller x comes later in OAM
+    set_object(ppu, 2, {LINE + 16, 60, 1, 0});
+    set_object(ppu, 3, {LINE + 16, 56, 1, BG_OVER_OBJ | PALETTE_1});
+    turn_on_lcd(ppu, false);
+    const auto line = check_frame(emulator)[LINE];
+    const auto object_shade = apply_palette(0xD2, 3);
+    for (size_t x = 12; x < 20; ++x) {
+        const auto background = get_tile_pixel(ppu, 0, LINE % 8, x % 8);
+        CHECK(line[x] == (background == 0 ? object_shade : background));
+    }
+    for (size_t x = 20; x < 24; ++x) {
+        CHECK(line[x] == object_shade);
+    }
+}
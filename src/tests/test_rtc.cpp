@@ -0,0 +1,164 @@
+#include "rtc.hpp"
+#include "test_helpers.hpp"
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+using namespace std::chrono_literals;
+
+namespace {
+using Days = std::chrono::duration<int64_t, std::ratio<86400>>;
+
+struct FakeClock {
+    std::chrono::microseconds time{0};
+};
+
+Rtc make_rtc(FakeClock& clock) {
+    return Rtc([&clock] { return clock.time; });
+}
+
+void latch(Rtc& rtc) {
+    rtc.write_latch(0);
+    rtc.write_latch(1);
+}
+} // namespace
+
+TEST_CASE("RTC registers are latched", "[rtc]") {
+    FakeClock clock;
+    auto rtc = make_rtc(clock);
+    clock.time = Days(300) + 2h + 3min + 4s + 500ms;
+    CHECK(rtc.read(Rtc::Register::Seconds) == 0);
+
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 4);
+    CHECK(rtc.read(Rtc::Register::Minutes) == 3);
+    CHECK(rtc.read(Rtc::Register::Hours) == 2);
+    CHECK(rtc.read(Rtc::Register::DaysLow) == 300 - 256);
+    CHECK(rtc.read(Rtc::Register::DaysHigh) == 1);
+
+    // Only the sequence 0, 1 latches
+    clock.time += 10s;
+    rtc.write_latch(1);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 4);
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 14);
+}
+
+TEST_CASE("RTC registers can be written", "[rtc]") {
+    FakeClock clock;
+    auto rtc = make_rtc(clock);
+    clock.time = 1h + 1500ms;
+    rtc.write(Rtc::Register::Minutes, 10);
+    rtc.write(Rtc::Register::DaysLow, 7);
+    clock.time += 1s;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 2);
+    CHECK(rtc.read(Rtc::Register::Minutes) == 10);
+    CHECK(rtc.read(Rtc::Register::Hours) == 1);
+    CHECK(rtc.read(Rtc::Register::DaysLow) == 7);
+
+    // Writing the seconds resets the fraction of the current second
+    rtc.write(Rtc::Register::Seconds, 30);
+    clock.time += 600ms;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 30);
+    clock.time += 400ms;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 31);
+}
+
+TEST_CASE("RTC can be halted", "[rtc]") {
+    FakeClock clock;
+    auto rtc = make_rtc(clock);
+    clock.time = 5s;
+    rtc.write(Rtc::Register::DaysHigh, 0b0100'0000);
+    clock.time += 1h;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 5);
+    CHECK(rtc.read(Rtc::Register::Hours) == 0);
+    CHECK(rtc.read(Rtc::Register::DaysHigh) == 0b0100'0000);
+
+    rtc.write(Rtc::Register::DaysHigh, 0);
+    clock.time += 1s;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 6);
+}
+
+TEST_CASE("RTC day counter overflow sets the carry bit", "[rtc]") {
+    FakeClock clock;
+    auto rtc = make_rtc(clock);
+    clock.time = Days(511) + 23h + 59min + 59s;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::DaysHigh) == 0b1);
+
+    clock.time += 2s;
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::Seconds) == 1);
+    CHECK(rtc.read(Rtc::Register::DaysLow) == 0);
+    CHECK(rtc.read(Rtc::Register::DaysHigh) == 0b1000'0000);
+
+    // The carry stays set until it is cleared by the game
+    clock.time += Days(1);
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::DaysLow) == 1);
+    CHECK(rtc.read(Rtc::Register::DaysHigh) == 0b1000'0000);
+    rtc.write(Rtc::Register::DaysHigh, 0);
+    latch(rtc);
+    CHECK(rtc.read(Rtc::Register::DaysHigh) == 0);
+}
+
+TEST_CASE("RTC state is saved and loaded", "[rtc]") {
+    const TemporaryFile rtc_file("game.gb.rtc");
+    const auto& path = rtc_file.get_path();
+    FakeClock clock;
+    {
+        auto rtc = make_rtc(clock);
+        clock.time = 3h + 2min + 1s;
+        latch(rtc);
+        clock.time += 1min;
+        rtc.save(path);
+    }
+    REQUIRE(std::filesystem::file_size(path) == 48);
+
+    SECTION("Emulated time continues where it stopped") {
+        FakeClock new_clock;
+        auto rtc = make_rtc(new_clock);
+        rtc.load(path);
+        CHECK(rtc.read(Rtc::Register::Minutes) == 2);
+        new_clock.time = 1s;
+        latch(rtc);
+        CHECK(rtc.read(Rtc::Register::Seconds) == 2);
+        CHECK(rtc.read(Rtc::Register::Minutes) == 3);
+        CHECK(rtc.read(Rtc::Register::Hours) == 3);
+    }
+
+    SECTION("Wall time includes the time since saving") {
+        // Move the timestamp of the save one day into the past
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        std::array<uint8_t, 8> timestamp{};
+        file.seekg(40);
+        file.read(reinterpret_cast<char*>(timestamp.data()), timestamp.size());
+        uint64_t value = 0;
+        for (size_t i = 0; i < timestamp.size(); ++i) {
+            value |= static_cast<uint64_t>(timestamp[i]) << (8 * i);
+        }
+        value -= 86400;
+        for (size_t i = 0; i < timestamp.size(); ++i) {
+            timestamp[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        file.seekp(40);
+        file.write(reinterpret_cast<const char*>(timestamp.data()), timestamp.size());
+        file.close();
+
+        Rtc rtc;
+        rtc.load(path);
+        latch(rtc);
+        CHECK(rtc.read(Rtc::Register::DaysLow) == 1);
+        CHECK(rtc.read(Rtc::Register::Hours) == 3);
+        CHECK(rtc.read(Rtc::Register::Minutes) == 3);
+    }
+}
@@ -0,0 +1,110 @@
+#include "catch2/catch.hpp"
+
+#include "addressbus.hpp"
+#include "emulator.hpp"
+#include "exceptions.hpp"
+#include "io.hpp"
+#include "joypad.hpp"
+#include "shadowexecution.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+std::unique_ptr<Emulator> create_emulator(std::shared_ptr<const std::vector<uint8_t>> rom,
+                                          const EmulatorOptions& options, size_t steps) {
+    auto emulator = std::make_unique<Emulator>(options);
+    emulator->load_game(std::move(rom));
+    for (size_t i = 0; i < steps; ++i) {
+        REQUIRE(emulator->step());
+    }
+    return emulator;
+}
+} // namespace
+
+TEST_CASE("Shadow execution of fast paths and their references does not diverge") {
+    spdlog::set_level(spdlog::level::err);
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    ShadowExecution first{rom, {.check_interval = 5000, .reload_candidate_state = true}};
+    CHECK_FALSE(first.run(100'000).has_value());
+    CHECK(first.get_steps() == 100'000);
+
+    // Runs split differently, but checking at the same steps, have the same rolling hash.
+    ShadowExecution second{rom, {.check_interval = 5000}};
+    CHECK_FALSE(second.run(60'000).has_value());
+    CHECK(second.get_rolling_hash() != first.get_rolling_hash());
+    CHECK_FALSE(second.run(40'000).has_value());
+    CHECK(second.get_rolling_hash() == first.get_rolling_hash());
+
+    CHECK_THROWS_AS(ShadowExecution(rom, {.check_interval = 0}), LogicError);
+}
+
+TEST_CASE("Shadow execution finds the exact step of a divergence") {
+    spdlog::set_level(spdlog::level::err);
+    const auto rom = EmulatorIo().load_rom_file("roms/01-special.gb");
+    // LY is fixed in the candidate, so its PPU registers differ after the first step.
+    auto candidate_options = EmulatorOptions::headless();
+    candidate_options.stub_ly_value = 0x90;
+    ShadowExecution shadow{rom, {.candidate_options = candidate_options, .check_interval = 1000}};
+    const auto divergence = shadow.run(1'000'000);
+    REQUIRE(divergence.has_value());
+    INFO(divergence->describe());
+    CHECK(divergence->reproducible);
+    CHECK(shadow.get_steps() == divergence->step);
+    CHECK(divergence->reference_cpu_state == shadow.get_reference().get_cpu_debug_state());
+    // Further runs report the same divergence without stepping
+    CHECK(shadow.run(100)->step == divergence->step);
+    CHECK(shadow.get_steps() == divergence->step);
+
+    const auto before_reference = create_emulator(rom, EmulatorOptions::reference(),
+                                                   divergence->step - 1);
+    const auto before_candidate = create_emulator(rom, candidate_options, divergence->step - 1);
+    CHECK(before_reference->save_state() == before_candidate->save_state());
+    REQUIRE(before_reference->step());
+    REQUIRE(before_candidate->step());
+    CHECK(before_reference->save_state() != before_candidate->save_state());
+    CHECK(before_reference->save_state() == shadow.get_reference().save_state());
+}
+
+TEST_CASE("Shadow execution reports divergences which are not part of the state") {
+    spdlog::set_level(spdlog::level::err);
+    ShadowExecution shadow{EmulatorIo().load_rom_file("roms/01-special.gb"), {.check_interval = 1000}};
+    REQUIRE_FALSE(shadow.run(1500).has_value());
+    // Pressing a key behind the back of the shadow execution is lost when going back to the last
+    // check.
+    shadow.get_candidate().get_joypad()->set_pressed_keys(0b1000'0000);
+    const auto divergence = shadow.run(1000);
+    REQUIRE(divergence.has_value());
+    CHECK_FALSE(divergence->reproducible);
+    CHECK(divergence->step == 2500);
+}
+
+TEST_CASE("Shadow execution checks tiles, cartridge banks and audio channels") {
+    spdlog::set_level(spdlog::level::err);
+    // dmg-acid2 draws mirrored sprites from many tiles, bits_bank1 switches through all ROM banks.
+    const std::string rom_path = GENERATE("roms/dmg-acid2.gb", "roms/mts/mbc1/bits_bank1.gb");
+    const auto rom = EmulatorIo().load_rom_file(rom_path);
+    // Neither game plays sound, so all channels are started before.
+    Emulator start{EmulatorOptions::headless()};
+    start.load_game(rom);
+    const std::vector<std::pair<uint16_t, uint8_t>> apu_writes{
+        {0xFF26, 0x80}, {0xFF25, 0xFF}, {0xFF24, 0x77}, {0xFF11, 0x80}, {0xFF12, 0xF3},
+        {0xFF13, 0x00}, {0xFF14, 0x87}, {0xFF16, 0x40}, {0xFF17, 0xA1}, {0xFF18, 0xC0},
+        {0xFF19, 0x86}, {0xFF30, 0x01}, {0xFF31, 0x23}, {0xFF3F, 0xEF}, {0xFF1A, 0x80},
+        {0xFF1C, 0x20}, {0xFF1D, 0x40}, {0xFF1E, 0x87}, {0xFF21, 0xF2}, {0xFF22, 0x21},
+        {0xFF23, 0x80}};
+    for (const auto& [address, value] : apu_writes) {
+        start.get_bus()->write_byte(address, value);
+    }
+    ShadowExecution shadow{rom, {.check_interval = 10'000, .reload_candidate_state = true},
+                           start.save_state()};
+    const auto divergence = shadow.run(500'000);
+    INFO(rom_path);
+    INFO((divergence ? divergence->describe() : ""));
+    CHECK_FALSE(divergence.has_value());
+}
@@ -0,0 +1,57 @@
+#include "spscqueue.hpp"
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <string>
+#include <thread>
+
+
+TEST_CASE("SPSC queue returns values in order") {
+    SpscQueue<std::string, 4> queue;
+    CHECK(queue.empty());
+    CHECK_FALSE(queue.pop().has_value());
+
+    CHECK(queue.push("a"));
+    CHECK(queue.push("b"));
+    CHECK_FALSE(queue.empty());
+    CHECK(queue.pop() == "a");
+    CHECK(queue.pop() == "b");
+    CHECK(queue.empty());
+}
+
+TEST_CASE("SPSC queue drops values when full") {
+    SpscQueue<int, 4> queue;
+    for (int i = 0; i < 4; ++i) {
+        CHECK(queue.push(i));
+    }
+    CHECK_FALSE(queue.push(4));
+    CHECK(queue.pop() == 0);
+    // Popping frees a slot again
+    CHECK(queue.push(5));
+    for (int expected : {1, 2, 3, 5}) {
+        CHECK(queue.pop() == expected);
+    }
+}
+
+TEST_CASE("SPSC queue passes values between threads") {
+    SpscQueue<size_t, 16> queue;
+    constexpr size_t NUM_VALUES = 100'000;
+    std::thread producer([&queue]() {
+        for (size_t i = 0; i < NUM_VALUES; ++i) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    size_t expected = 0;
+    bool in_order = true;
+    while (expected < NUM_VALUES) {
+        if (auto value = queue.pop()) {
+            in_order = in_order && *value == expected;
+            ++expected;
+        }
+    }
+    producer.join();
+    CHECK(in_order);
+    CHECK(queue.empty());
+}
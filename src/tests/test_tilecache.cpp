@@ -0,0 +1,41 @@
+#include "tilecache.hpp"
+#include "memorymap.hpp"
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+
+TEST_CASE("Tile cache decodes tiles") {
+    std::array<uint8_t, memmap::TileDataSize> tile_data{};
+    // Second line of tile 1
+    tile_data[16 + 2] = 0x3C;
+    tile_data[16 + 3] = 0xCC;
+    TileCache cache{tile_data};
+
+    using graphics::gb::UnmappedColorGb;
+    const TileCache::TileLine expected{UnmappedColorGb::Color2, UnmappedColorGb::Color2,
+                                       UnmappedColorGb::Color1, UnmappedColorGb::Color1,
+                                       UnmappedColorGb::Color3, UnmappedColorGb::Color3,
+                                       UnmappedColorGb::Color0, UnmappedColorGb::Color0};
+    CHECK(cache.get_line(1, 1) == expected);
+    CHECK(cache.get_tile(1)[1] == expected);
+
+    SECTION("Mirrored tile is reversed") {
+        TileCache::TileLine expected_mirrored{};
+        std::ranges::reverse_copy(expected, expected_mirrored.begin());
+        CHECK(cache.get_line(1, 1, true) == expected_mirrored);
+        CHECK(cache.get_tile_mirrored(1)[1] == expected_mirrored);
+    }
+
+    SECTION("Tile is only decoded again after invalidation") {
+        tile_data[16 + 2] = 0xFF;
+        tile_data[16 + 3] = 0xFF;
+        CHECK(cache.get_line(1, 1) == expected);
+        cache.invalidate(16 + 3);
+        TileCache::TileLine all_color3{};
+        all_color3.fill(UnmappedColorGb::Color3);
+        CHECK(cache.get_line(1, 1) == all_color3);
+    }
+}
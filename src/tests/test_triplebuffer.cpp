@@ -0,0 +1,62 @@
+#include "triplebuffer.hpp"
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstddef>
+#include <thread>
+
+
+TEST_CASE("Triple buffer passes the newest value to the reader") {
+    TripleBuffer<int> buffer;
+    CHECK_FALSE(buffer.update());
+    CHECK(buffer.front() == 0);
+
+    buffer.back() = 1;
+    buffer.publish();
+    REQUIRE(buffer.update());
+    CHECK(buffer.front() == 1);
+    // Nothing new was published, the reader keeps the last value
+    CHECK_FALSE(buffer.update());
+    CHECK(buffer.front() == 1);
+
+    SECTION("Values not picked up by the reader are replaced") {
+        buffer.back() = 2;
+        buffer.publish();
+        buffer.back() = 3;
+        buffer.publish();
+        REQUIRE(buffer.update());
+        CHECK(buffer.front() == 3);
+        CHECK_FALSE(buffer.update());
+    }
+}
+
+TEST_CASE("Triple buffer never hands out a partially written value") {
+    // Every value is an array filled with one number, a mix of numbers would mean the reader saw a
+    // buffer while it was written.
+    using Value = std::array<size_t, 256>;
+    TripleBuffer<Value> buffer;
+    constexpr size_t NUM_VALUES = 20'000;
+    std::thread writer([&buffer]() {
+        for (size_t i = 1; i <= NUM_VALUES; ++i) {
+            buffer.back().fill(i);
+            buffer.publish();
+        }
+    });
+    size_t last_value = 0;
+    bool consistent = true;
+    bool increasing = true;
+    while (last_value < NUM_VALUES) {
+        if (!buffer.update()) {
+            continue;
+        }
+        const auto& value = buffer.front();
+        for (auto v : value) {
+            consistent = consistent && v == value[0];
+        }
+        increasing = increasing && value[0] > last_value;
+        last_value = value[0];
+    }
+    writer.join();
+    CHECK(consistent);
+    CHECK(increasing);
+}
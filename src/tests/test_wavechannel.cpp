@@ -0,0 +1,95 @@
+#include "wavechannel.hpp"
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace {
+// Wave channel ticked every T cycle like before it was caught up lazily. It only models the
+// waveform, length and DAC are handled the same way by both.
+class PerCycleWaveChannel {
+    std::span<const uint8_t, 16> m_wave_ram;
+    uint16_t m_wavelength = 0;
+    size_t m_timer = 0;
+    uint8_t m_position = 0;
+    uint8_t m_sample_buffer = 0;
+
+    [[nodiscard]] size_t get_period() const {
+        return 2 * (2048 - static_cast<size_t>(m_wavelength));
+    }
+
+public:
+    explicit PerCycleWaveChannel(std::span<const uint8_t, 16> wave_ram) : m_wave_ram(wave_ram) {}
+
+    void trigger(uint16_t wavelength) {
+        m_wavelength = wavelength;
+        m_position = 0;
+        m_timer = get_period();
+    }
+
+    // The new wavelength is used when the timer is reloaded the next time.
+    void set_wavelength(uint16_t wavelength) {
+        m_wavelength = wavelength;
+    }
+
+    void tick() {
+        if (--m_timer > 0) {
+            return;
+        }
+        m_timer = get_period();
+        m_position = (m_position + 1) % 32;
+        m_sample_buffer = m_wave_ram[m_position / 2];
+    }
+
+    // Sample at 100% volume
+    [[nodiscard]] uint8_t get_sample() const {
+        return (m_position % 2 == 0) ? m_sample_buffer >> 4 : m_sample_buffer & 0x0F;
+    }
+};
+
+constexpr uint8_t DAC_ON = 0x80;
+constexpr uint8_t FULL_VOLUME = 0x20;
+constexpr uint8_t TRIGGER = 0x80;
+
+void write_wavelength(WaveChannel& channel, uint16_t wavelength, uint8_t nrx4_flags) {
+    channel.set_nrx3(static_cast<uint8_t>(wavelength & 0xFF));
+    channel.set_nrx4(static_cast<uint8_t>(nrx4_flags | (wavelength >> 8)));
+}
+} // namespace
+
+TEST_CASE("Wave channel caught up lazily matches ticking it every cycle") {
+    const uint16_t wavelength = GENERATE(0, 1000, 1800, 2047);
+    // Cycles between catching up, a sample is compared after every catch up.
+    const size_t interval = GENERATE(1, 4, 97, 1000, 9000);
+    std::array<uint8_t, 16> wave_ram{};
+    for (size_t i = 0; i < wave_ram.size(); ++i) {
+        wave_ram[i] = static_cast<uint8_t>((i * 0x37) + 0x1E);
+    }
+    WaveChannel channel{wave_ram};
+    PerCycleWaveChannel expected{wave_ram};
+    channel.set_nrx0(DAC_ON);
+    channel.set_nrx2(FULL_VOLUME);
+    write_wavelength(channel, wavelength, TRIGGER);
+    expected.trigger(wavelength);
+
+    constexpr size_t NUM_CYCLES = 200'000;
+    size_t cycle = 0;
+    while (cycle < NUM_CYCLES) {
+        for (size_t i = 0; i < interval; ++i) {
+            expected.tick();
+        }
+        cycle += interval;
+        channel.catch_up(cycle);
+        INFO("Cycle " << cycle);
+        REQUIRE(channel.get_sample() == expected.get_sample());
+        // Registers and wave RAM are only written after catching up, like the APU does.
+        if (cycle % 50'000 < interval) {
+            const auto new_wavelength = static_cast<uint16_t>((wavelength + 700) % 2048);
+            write_wavelength(channel, new_wavelength, 0);
+            expected.set_wavelength(new_wavelength);
+            wave_ram[(cycle / interval) % wave_ram.size()] ^= 0xA5;
+        }
+    }
+}